@@ -0,0 +1,127 @@
+#include "Animation.h"
+#include "Bench.h"
+#include "ThreadPool.h"
+#include "VisibilityPass.h"
+
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+     // Function to build the world matrix of one motion the way it is written down: rest rotation and scale,
+     // spin about y, translation to the orbit and bob position and the base frame
+     XMMATRIX ComposeMotion(const Motion& motion, FXMMATRIX rest, CXMMATRIX base, float time)
+     {
+          float orbit = motion.orbitSpeed * time + motion.phase;
+          XMMATRIX translation = XMMatrixTranslation(motion.center.x + motion.orbitRadius * cosf(orbit),
+               motion.center.y + motion.bobAmplitude * sinf(motion.bobSpeed * time + motion.phase),
+               motion.center.z + motion.orbitRadius * sinf(orbit));
+          XMMATRIX local = XMMatrixMultiply(XMMatrixMultiply(rest, XMMatrixRotationY(motion.spinSpeed * time)), translation);
+          return XMMatrixMultiply(local, base);
+     }
+}
+
+// Procedural motion of 1M instances, a fifth of them static and the rest with random mixes of orbit, bob
+// and spin on top of random base frames. A per-instance loop composing XMMatrix products is compared with
+// AnimateTransforms over the SoA on one thread and in VisibilityPass chunks on the pool, results in instances/ms
+void AnimationBench(const BenchSettings& settings)
+{
+     const size_t count = 1 << 20;
+     std::mt19937 rng(24);
+     std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+     std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+     std::uniform_real_distribution<float> amount(0.5f, 2.0f);
+     std::uniform_int_distribution<int> kind(0, 9);
+
+     AnimationsSoA animations;
+     animations.Resize(count);
+     std::vector<Motion> motions(count);
+     std::vector<XMFLOAT4X4> rests(count);
+     std::vector<XMFLOAT4X4> bases(count);
+     for (size_t i = 0; i < count; ++i)
+     {
+          int pick = kind(rng);
+          Motion& motion = motions[i];
+          motion.flags = static_cast<uint8_t>(pick < 2 ? MotionNone : pick - 2 + 1);
+          motion.center = XMFLOAT3(position(rng), position(rng), position(rng));
+          motion.orbitRadius = (motion.flags & MotionOrbit) ? amount(rng) : 0.0f;
+          motion.orbitSpeed = (motion.flags & MotionOrbit) ? amount(rng) : 0.0f;
+          motion.bobAmplitude = (motion.flags & MotionBob) ? amount(rng) : 0.0f;
+          motion.bobSpeed = (motion.flags & MotionBob) ? amount(rng) : 0.0f;
+          motion.spinSpeed = (motion.flags & MotionSpin) ? amount(rng) : 0.0f;
+          motion.phase = angle(rng);
+          XMMATRIX rest = XMMatrixMultiply(XMMatrixScaling(amount(rng), amount(rng), amount(rng)),
+               XMMatrixRotationRollPitchYaw(angle(rng), angle(rng), angle(rng)));
+          XMMATRIX base = XMMatrixMultiply(XMMatrixRotationY(angle(rng)), XMMatrixTranslation(position(rng), 0.0f, position(rng)));
+          XMStoreFloat4x4(&rests[i], rest);
+          XMStoreFloat4x4(&bases[i], base);
+          animations.Set(i, motion, rest);
+          animations.SetBase(i, base);
+     }
+     size_t moving = count - static_cast<size_t>(std::count(animations.flags.begin(), animations.flags.end(), uint8_t(MotionNone)));
+
+     TransformsSoA reference;
+     reference.Resize(count);
+     float time = 1.0f;
+     double composed = BenchRun("XMMatrix products per instance", BenchIterations(settings, 5), [&]()
+          {
+               time += 1.0f / 60;
+               for (size_t i = 0; i < count; ++i)
+               {
+                    if (motions[i].flags != MotionNone)
+                    {
+                         reference.Set(i, ComposeMotion(motions[i], XMLoadFloat4x4(&rests[i]), XMLoadFloat4x4(&bases[i]), time));
+                    }
+               }
+          });
+
+     TransformsSoA transforms;
+     transforms.Resize(count);
+     size_t animated = 0;
+     double single = BenchRun("AnimateTransforms, one thread", BenchIterations(settings, 5), [&]()
+          {
+               animated = AnimateTransforms(animations, time, 0, count, transforms);
+          });
+
+     ThreadPool pool;
+     std::vector<size_t> animatedCounts;
+     char label[64];
+     std::snprintf(label, sizeof(label), "AnimateTransforms, %u threads", pool.GetThreadCount());
+     double parallel = BenchRun(label, BenchIterations(settings, 5), [&]()
+          {
+               animatedCounts.assign(pool.GetThreadCount(), 0);
+               size_t chunkCount = (count + VisibilityPass::chunkSize - 1) / VisibilityPass::chunkSize;
+               pool.ParallelFor(chunkCount, [&](size_t chunk, unsigned thread)
+                    {
+                         size_t begin = chunk * VisibilityPass::chunkSize;
+                         size_t end = std::min(begin + VisibilityPass::chunkSize, count);
+                         animatedCounts[thread] += AnimateTransforms(animations, time, begin, end, transforms);
+                    });
+          });
+
+     float maxError = 0.0f;
+     for (size_t i = 0; i < count; ++i)
+     {
+          if (motions[i].flags == MotionNone)
+          {
+               continue;
+          }
+          for (int r = 0; r < 4; r++)
+          {
+               for (int c = 0; c < 3; c++)
+               {
+                    maxError = std::max(maxError, fabsf(reference.m[r][c][i] - transforms.m[r][c][i]));
+               }
+          }
+     }
+     std::printf("  %zu of %zu instances moving, %zu animated on one thread and %zu on the pool, max difference %.2g\n", moving,
+          count, animated, std::accumulate(animatedCounts.begin(), animatedCounts.end(), size_t(0)), maxError);
+     std::printf("  per instance %.0f, SoA %.0f, SoA on the pool %.0f instances/ms\n", moving / composed, moving / single,
+          moving / parallel);
+}
@@ -0,0 +1,90 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+     struct BenchCase
+     {
+          const char* name;
+          void (*run)(const BenchSettings& settings);
+     };
+
+     const BenchCase benches[] = {
+          { "animation", AnimationBench },
+          { "bounds", BoundsBench },
+          { "bvh", BvhBench },
+          { "churn", ChurnBench },
+          { "compact", CompactBench },
+          { "contribution", ContributionBench },
+          { "entity", EntityBench },
+          { "frustum", FrustumBench },
+          { "hierarchy", HierarchyBench },
+          { "lod", LodBench },
+          { "material", MaterialBench },
+          { "morton", MortonBench },
+          { "multifrustum", MultiFrustumBench },
+          { "occlusion", OcclusionBench },
+          { "pack", PackBench },
+          { "planecache", PlaneCacheBench },
+          { "portal", PortalBench },
+          { "pvs", PvsBench },
+          { "scaling", ScalingBench },
+          { "sort", SortBench },
+          { "tree", TreeBench },
+     };
+}
+
+// Usage: labbench [--quick] [--moving fraction] [name...], runs all benchmarks when no name is given
+int main(int argc, char** argv)
+{
+     BenchSettings settings;
+     std::vector<const char*> names;
+     for (int i = 1; i < argc; i++)
+     {
+          if (std::strcmp(argv[i], "--quick") == 0)
+          {
+               settings.quick = true;
+          }
+          else if (std::strcmp(argv[i], "--moving") == 0 && i + 1 < argc)
+          {
+               settings.moving = std::min(std::max(static_cast<float>(std::atof(argv[++i])), 0.0f), 1.0f);
+          }
+          else
+          {
+               names.push_back(argv[i]);
+          }
+     }
+     int selected = static_cast<int>(names.size());
+
+     int ran = 0;
+     for (const BenchCase& bench : benches)
+     {
+          bool run = selected == 0;
+          for (const char* name : names)
+          {
+               run = run || std::strcmp(name, bench.name) == 0;
+          }
+          if (run)
+          {
+               std::printf("%s\n", bench.name);
+               bench.run(settings);
+               ++ran;
+          }
+     }
+
+     if (ran < (selected ? selected : 1))
+     {
+          std::printf("unknown benchmark, available:");
+          for (const BenchCase& bench : benches)
+          {
+               std::printf(" %s", bench.name);
+          }
+          std::printf("\n");
+          return 1;
+     }
+     return 0;
+}
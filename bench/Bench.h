@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <stddef.h>
+
+// Settings shared by all benchmarks, quick runs every measurement once to check that it works
+struct BenchSettings
+{
+     bool quick = false;
+     // Part of the instances moved every frame by benchmarks of moving scenes, set with --moving
+     float moving = 0.1f;
+};
+
+inline size_t BenchIterations(const BenchSettings& settings, size_t iterations)
+{
+     return settings.quick ? 1 : iterations;
+}
+
+// Function to run fn once to warm up and then iterations times, prints and returns average milliseconds per run
+template <typename Fn>
+double BenchRun(const char* label, size_t iterations, Fn&& fn)
+{
+     fn();
+     auto start = std::chrono::steady_clock::now();
+     for (size_t i = 0; i < iterations; ++i)
+     {
+          fn();
+     }
+     std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+     double average = elapsed.count() / iterations;
+     std::printf("  %-44s %10.4f ms\n", label, average);
+     return average;
+}
+
+void AnimationBench(const BenchSettings& settings);
+void BoundsBench(const BenchSettings& settings);
+void BvhBench(const BenchSettings& settings);
+void ChurnBench(const BenchSettings& settings);
+void CompactBench(const BenchSettings& settings);
+void ContributionBench(const BenchSettings& settings);
+void EntityBench(const BenchSettings& settings);
+void FrustumBench(const BenchSettings& settings);
+void HierarchyBench(const BenchSettings& settings);
+void LodBench(const BenchSettings& settings);
+void MaterialBench(const BenchSettings& settings);
+void MortonBench(const BenchSettings& settings);
+void MultiFrustumBench(const BenchSettings& settings);
+void OcclusionBench(const BenchSettings& settings);
+void PackBench(const BenchSettings& settings);
+void PlaneCacheBench(const BenchSettings& settings);
+void PortalBench(const BenchSettings& settings);
+void PvsBench(const BenchSettings& settings);
+void ScalingBench(const BenchSettings& settings);
+void SortBench(const BenchSettings& settings);
+void TreeBench(const BenchSettings& settings);
@@ -0,0 +1,76 @@
+#include "Bench.h"
+#include "Transforms.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+// World boxes of 1M rotated and scaled transforms. UpdateWorldBounds over the SoA transforms is compared
+// with loading every matrix and transforming the eight corners of the local box
+void BoundsBench(const BenchSettings& settings)
+{
+     const size_t count = 1 << 20;
+     std::mt19937 rng(9);
+     std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+     std::uniform_real_distribution<float> scale(0.1f, 4.0f);
+     std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+     TransformsSoA transforms;
+     transforms.Resize(count);
+     for (size_t i = 0; i < count; ++i)
+     {
+          XMMATRIX scaleRotation = XMMatrixMultiply(XMMatrixScaling(scale(rng), scale(rng), scale(rng)),
+               XMMatrixRotationRollPitchYaw(angle(rng), angle(rng), angle(rng)));
+          transforms.Set(i, XMMatrixMultiply(scaleRotation, XMMatrixTranslation(position(rng), position(rng), position(rng))));
+     }
+     const XMFLOAT3 localCenter(0.0f, 0.0f, 0.0f);
+     const XMFLOAT3 localExtent(0.5f, 0.5f, 0.5f);
+
+     BoundsSoA bounds;
+     std::vector<uint32_t> updated;
+     updated.reserve(count);
+     double soa = BenchRun("UpdateWorldBounds, all dirty", BenchIterations(settings, 20), [&]()
+          {
+               std::fill(transforms.dirty.begin(), transforms.dirty.end(), uint8_t(1));
+               updated.clear();
+               UpdateWorldBounds(transforms, localCenter, localExtent, bounds, updated);
+          });
+
+     BoundsSoA corners;
+     corners.Resize(count);
+     double perCorner = BenchRun("matrix load and 8 corner transforms", BenchIterations(settings, 20), [&]()
+          {
+               for (size_t i = 0; i < count; ++i)
+               {
+                    XMMATRIX world = transforms.Get(i);
+                    XMVECTOR boxMin = XMVectorReplicate(INFINITY);
+                    XMVECTOR boxMax = XMVectorReplicate(-INFINITY);
+                    for (int corner = 0; corner < 8; corner++)
+                    {
+                         XMVECTOR point = XMVectorSet(
+                              localCenter.x + ((corner & 1) ? localExtent.x : -localExtent.x),
+                              localCenter.y + ((corner & 2) ? localExtent.y : -localExtent.y),
+                              localCenter.z + ((corner & 4) ? localExtent.z : -localExtent.z), 1.0f);
+                         point = XMVector3Transform(point, world);
+                         boxMin = XMVectorMin(boxMin, point);
+                         boxMax = XMVectorMax(boxMax, point);
+                    }
+                    XMFLOAT3 center;
+                    XMFLOAT3 extent;
+                    XMStoreFloat3(&center, XMVectorScale(XMVectorAdd(boxMin, boxMax), 0.5f));
+                    XMStoreFloat3(&extent, XMVectorScale(XMVectorSubtract(boxMax, boxMin), 0.5f));
+                    corners.Set(i, center, extent);
+               }
+          });
+
+     float maxError = 0.0f;
+     for (size_t i = 0; i < count; ++i)
+     {
+          maxError = std::max(maxError, std::fabs(bounds.extentX[i] - corners.extentX[i]));
+          maxError = std::max(maxError, std::fabs(bounds.centerX[i] - corners.centerX[i]));
+     }
+     std::printf("  %zu bounds, %.2f ns per transform, %.1fx faster, max difference %g\n", updated.size(), soa * 1e6 / count,
+          perCorner / soa, maxError);
+}
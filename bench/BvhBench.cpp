@@ -0,0 +1,68 @@
+#include "BVH.h"
+#include "Bench.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Static scenes of 10K, 100K and 1M boxes filling a cube around the camera, about a tenth in the view.
+// Building the hierarchy is paid once at load, culling through it each frame is compared with
+// CheckAABBBatch over every box
+void BvhBench(const BenchSettings& settings)
+{
+     XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f);
+     Frustum frustum;
+     frustum.Init(0.1f);
+     frustum.ConstructFrustum(view, proj);
+
+     for (size_t count : { size_t(10000), size_t(100000), size_t(1000000) })
+     {
+          std::mt19937 rng(3);
+          std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+          std::uniform_real_distribution<float> size(0.1f, 2.0f);
+          BoundsSoA bounds;
+          bounds.Resize(count);
+          for (size_t i = 0; i < count; ++i)
+          {
+               bounds.Set(i, XMFLOAT3(position(rng), position(rng), position(rng)), XMFLOAT3(size(rng), size(rng), size(rng)));
+          }
+          std::vector<uint32_t> ids(count);
+          std::iota(ids.begin(), ids.end(), 0);
+
+          std::printf("  %zu boxes\n", count);
+          BVH bvh;
+          BenchRun("BVH build", BenchIterations(settings, 5), [&]()
+               {
+                    bvh.Build(bounds, ids.data(), count);
+               });
+
+          std::vector<uint32_t> visible;
+          double hierarchy = BenchRun("BVH cull", BenchIterations(settings, 50), [&]()
+               {
+                    visible.clear();
+                    bvh.Cull(frustum, visible);
+               });
+
+          std::vector<uint8_t> batch(count);
+          double linear = BenchRun("CheckAABBBatch over every box", BenchIterations(settings, 50), [&]()
+               {
+                    frustum.CheckAABBBatch(bounds.centerX.data(), bounds.centerY.data(), bounds.centerZ.data(),
+                         bounds.extentX.data(), bounds.extentY.data(), bounds.extentZ.data(), count, batch.data());
+               });
+
+          std::vector<uint8_t> culled(count, 0);
+          for (uint32_t id : visible)
+          {
+               culled[id] = 1;
+          }
+          size_t differences = 0;
+          for (size_t i = 0; i < count; ++i)
+          {
+               differences += culled[i] != batch[i];
+          }
+          std::printf("  %zu visible, %zu nodes, %.1fx faster than CheckAABBBatch, %zu results differ\n", visible.size(),
+               bvh.GetNodeCount(), linear / hierarchy, differences);
+     }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+// Hardware cache misses of the calling thread. Counting needs perf events, so it is only available
+// on Linux when the kernel lets the user open them (see perf_event_paranoid)
+class CacheMissCounter
+{
+public:
+     CacheMissCounter()
+     {
+#ifdef __linux__
+          perf_event_attr attr;
+          std::memset(&attr, 0, sizeof(attr));
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.size = sizeof(attr);
+          attr.config = PERF_COUNT_HW_CACHE_MISSES;
+          attr.disabled = 1;
+          attr.exclude_kernel = 1;
+          attr.exclude_hv = 1;
+          fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+     }
+
+     ~CacheMissCounter()
+     {
+#ifdef __linux__
+          if (fd >= 0)
+          {
+               close(fd);
+          }
+#endif
+     }
+
+     CacheMissCounter(const CacheMissCounter&) = delete;
+     CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+     bool IsAvailable() const { return fd >= 0; }
+
+     void Start()
+     {
+#ifdef __linux__
+          if (fd >= 0)
+          {
+               ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+               ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+          }
+#endif
+     }
+
+     // Function to stop counting, returns misses since Start or 0 when not available
+     uint64_t Stop()
+     {
+          uint64_t count = 0;
+#ifdef __linux__
+          if (fd >= 0)
+          {
+               ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+               if (read(fd, &count, sizeof(count)) != sizeof(count))
+               {
+                    count = 0;
+               }
+          }
+#endif
+          return count;
+     }
+private:
+     int fd = -1;
+};
@@ -0,0 +1,66 @@
+#include "Bench.h"
+#include "DemoScene.h"
+
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+// Scene of 1M instances where every frame removes a random tenth of them and adds as many new ones.
+// Only --quick runs it on 64K instances, the numbers are meant for the full scene
+void ChurnBench(const BenchSettings& settings)
+{
+     const size_t fullCount = 1 << 20;
+     const size_t quickCount = 1 << 16;
+     const size_t count = settings.quick ? quickCount : fullCount;
+     const size_t churn = count / 10;
+     const float range = 400.0f;
+     std::mt19937 rng(17);
+     std::uniform_real_distribution<float> position(-range, range);
+     auto randomWorld = [&]() { return XMMatrixTranslation(position(rng), position(rng), position(rng)); };
+
+     Scene scene;
+     scene.Init(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f), BuildCubeLodChain(), InstanceBatcher::maxPageSize);
+     std::vector<InstanceHandle> handles;
+     for (size_t i = 0; i < count; ++i)
+     {
+          handles.push_back(scene.AddInstance(randomWorld(), 0));
+     }
+     scene.Build();
+
+     XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, Scene::maxDrawDistance, 0.1f);
+     XMFLOAT3 pov(0.0f, 0.0f, 0.0f);
+     scene.Update(0.0f, view, proj, pov, 1, 720);
+
+     // Removed handles are taken from random places of the list, swap and pop keeps it dense.
+     size_t iterations = BenchIterations(settings, 10);
+     double churnTime = BenchRun("remove and add 10% of instances", iterations, [&]()
+          {
+               for (size_t i = 0; i < churn; ++i)
+               {
+                    size_t pick = std::uniform_int_distribution<size_t>(0, handles.size() - 1)(rng);
+                    scene.RemoveInstance(handles[pick]);
+                    handles[pick] = handles.back();
+                    handles.pop_back();
+               }
+               for (size_t i = 0; i < churn; ++i)
+               {
+                    handles.push_back(scene.AddInstance(randomWorld(), 0));
+               }
+          });
+     double updateTime = BenchRun("update after churn", iterations, [&]()
+          {
+               for (size_t i = 0; i < churn; ++i)
+               {
+                    size_t pick = std::uniform_int_distribution<size_t>(0, handles.size() - 1)(rng);
+                    scene.RemoveInstance(handles[pick]);
+                    handles[pick] = scene.AddInstance(randomWorld(), 0);
+               }
+               scene.Update(0.0f, view, proj, pov, 1, 720);
+          });
+
+     std::printf("  %zu instances%s, %zu removed and added per frame, %.1f ns per change, %zu drawn\n", scene.GetInstances().Size(),
+          settings.quick ? " (--quick, run without it for 1M)" : "", churn, churnTime * 1e6 / (2 * churn), scene.GetCullingStats().drawn);
+     std::printf("  churn with update %.4f ms per frame\n", updateTime);
+}
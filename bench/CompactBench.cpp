@@ -0,0 +1,54 @@
+#include "Bench.h"
+#include "Bitset.h"
+
+#include <DirectXMath.h>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+// Visible ids of 1M instances written the old way, one XMINT4 per id, and by compacting the visibility bitset
+void CompactBench(const BenchSettings& settings)
+{
+     const size_t count = 1 << 20;
+     std::mt19937 rng(2);
+     for (float density : { 0.1f, 0.5f, 0.9f })
+     {
+          std::bernoulli_distribution visibleDist(density);
+          std::vector<uint8_t> visible(count);
+          Bitset bitset;
+          bitset.Resize(count);
+          for (size_t i = 0; i < count; ++i)
+          {
+               visible[i] = visibleDist(rng) ? 1 : 0;
+               if (visible[i])
+               {
+                    bitset.Set(i);
+               }
+          }
+          std::printf("  %.0f%% visible\n", density * 100.0f);
+
+          std::vector<XMINT4> ids;
+          double loop = BenchRun("push_back XMINT4 per visible instance", BenchIterations(settings, 50), [&]()
+               {
+                    ids.clear();
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                         if (visible[i])
+                         {
+                              ids.push_back(XMINT4(static_cast<int32_t>(i), 0, 0, 0));
+                         }
+                    }
+               });
+
+          std::vector<uint32_t> packed(count + 3);
+          size_t packedCount = 0;
+          double compact = BenchRun("CompactBitset into packed uint32 ids", BenchIterations(settings, 50), [&]()
+               {
+                    packedCount = CompactBitset(bitset, packed.data());
+               });
+
+          std::printf("  %zu ids: %zu bytes vs %zu bytes, %.3f vs %.3f ns per instance\n", packedCount,
+               ids.size() * sizeof(XMINT4), packedCount * sizeof(uint32_t), loop * 1e6 / count, compact * 1e6 / count);
+     }
+}
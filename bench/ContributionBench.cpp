@@ -0,0 +1,66 @@
+#include "Bench.h"
+#include "ContributionCuller.h"
+#include "Frustum.h"
+
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Long field of 1M unit boxes stretching 1000 units ahead of the camera, frustum culled first
+// and then culled by pixel area and by a max draw distance of 100 as in the renderer
+void ContributionBench(const BenchSettings& settings)
+{
+     const size_t count = 1 << 20;
+     std::mt19937 rng(3);
+     std::uniform_real_distribution<float> depth(1.0f, 1000.0f);
+     std::uniform_real_distribution<float> side(-1.0f, 1.0f);
+     BoundsSoA bounds;
+     bounds.Resize(count);
+     for (size_t i = 0; i < count; ++i)
+     {
+          float z = depth(rng);
+          bounds.Set(i, XMFLOAT3(side(rng) * 1.5f * z, side(rng) * 0.5f * z, z), XMFLOAT3(0.5f, 0.5f, 0.5f));
+     }
+     std::vector<uint32_t> ids(count);
+     std::iota(ids.begin(), ids.end(), 0);
+
+     XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 2000.0f, 0.1f);
+     Frustum frustum;
+     frustum.Init(0.1f);
+     frustum.ConstructFrustum(view, proj);
+     std::vector<uint8_t> inFrustum(count);
+     frustum.CheckAABBBatch(bounds, ids.data(), count, inFrustum.data());
+     size_t frustumCount = std::accumulate(inFrustum.begin(), inFrustum.end(), size_t(0));
+     std::printf("  %zu of %zu boxes in frustum\n", frustumCount, count);
+
+     std::vector<float> unlimited(count, 1e30f);
+     std::vector<float> limited(count, 100.0f);
+     struct Case
+     {
+          const char* label;
+          float minPixelArea;
+          const std::vector<float>* maxDistance;
+     };
+     const Case cases[] = {
+          { "no contribution culling", 0.0f, &unlimited },
+          { "min pixel area 4", 4.0f, &unlimited },
+          { "max draw distance 100", 0.0f, &limited },
+          { "min pixel area 4 and max distance 100", 4.0f, &limited },
+     };
+
+     ContributionCuller culler;
+     std::vector<uint8_t> visible(count);
+     for (const Case& test : cases)
+     {
+          culler.Init(test.minPixelArea);
+          culler.Setup(XMFLOAT3(0.0f, 0.0f, 0.0f), proj, 1080);
+          BenchRun(test.label, BenchIterations(settings, 50), [&]()
+               {
+                    visible = inFrustum;
+                    culler.Cull(bounds, test.maxDistance->data(), 0, count, visible.data());
+               });
+          size_t drawn = std::accumulate(visible.begin(), visible.end(), size_t(0));
+          std::printf("  %zu drawn, %zu dropped\n", drawn, frustumCount - drawn);
+     }
+}
@@ -0,0 +1,115 @@
+#include "Bench.h"
+#include "EntityStore.h"
+
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+     // Entity with storage for every component, the layout before archetypes
+     struct AosEntity
+     {
+          uint32_t mask;
+          TransformComponent transform;
+          BoundsComponent bounds;
+          MeshComponent mesh;
+          MaterialComponent material;
+          TransparencyComponent transparency;
+     };
+}
+
+// 1M entities, every eighth one transparent. Two systems run over both layouts: the transparent pass picks
+// entities with transparency and measures their distance to the camera like Transparent::Render, the bounds
+// pass moves the bound centers of all entities to their translations
+void EntityBench(const BenchSettings& settings)
+{
+     const size_t count = 1 << 20;
+     const uint32_t opaqueMask = TransformComponent::bit | BoundsComponent::bit | MeshComponent::bit | MaterialComponent::bit;
+     const uint32_t transparentMask = opaqueMask | TransparencyComponent::bit;
+     std::mt19937 rng(21);
+     std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+
+     EntityStore store;
+     std::vector<AosEntity> aos(count);
+     for (size_t i = 0; i < count; ++i)
+     {
+          uint32_t mask = i % 8 == 0 ? transparentMask : opaqueMask;
+          XMFLOAT4X3 world;
+          XMStoreFloat4x3(&world, XMMatrixTranslation(position(rng), position(rng), position(rng)));
+          Entity entity = store.Create(mask);
+          store.Get<TransformComponent>(entity)->world = world;
+          store.Get<BoundsComponent>(entity)->extent = XMFLOAT3(0.5f, 0.5f, 0.5f);
+          aos[i] = AosEntity();
+          aos[i].mask = mask;
+          aos[i].transform.world = world;
+          aos[i].bounds.extent = XMFLOAT3(0.5f, 0.5f, 0.5f);
+          if (mask == transparentMask)
+          {
+               store.Get<TransparencyComponent>(entity)->color = XMFLOAT4(1.0f, 1.0f, 1.0f, 0.5f);
+               aos[i].transparency.color = XMFLOAT4(1.0f, 1.0f, 1.0f, 0.5f);
+          }
+     }
+     std::printf("  %zu entities, %zu bytes per AoS entity\n", store.Size(), sizeof(AosEntity));
+
+     const uint32_t boundsMask = TransformComponent::bit | BoundsComponent::bit;
+     double aosBounds = BenchRun("AoS bounds pass", BenchIterations(settings, 20), [&]()
+          {
+               for (AosEntity& entity : aos)
+               {
+                    if ((entity.mask & boundsMask) == boundsMask)
+                    {
+                         entity.bounds.center = XMFLOAT3(entity.transform.world._41, entity.transform.world._42, entity.transform.world._43);
+                    }
+               }
+          });
+     double chunkBounds = BenchRun("archetype bounds pass", BenchIterations(settings, 20), [&]()
+          {
+               store.ForEachChunk(boundsMask, [](const EntityChunk& chunk)
+                    {
+                         const TransformComponent* transforms = chunk.Get<TransformComponent>();
+                         BoundsComponent* bounds = chunk.Get<BoundsComponent>();
+                         for (size_t row = 0; row < chunk.count; ++row)
+                         {
+                              bounds[row].center = XMFLOAT3(transforms[row].world._41, transforms[row].world._42, transforms[row].world._43);
+                         }
+                    });
+          });
+     std::printf("  %.1fx faster\n", aosBounds / chunkBounds);
+
+     const XMFLOAT3 camera(0.0f, 0.0f, -50.0f);
+     float aosSum = 0.0f;
+     double aosTransparent = BenchRun("AoS transparent pass", BenchIterations(settings, 20), [&]()
+          {
+               aosSum = 0.0f;
+               for (const AosEntity& entity : aos)
+               {
+                    if ((entity.mask & transparentMask) == transparentMask)
+                    {
+                         float dx = entity.bounds.center.x - camera.x;
+                         float dy = entity.bounds.center.y - camera.y;
+                         float dz = entity.bounds.center.z - camera.z;
+                         aosSum += (dx * dx + dy * dy + dz * dz) * entity.transparency.color.w;
+                    }
+               }
+          });
+     float chunkSum = 0.0f;
+     double chunkTransparent = BenchRun("archetype transparent pass", BenchIterations(settings, 20), [&]()
+          {
+               chunkSum = 0.0f;
+               store.ForEachChunk(transparentMask, [&](const EntityChunk& chunk)
+                    {
+                         const BoundsComponent* bounds = chunk.Get<BoundsComponent>();
+                         const TransparencyComponent* transparencies = chunk.Get<TransparencyComponent>();
+                         for (size_t row = 0; row < chunk.count; ++row)
+                         {
+                              float dx = bounds[row].center.x - camera.x;
+                              float dy = bounds[row].center.y - camera.y;
+                              float dz = bounds[row].center.z - camera.z;
+                              chunkSum += (dx * dx + dy * dy + dz * dz) * transparencies[row].color.w;
+                         }
+                    });
+          });
+     std::printf("  %.1fx faster, sums %g and %g\n", aosTransparent / chunkTransparent, aosSum, chunkSum);
+}
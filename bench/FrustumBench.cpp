@@ -0,0 +1,79 @@
+#include "Bench.h"
+#include "Frustum.h"
+
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace
+{
+     size_t CountDifferences(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+     {
+          size_t differences = 0;
+          for (size_t i = 0; i < a.size(); ++i)
+          {
+               differences += a[i] != b[i];
+          }
+          return differences;
+     }
+}
+
+// 1M boxes of random size scattered around the camera, about a tenth of them in the view, tested against
+// the planes ConstructFrustum builds. CheckAABBBatch over the SoA bounds is compared with a CheckRectangle
+// loop, the way Renderer::Update culled before, and the tri-state CheckAABB with the same loop
+void FrustumBench(const BenchSettings& settings)
+{
+     const size_t count = 1 << 20;
+     std::mt19937 rng(1);
+     std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+     std::uniform_real_distribution<float> size(0.1f, 2.0f);
+     BoundsSoA bounds;
+     bounds.Resize(count);
+     for (size_t i = 0; i < count; ++i)
+     {
+          bounds.Set(i, XMFLOAT3(position(rng), position(rng), position(rng)), XMFLOAT3(size(rng), size(rng), size(rng)));
+     }
+
+     XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f);
+     Frustum frustum;
+     frustum.Init(0.1f);
+     frustum.ConstructFrustum(view, proj);
+
+     std::vector<uint8_t> scalar(count);
+     double rectangle = BenchRun("CheckRectangle per box", BenchIterations(settings, 20), [&]()
+          {
+               for (size_t i = 0; i < count; ++i)
+               {
+                    scalar[i] = frustum.CheckRectangle(bounds.centerX[i] + bounds.extentX[i], bounds.centerY[i] + bounds.extentY[i],
+                         bounds.centerZ[i] + bounds.extentZ[i], bounds.centerX[i] - bounds.extentX[i], bounds.centerY[i] - bounds.extentY[i],
+                         bounds.centerZ[i] - bounds.extentZ[i]);
+               }
+          });
+
+     std::vector<uint8_t> batch(count);
+     double batched = BenchRun("CheckAABBBatch", BenchIterations(settings, 20), [&]()
+          {
+               frustum.CheckAABBBatch(bounds.centerX.data(), bounds.centerY.data(), bounds.centerZ.data(),
+                    bounds.extentX.data(), bounds.extentY.data(), bounds.extentZ.data(), count, batch.data());
+          });
+     size_t visible = std::accumulate(batch.begin(), batch.end(), size_t(0));
+     std::printf("  %zu of %zu boxes visible, %.2f ns per box, %.1fx faster, %zu results differ\n", visible, count,
+          batched * 1e6 / count, rectangle / batched, CountDifferences(batch, scalar));
+
+     std::vector<uint8_t> classified(count);
+     size_t inside = 0;
+     double centerExtent = BenchRun("CheckAABB center/extent per box", BenchIterations(settings, 20), [&]()
+          {
+               inside = 0;
+               for (size_t i = 0; i < count; ++i)
+               {
+                    FrustumTest result = frustum.CheckAABB(XMFLOAT3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]),
+                         XMFLOAT3(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]));
+                    classified[i] = result != FrustumTest::Outside;
+                    inside += result == FrustumTest::Inside;
+               }
+          });
+     std::printf("  %zu fully inside, %.2f ns per box, %.1fx faster than CheckRectangle, %zu results differ\n", inside,
+          centerExtent * 1e6 / count, rectangle / centerExtent, CountDifferences(classified, scalar));
+}
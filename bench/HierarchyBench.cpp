@@ -0,0 +1,140 @@
+#include "Bench.h"
+#include "SceneGraph.h"
+#include "ThreadPool.h"
+
+#include <DirectXMath.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+     struct Hierarchy
+     {
+          const char* name;
+          SceneGraph graph;
+          std::vector<uint32_t> nodes;
+     };
+
+     XMMATRIX RandomLocal(std::mt19937& rng)
+     {
+          std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+          std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+          return XMMatrixMultiply(XMMatrixRotationRollPitchYaw(angle(rng), angle(rng), angle(rng)),
+               XMMatrixTranslation(offset(rng), offset(rng), offset(rng)));
+     }
+
+     // Function to add roots with chains of depth nodes under each of them
+     void BuildDeep(Hierarchy& hierarchy, size_t roots, size_t depth, std::mt19937& rng)
+     {
+          for (size_t root = 0; root < roots; ++root)
+          {
+               uint32_t parent = SceneGraph::noParent;
+               for (size_t level = 0; level < depth; ++level)
+               {
+                    parent = hierarchy.graph.AddNode(parent, RandomLocal(rng));
+                    hierarchy.nodes.push_back(parent);
+               }
+          }
+     }
+
+     // Function to add roots with children directly under them
+     void BuildWide(Hierarchy& hierarchy, size_t roots, size_t children, std::mt19937& rng)
+     {
+          for (size_t root = 0; root < roots; ++root)
+          {
+               uint32_t parent = hierarchy.graph.AddNode(SceneGraph::noParent, RandomLocal(rng));
+               hierarchy.nodes.push_back(parent);
+               for (size_t child = 0; child < children; ++child)
+               {
+                    hierarchy.nodes.push_back(hierarchy.graph.AddNode(parent, RandomLocal(rng)));
+               }
+          }
+     }
+
+     // Function to move the same --moving part of the nodes every frame and update the graph. Time of SetLocal
+     // alone is measured first and taken off, returns average milliseconds of Update
+     double RunFrames(const char* label, const BenchSettings& settings, Hierarchy& hierarchy, ThreadPool& pool, size_t& updatedPerFrame)
+     {
+          std::mt19937 rng(20);
+          std::vector<uint32_t> moved(static_cast<size_t>(hierarchy.nodes.size() * settings.moving));
+          std::uniform_int_distribution<size_t> pick(0, hierarchy.nodes.size() - 1);
+          for (uint32_t& node : moved)
+          {
+               node = hierarchy.nodes[pick(rng)];
+          }
+          XMMATRIX locals[2] = { RandomLocal(rng), RandomLocal(rng) };
+
+          auto move = [&]()
+               {
+                    for (size_t i = 0; i < moved.size(); ++i)
+                    {
+                         hierarchy.graph.SetLocal(moved[i], locals[i & 1]);
+                    }
+               };
+          std::vector<uint32_t> updated;
+          double setTime = BenchRun("  SetLocal", BenchIterations(settings, 10), [&]()
+               {
+                    move();
+               });
+          updated.clear();
+          hierarchy.graph.Update(pool, updated);
+
+          size_t frames = 0;
+          size_t total = 0;
+          double time = BenchRun(label, BenchIterations(settings, 10), [&]()
+               {
+                    move();
+                    updated.clear();
+                    total += hierarchy.graph.Update(pool, updated);
+                    ++frames;
+               });
+          updatedPerFrame = total / frames;
+          return std::max(time - setTime, 1e-6);
+     }
+}
+
+// Deep hierarchy of 4096 chains 64 nodes long and wide one of 16 roots with 16K children each, 256K nodes in both.
+// Every frame --moving of the nodes get new local transforms and Update recomputes them with their descendants.
+// The wide hierarchy is also run with other parallel splits than SceneGraph::parallelWidth and chunkSize
+void HierarchyBench(const BenchSettings& settings)
+{
+     std::mt19937 rng(20);
+     Hierarchy deep;
+     deep.name = "deep";
+     BuildDeep(deep, 4096, 64, rng);
+     Hierarchy wide;
+     wide.name = "wide";
+     BuildWide(wide, 16, 16383, rng);
+
+     ThreadPool pool;
+     std::vector<uint32_t> updated;
+     for (Hierarchy* hierarchy : { &deep, &wide })
+     {
+          hierarchy->graph.Update(pool, updated);
+          size_t perFrame = 0;
+          char label[64];
+          std::snprintf(label, sizeof(label), "%s, %zu levels, SetLocal and Update", hierarchy->name, hierarchy->graph.GetLevelCount());
+          double time = RunFrames(label, settings, *hierarchy, pool, perFrame);
+          std::printf("  %zu of %zu matrices updated per frame, Update %.4f ms, %.0f matrices/ms\n", perFrame,
+               hierarchy->graph.Size(), time, perFrame / time);
+     }
+
+     std::printf("  wide with %u threads:\n", pool.GetThreadCount());
+     const size_t chunks[] = { 512, SceneGraph::chunkSize, 8192, 65536 };
+     for (size_t chunk : chunks)
+     {
+          wide.graph.SetParallelSplit(std::max(chunk, SceneGraph::parallelWidth), chunk);
+          size_t perFrame = 0;
+          char label[64];
+          std::snprintf(label, sizeof(label), "chunks of %zu, SetLocal and Update", chunk);
+          double time = RunFrames(label, settings, wide, pool, perFrame);
+          std::printf("  Update %.4f ms, %.0f matrices/ms\n", time, perFrame / time);
+     }
+     wide.graph.SetParallelSplit(static_cast<size_t>(-1), SceneGraph::chunkSize);
+     size_t perFrame = 0;
+     double serial = RunFrames("serial, SetLocal and Update", settings, wide, pool, perFrame);
+     std::printf("  Update %.4f ms, %.0f matrices/ms\n", serial, perFrame / serial);
+}
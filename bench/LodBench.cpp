@@ -0,0 +1,57 @@
+#include "Bench.h"
+#include "DemoScene.h"
+
+#include <cmath>
+#include <random>
+
+using namespace DirectX;
+
+// Triangles submitted for a large field of cubes flown over by the camera, with the cube LOD chain
+// and with the most detailed level only
+void LodBench(const BenchSettings& settings)
+{
+     const size_t count = settings.quick ? 1 << 16 : 1 << 20;
+     const float range = 500.0f;
+     std::mt19937 rng(22);
+     std::uniform_real_distribution<float> position(-range, range);
+     std::uniform_real_distribution<float> height(0.0f, 4.0f);
+
+     Scene scene;
+     scene.Init(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f), BuildCubeLodChain(), InstanceBatcher::maxPageSize);
+     for (size_t i = 0; i < count; ++i)
+     {
+          scene.AddInstance(XMMatrixTranslation(position(rng), height(rng), position(rng)), 0);
+     }
+     scene.Build();
+
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, Scene::maxDrawDistance, 0.1f);
+     const size_t frames = settings.quick ? 4 : 60;
+     size_t triangles = 0;
+     size_t trianglesWithoutLod = 0;
+     size_t drawn = 0;
+     size_t drawCalls = 0;
+     double pathTime = BenchRun("update along the path", 1, [&]()
+          {
+               triangles = trianglesWithoutLod = drawn = drawCalls = 0;
+               for (size_t frame = 0; frame < frames; ++frame)
+               {
+                    // Low flight over the field, turning slowly.
+                    float t = static_cast<float>(frame) / frames;
+                    XMFLOAT3 eye(-200.0f + 400.0f * t, 6.0f, -100.0f + 50.0f * t);
+                    XMFLOAT3 target(eye.x + std::cos(t * XM_PI), 5.5f, eye.z + std::sin(t * XM_PI) + 1.0f);
+                    XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&target), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+                    scene.Update(0.0f, view, proj, eye, frame + 1, 1080);
+
+                    const CullingStats& stats = scene.GetCullingStats();
+                    triangles += stats.triangles;
+                    trianglesWithoutLod += stats.trianglesWithoutLod;
+                    drawn += stats.drawn;
+                    drawCalls += stats.drawCalls;
+               }
+          });
+
+     std::printf("  %zu instances, %.4f ms, %zu drawn and %zu draw calls per frame\n", count, pathTime / frames, drawn / frames,
+          drawCalls / frames);
+     std::printf("  triangles per frame: %zu with LOD, %zu without, %.1f%%\n", triangles / frames, trianglesWithoutLod / frames,
+          trianglesWithoutLod ? 100.0 * triangles / trianglesWithoutLod : 0.0);
+}
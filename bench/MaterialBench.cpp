@@ -0,0 +1,74 @@
+#include "Bench.h"
+#include "MaterialRegistry.h"
+#include "Transforms.h"
+
+#include <DirectXMath.h>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+     // Per-instance constants the renderer uploaded before the material table: world matrix with
+     // specular power in shine.x and texture slice in shine.z
+     struct WorldMatrixBuffer
+     {
+          XMMATRIX worldMatrix;
+          XMFLOAT4 shine;
+     };
+}
+
+// Per-frame instance upload of 100K instances sharing 64 distinct materials. Old layout copies the matrix and
+// material of every instance each frame, new one packs transforms with 16 bit material ids and uploads
+// the deduplicated material table only when it grows
+void MaterialBench(const BenchSettings& settings)
+{
+     const size_t count = 100000;
+     const uint32_t distinct = 64;
+     std::mt19937 rng(25);
+     std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+     std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+     std::uniform_int_distribution<uint32_t> pick(0, distinct - 1);
+
+     TransformsSoA transforms;
+     transforms.Resize(count);
+     std::vector<Material> instanceMaterials(count);
+     MaterialRegistry registry;
+     std::vector<uint16_t> materialIds(count);
+     for (size_t i = 0; i < count; ++i)
+     {
+          transforms.Set(i, XMMatrixMultiply(XMMatrixRotationRollPitchYaw(angle(rng), angle(rng), angle(rng)),
+               XMMatrixTranslation(position(rng), position(rng), position(rng))));
+          uint32_t kind = pick(rng);
+          Material& material = instanceMaterials[i];
+          material.specularPower = 0.1f + 0.1f * (kind % 32);
+          material.textureSlice = kind % 2;
+          material.flags = kind / 32 ? static_cast<uint32_t>(MaterialUnlit) : 0u;
+          materialIds[i] = registry.Add(material);
+     }
+
+     std::vector<WorldMatrixBuffer> perInstance(count);
+     BenchRun("matrix and material per instance", BenchIterations(settings, 50), [&]()
+          {
+               for (size_t i = 0; i < count; ++i)
+               {
+                    perInstance[i].worldMatrix = XMMatrixTranspose(transforms.Get(i));
+                    perInstance[i].shine = XMFLOAT4(instanceMaterials[i].specularPower, 0.0f,
+                         static_cast<float>(instanceMaterials[i].textureSlice), 0.0f);
+               }
+          });
+
+     std::vector<PackedInstance> packed(count);
+     BenchRun("PackTransforms with material ids", BenchIterations(settings, 50), [&]()
+          {
+               PackTransforms(transforms, materialIds.data(), 0, count, packed.data());
+          });
+
+     size_t oldBytes = count * sizeof(WorldMatrixBuffer);
+     size_t newBytes = count * sizeof(PackedInstance);
+     size_t tableBytes = registry.Size() * sizeof(Material);
+     std::printf("  %zu instances, %zu unique materials, table of %zu bytes uploaded once\n", count, registry.Size(), tableBytes);
+     std::printf("  per frame %zu bytes instead of %zu, %zu bytes (%.1f%%) saved\n", newBytes, oldBytes,
+          oldBytes - newBytes, 100.0 * (oldBytes - newBytes) / oldBytes);
+}
@@ -0,0 +1,133 @@
+#include "Bench.h"
+#include "CacheMissCounter.h"
+#include "DynamicAABBTree.h"
+#include "InstanceStore.h"
+#include "SpatialOrder.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+     // Function to count maximal runs of consecutive visible positions, every run is one contiguous upload
+     size_t CountRuns(const std::vector<uint8_t>& visible)
+     {
+          size_t runs = 0;
+          for (size_t idx = 0; idx < visible.size(); ++idx)
+          {
+               runs += visible[idx] && (idx == 0 || !visible[idx - 1]);
+          }
+          return runs;
+     }
+
+     // Function to cull all instances and pack transforms of visible runs, prints time and cache misses of both steps
+     void MeasureCull(const BenchSettings& settings, ThreadPool& pool, DynamicAABBTree& tree, const InstanceStore& store,
+          const Frustum& frustum, std::vector<uint8_t>& visible, std::vector<PackedInstance>& packed)
+     {
+          CacheMissCounter misses;
+          uint64_t queryMisses = 0;
+          uint64_t packMisses = 0;
+          size_t iterations = BenchIterations(settings, 20);
+          BenchRun("tree query", iterations, [&]()
+               {
+                    misses.Start();
+                    std::fill(visible.begin(), visible.end(), 0);
+                    tree.Query(pool, frustum, store.bounds, visible.data());
+                    queryMisses += misses.Stop();
+               });
+
+          size_t written = 0;
+          BenchRun("pack visible runs", iterations, [&]()
+               {
+                    misses.Start();
+                    written = 0;
+                    size_t idx = 0;
+                    while (idx < visible.size())
+                    {
+                         if (!visible[idx])
+                         {
+                              ++idx;
+                              continue;
+                         }
+                         size_t end = idx;
+                         while (end < visible.size() && visible[end])
+                         {
+                              ++end;
+                         }
+                         PackTransforms(store.transforms, store.materials.data(), idx, end, packed.data() + written);
+                         written += end - idx;
+                         idx = end;
+                    }
+                    packMisses += misses.Stop();
+               });
+
+          std::printf("  %zu visible in %zu runs", written, CountRuns(visible));
+          if (misses.IsAvailable())
+          {
+               // Warm up run is counted too.
+               std::printf(", cache misses per run: query %llu, pack %llu\n", static_cast<unsigned long long>(queryMisses / (iterations + 1)),
+                    static_cast<unsigned long long>(packMisses / (iterations + 1)));
+          }
+          else
+          {
+               std::printf(", cache miss counter not available\n");
+          }
+     }
+}
+
+// Culling 1M randomly placed instances stored in creation order and after sorting them by Morton code
+void MortonBench(const BenchSettings& settings)
+{
+     const size_t count = settings.quick ? 1 << 16 : 1 << 20;
+     const float range = 400.0f;
+     std::mt19937 rng(16);
+     std::uniform_real_distribution<float> position(-range, range);
+     std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+
+     InstanceStore store;
+     for (size_t i = 0; i < count; ++i)
+     {
+          XMMATRIX world = XMMatrixMultiply(XMMatrixRotationRollPitchYaw(angle(rng), angle(rng), 0.0f),
+               XMMatrixTranslation(position(rng), position(rng), position(rng)));
+          store.Add(world, static_cast<uint16_t>(i % 16), 1e6f);
+     }
+     std::vector<uint32_t> updated;
+     UpdateWorldBounds(store.transforms, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f), store.bounds, updated);
+
+     DynamicAABBTree tree;
+     for (uint32_t idx = 0; idx < store.Size(); ++idx)
+     {
+          XMFLOAT3 center(store.bounds.centerX[idx], store.bounds.centerY[idx], store.bounds.centerZ[idx]);
+          XMFLOAT3 extent(store.bounds.extentX[idx], store.bounds.extentY[idx], store.bounds.extentZ[idx]);
+          store.proxies[idx] = tree.CreateProxy(center, extent, idx);
+     }
+
+     // Camera in the middle of the field sees a wide cone of it, about a tenth of all instances.
+     XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.3f, 0.1f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, range, 0.1f);
+     Frustum frustum;
+     frustum.Init(0.1f);
+     frustum.ConstructFrustum(view, proj);
+
+     // One thread, so the counter sees every access.
+     ThreadPool pool(1);
+     std::vector<uint8_t> visible(store.Size());
+     std::vector<PackedInstance> packed(store.Size());
+     std::printf("  creation order\n");
+     MeasureCull(settings, pool, tree, store, frustum, visible, packed);
+
+     // Same tree, only the positions its leaves point to change.
+     std::vector<uint32_t> order;
+     ComputeMortonOrder(store.bounds, order);
+     store.Reorder(order);
+     for (uint32_t idx = 0; idx < store.Size(); ++idx)
+     {
+          tree.SetUserData(store.proxies[idx], idx);
+     }
+     std::printf("  Morton order\n");
+     MeasureCull(settings, pool, tree, store, frustum, visible, packed);
+}
@@ -0,0 +1,75 @@
+#include "Bench.h"
+#include "MultiFrustum.h"
+
+#include <random>
+#include <vector>
+
+// 1M boxes around an eye culled against the six cube map faces the PVS baker uses, in one MultiFrustum pass
+// and in six CheckAABBBatch passes that gather the ids of every face
+void MultiFrustumBench(const BenchSettings& settings)
+{
+     const size_t count = 1 << 20;
+     std::mt19937 rng(8);
+     std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+     std::uniform_real_distribution<float> size(0.1f, 2.0f);
+     BoundsSoA bounds;
+     bounds.Resize(count);
+     for (size_t i = 0; i < count; ++i)
+     {
+          bounds.Set(i, XMFLOAT3(position(rng), position(rng), position(rng)), XMFLOAT3(size(rng), size(rng), size(rng)));
+     }
+
+     const XMFLOAT3 directions[6] = {
+          { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+          { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+     };
+     const XMFLOAT3 ups[6] = {
+          { 0.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f },
+          { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+     };
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 100.0f, 0.1f);
+     Frustum faces[6];
+     MultiFrustum multi;
+     for (int face = 0; face < 6; face++)
+     {
+          XMMATRIX view = XMMatrixLookToLH(XMVectorZero(), XMLoadFloat3(&directions[face]), XMLoadFloat3(&ups[face]));
+          faces[face].Init(0.1f);
+          faces[face].ConstructFrustum(view, proj);
+          multi.AddView(faces[face]);
+     }
+
+     std::vector<uint32_t> viewMasks(count);
+     std::vector<uint32_t> multiVisible[6];
+     double combined = BenchRun("MultiFrustum, 6 views", BenchIterations(settings, 20), [&]()
+          {
+               multi.Cull(bounds, viewMasks.data(), multiVisible);
+          });
+
+     std::vector<uint8_t> inside(count);
+     std::vector<uint32_t> sequentialVisible[6];
+     double sequential = BenchRun("6 sequential CheckAABBBatch passes", BenchIterations(settings, 20), [&]()
+          {
+               for (int face = 0; face < 6; face++)
+               {
+                    faces[face].CheckAABBBatch(bounds.centerX.data(), bounds.centerY.data(), bounds.centerZ.data(),
+                         bounds.extentX.data(), bounds.extentY.data(), bounds.extentZ.data(), count, inside.data());
+                    sequentialVisible[face].clear();
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                         if (inside[i])
+                         {
+                              sequentialVisible[face].push_back(static_cast<uint32_t>(i));
+                         }
+                    }
+               }
+          });
+
+     size_t total = 0;
+     size_t differing = 0;
+     for (int face = 0; face < 6; face++)
+     {
+          total += multiVisible[face].size();
+          differing += multiVisible[face] != sequentialVisible[face];
+     }
+     std::printf("  %zu box-view pairs visible, %.2fx speedup of one pass, %zu views differ\n", total, sequential / combined, differing);
+}
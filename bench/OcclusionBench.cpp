@@ -0,0 +1,58 @@
+#include "Bench.h"
+#include "CubeMesh.h"
+#include "OcclusionCuller.h"
+
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+// Renderer sized buffer with eight near cubes hiding part of a field of boxes in front of the camera
+void OcclusionBench(const BenchSettings& settings)
+{
+     const size_t boxCount = 20000;
+     XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+     XMMATRIX viewProj = XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XM_PI / 3, 320.0f / 192.0f, 100.0f, 0.1f));
+
+     std::vector<XMMATRIX> occluders;
+     for (int i = 0; i < 8; i++)
+     {
+          float x = -10.5f + 3.0f * i;
+          occluders.push_back(XMMatrixMultiply(XMMatrixScaling(2.5f, 6.0f, 2.5f), XMMatrixTranslation(x, 0.0f, 10.0f + (i & 1))));
+     }
+
+     std::mt19937 rng(1);
+     std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+     std::uniform_real_distribution<float> depth(15.0f, 90.0f);
+     std::vector<XMFLOAT3> centers(boxCount);
+     for (XMFLOAT3& center : centers)
+     {
+          center.z = depth(rng);
+          center.x = unit(rng) * center.z * 0.9f;
+          center.y = unit(rng) * center.z * 0.5f;
+     }
+     const XMFLOAT3 extent(0.5f, 0.5f, 0.5f);
+
+     OcclusionCuller culler;
+     culler.Init(320, 192);
+     BenchRun("render 8 occluders and build hierarchy", BenchIterations(settings, 2000), [&]()
+          {
+               culler.Clear(viewProj);
+               for (const XMMATRIX& world : occluders)
+               {
+                    culler.RenderOccluder(cubePositions, sizeof(XMFLOAT3), 24, cubeIndices, 36, world);
+               }
+               culler.BuildHierarchy();
+          });
+
+     size_t hidden = 0;
+     BenchRun("test 20000 boxes", BenchIterations(settings, 200), [&]()
+          {
+               hidden = 0;
+               for (const XMFLOAT3& center : centers)
+               {
+                    hidden += culler.TestAABB(center, extent) ? 0 : 1;
+               }
+          });
+     std::printf("  hidden %zu of %zu boxes\n", hidden, boxCount);
+}
@@ -0,0 +1,54 @@
+#include "Bench.h"
+#include "Transforms.h"
+
+#include <DirectXMath.h>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+// Instance upload of 1M transforms with random rotation, scale and position, a tenth of them mirrored.
+// The matrix layout stores the transposed world matrix of every instance, the packed one runs PackTransforms
+// into 24 byte instances. Throughput is reported in instances per millisecond and the upload in bytes per frame
+void PackBench(const BenchSettings& settings)
+{
+     const size_t count = 1 << 20;
+     std::mt19937 rng(19);
+     std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+     std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+     std::uniform_real_distribution<float> scale(0.5f, 4.0f);
+     std::uniform_int_distribution<int> mirror(0, 9);
+
+     TransformsSoA transforms;
+     transforms.Resize(count);
+     std::vector<uint16_t> materials(count);
+     for (size_t i = 0; i < count; ++i)
+     {
+          XMMATRIX scaling = XMMatrixScaling(scale(rng), scale(rng), mirror(rng) == 0 ? -scale(rng) : scale(rng));
+          transforms.Set(i, XMMatrixMultiply(XMMatrixMultiply(scaling, XMMatrixRotationRollPitchYaw(angle(rng), angle(rng), angle(rng))),
+               XMMatrixTranslation(position(rng), position(rng), position(rng))));
+          materials[i] = static_cast<uint16_t>(i % 64);
+     }
+
+     std::vector<XMFLOAT4X4> matrices(count);
+     double matrixTime = BenchRun("transposed world matrix per instance", BenchIterations(settings, 20), [&]()
+          {
+               for (size_t i = 0; i < count; ++i)
+               {
+                    XMStoreFloat4x4(&matrices[i], XMMatrixTranspose(transforms.Get(i)));
+               }
+          });
+
+     std::vector<PackedInstance> packed(count);
+     double packTime = BenchRun("PackTransforms", BenchIterations(settings, 20), [&]()
+          {
+               PackTransforms(transforms, materials.data(), 0, count, packed.data());
+          });
+
+     size_t matrixBytes = count * sizeof(XMFLOAT4X4);
+     size_t packedBytes = count * sizeof(PackedInstance);
+     std::printf("  matrices %.0f instances/ms, packed %.0f instances/ms, %.1fx\n", count / matrixTime, count / packTime,
+          matrixTime / packTime);
+     std::printf("  per frame %zu bytes instead of %zu, %zu bytes per instance instead of %zu, %.1fx less\n", packedBytes,
+          matrixBytes, sizeof(PackedInstance), sizeof(XMFLOAT4X4), static_cast<double>(matrixBytes) / packedBytes);
+}
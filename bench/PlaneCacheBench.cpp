@@ -0,0 +1,66 @@
+#include "Bench.h"
+#include "DynamicAABBTree.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Camera orbiting inside a field of 100K boxes held in the dynamic tree, queried every frame with the per node
+// plane cache on and off. Nodes and leaves rejected last frame are mostly rejected by the same plane again
+void PlaneCacheBench(const BenchSettings& settings)
+{
+     const size_t count = 100000;
+     const unsigned frames = 120;
+     std::mt19937 rng(5);
+     std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+     std::uniform_real_distribution<float> size(0.1f, 2.0f);
+     BoundsSoA bounds;
+     bounds.Resize(count);
+     DynamicAABBTree tree;
+     for (size_t i = 0; i < count; ++i)
+     {
+          bounds.Set(i, XMFLOAT3(position(rng), position(rng), position(rng)), XMFLOAT3(size(rng), size(rng), size(rng)));
+          tree.CreateProxy(XMFLOAT3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]),
+               XMFLOAT3(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]), static_cast<uint32_t>(i));
+     }
+
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f);
+     std::vector<Frustum> path(frames);
+     for (unsigned frame = 0; frame < frames; ++frame)
+     {
+          float angle = XM_2PI * frame / frames;
+          XMVECTOR eye = XMVectorSet(50.0f * cosf(angle), 10.0f, 50.0f * sinf(angle), 1.0f);
+          XMMATRIX view = XMMatrixLookAtLH(eye, XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+          path[frame].Init(0.1f);
+          path[frame].ConstructFrustum(view, proj);
+     }
+
+     ThreadPool pool(1);
+     std::vector<uint8_t> visible(count);
+     for (bool cache : { false, true })
+     {
+          tree.SetPlaneCache(cache);
+          uint64_t planeTests = 0;
+          double pass = BenchRun(cache ? "camera path, plane cache on" : "camera path, plane cache off", BenchIterations(settings, 10), [&]()
+               {
+                    planeTests = 0;
+                    for (Frustum& frustum : path)
+                    {
+                         std::fill(visible.begin(), visible.end(), uint8_t(0));
+                         frustum.ResetStats();
+                         tree.Query(pool, frustum, bounds, visible.data());
+                         planeTests += frustum.GetStats().planeTests;
+                    }
+               });
+          std::printf("  %.3f ms per frame", pass / frames);
+          if (FRUSTUM_STATS)
+          {
+               std::printf(", %llu plane tests per frame", static_cast<unsigned long long>(planeTests / frames));
+          }
+          std::printf("\n");
+     }
+     if (!FRUSTUM_STATS)
+     {
+          std::printf("  plane test counts need -DFRUSTUM_STATS=ON\n");
+     }
+}
@@ -0,0 +1,120 @@
+#include "Bench.h"
+#include "Frustum.h"
+#include "PortalGraph.h"
+
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace
+{
+     const float roomSize = 10.0f;
+     const float roomHeight = 4.0f;
+     const float doorWidth = 2.0f;
+     const float doorHeight = 3.0f;
+}
+
+// Row of 64 rooms along +z joined by doorways in the middle of the walls, 2000 boxes in every room, the way
+// BuildPortalLevel lays the demo rooms out. The camera walks down the row turning from side to side, every
+// frame is culled by PortalGraph::Cull and by CheckAABBBatch over all boxes. Portals only test boxes of the
+// cells they reach, the reduction of tested boxes is reported next to the time
+void PortalBench(const BenchSettings& settings)
+{
+     const size_t roomCount = 64;
+     const size_t perRoom = 2000;
+     const size_t count = roomCount * perRoom;
+     const size_t frameCount = 64;
+
+     std::mt19937 rng(1);
+     std::uniform_real_distribution<float> across(-roomSize / 2 + 0.5f, roomSize / 2 - 0.5f);
+     std::uniform_real_distribution<float> height(0.2f, roomHeight - 0.2f);
+     std::uniform_real_distribution<float> size(0.05f, 0.2f);
+     PortalGraph graph;
+     BoundsSoA bounds;
+     bounds.Resize(count);
+     for (size_t room = 0; room < roomCount; ++room)
+     {
+          float z = roomSize * room;
+          int cell = graph.AddCell(XMFLOAT3(0.0f, roomHeight / 2, z + roomSize / 2), XMFLOAT3(roomSize / 2, roomHeight / 2, roomSize / 2));
+          for (size_t i = 0; i < perRoom; ++i)
+          {
+               uint32_t idx = static_cast<uint32_t>(room * perRoom + i);
+               bounds.Set(idx, XMFLOAT3(across(rng), height(rng), z + roomSize / 2 + across(rng)), XMFLOAT3(size(rng), size(rng), size(rng)));
+               graph.AddInstance(cell, idx);
+          }
+          if (room > 0)
+          {
+               XMFLOAT3 corners[4] = {
+                    XMFLOAT3(-doorWidth / 2, 0.0f, z),
+                    XMFLOAT3(doorWidth / 2, 0.0f, z),
+                    XMFLOAT3(doorWidth / 2, doorHeight, z),
+                    XMFLOAT3(-doorWidth / 2, doorHeight, z)
+               };
+               graph.AddPortal(cell - 1, cell, corners);
+          }
+     }
+
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f);
+     std::vector<Frustum> frustums(frameCount);
+     std::vector<XMFLOAT3> eyes(frameCount);
+     for (size_t frame = 0; frame < frameCount; ++frame)
+     {
+          float yaw = 0.8f * sinf(frame * 0.4f);
+          eyes[frame] = XMFLOAT3(2.0f * sinf(frame * 0.3f), 1.7f, roomSize * (roomCount - 2) * frame / frameCount + 1.0f);
+          XMVECTOR eye = XMLoadFloat3(&eyes[frame]);
+          XMMATRIX view = XMMatrixLookToLH(eye, XMVectorSet(sinf(yaw), 0.0f, cosf(yaw), 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+          frustums[frame].Init(0.1f);
+          frustums[frame].ConstructFrustum(view, proj);
+     }
+
+     std::vector<uint8_t> plain(count);
+     size_t plainVisible = 0;
+     double frustumTime = BenchRun("CheckAABBBatch over all boxes, frame", BenchIterations(settings, 5), [&]()
+          {
+               plainVisible = 0;
+               for (size_t frame = 0; frame < frameCount; ++frame)
+               {
+                    frustums[frame].CheckAABBBatch(bounds.centerX.data(), bounds.centerY.data(), bounds.centerZ.data(),
+                         bounds.extentX.data(), bounds.extentY.data(), bounds.extentZ.data(), count, plain.data());
+                    plainVisible += std::accumulate(plain.begin(), plain.end(), size_t(0));
+               }
+          }) / frameCount;
+
+     // Every box belongs to one cell and the rooms form a row, so each visited cell tests perRoom boxes once
+     std::vector<uint8_t> portal(count);
+     size_t visitedCells = 0;
+     double portalTime = BenchRun("PortalGraph::Cull, frame", BenchIterations(settings, 5), [&]()
+          {
+               visitedCells = 0;
+               for (size_t frame = 0; frame < frameCount; ++frame)
+               {
+                    std::memset(portal.data(), 0, count);
+                    visitedCells += graph.Cull(frustums[frame], eyes[frame], bounds, portal.data());
+               }
+          }) / frameCount;
+
+     // Portals narrow the frustum, whatever they keep has to be kept by the plain frustum too
+     size_t portalVisible = 0;
+     size_t outsideFrustum = 0;
+     for (size_t frame = 0; frame < frameCount; ++frame)
+     {
+          std::memset(portal.data(), 0, count);
+          graph.Cull(frustums[frame], eyes[frame], bounds, portal.data());
+          frustums[frame].CheckAABBBatch(bounds.centerX.data(), bounds.centerY.data(), bounds.centerZ.data(),
+               bounds.extentX.data(), bounds.extentY.data(), bounds.extentZ.data(), count, plain.data());
+          for (size_t i = 0; i < count; ++i)
+          {
+               portalVisible += portal[i];
+               outsideFrustum += portal[i] && !plain[i];
+          }
+     }
+
+     size_t tested = visitedCells * perRoom / frameCount;
+     std::printf("  plain frustum tests %zu boxes and keeps %zu, portals visit %.1f cells, test %zu boxes and keep %zu\n",
+          count, plainVisible / frameCount, static_cast<double>(visitedCells) / frameCount, tested, portalVisible / frameCount);
+     std::printf("  %.1fx fewer boxes tested, %.1fx fewer drawn, %zu portal results outside of the frustum\n",
+          static_cast<double>(count) / tested, static_cast<double>(plainVisible) / portalVisible, outsideFrustum);
+     std::printf("  frustum %.4f ms, portals %.4f ms per frame\n", frustumTime, portalTime);
+}
@@ -0,0 +1,81 @@
+#include "Bench.h"
+#include "PvsBaker.h"
+
+#include <random>
+#include <vector>
+
+// City of 16x16 turned buildings on a ground slab with 10K small cubes in the streets. Cells of a 4x1x4 block
+// in the middle are
+// baked on every hardware thread, then the sets of all baked cells are decoded the way Scene does when the camera
+// enters a cell
+void PvsBench(const BenchSettings& settings)
+{
+     const int blocks = 16;
+     const float spacing = 12.0f;
+     const size_t streetCount = 10000;
+     std::mt19937 rng(14);
+     std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+     std::uniform_real_distribution<float> height(4.0f, 12.0f);
+     std::uniform_real_distribution<float> position(-blocks * spacing / 2, blocks * spacing / 2);
+
+     TransformsSoA transforms;
+     transforms.Resize(1 + blocks * blocks + streetCount);
+     transforms.Set(0, XMMatrixMultiply(XMMatrixScaling(blocks * spacing, 1.0f, blocks * spacing), XMMatrixTranslation(0.0f, -0.5f, 0.0f)));
+     size_t idx = 1;
+     for (int x = 0; x < blocks; x++)
+     {
+          for (int z = 0; z < blocks; z++)
+          {
+               float y = height(rng);
+               XMMATRIX world = XMMatrixMultiply(XMMatrixScaling(6.0f, y, 6.0f), XMMatrixRotationY(angle(rng)));
+               transforms.Set(idx++, XMMatrixMultiply(world, XMMatrixTranslation((x - blocks / 2 + 0.5f) * spacing, y / 2,
+                    (z - blocks / 2 + 0.5f) * spacing)));
+          }
+     }
+     for (; idx < transforms.Size(); ++idx)
+     {
+          transforms.Set(idx, XMMatrixTranslation(position(rng), 0.5f, position(rng)));
+     }
+     const XMFLOAT3 localCenter(0.0f, 0.0f, 0.0f);
+     const XMFLOAT3 localExtent(0.5f, 0.5f, 0.5f);
+     BoundsSoA bounds;
+     std::vector<uint32_t> updated;
+     UpdateWorldBounds(transforms, localCenter, localExtent, bounds, updated);
+     std::vector<uint8_t> solid(transforms.Size(), 1);
+
+     PvsBakeSettings bakeSettings;
+     bakeSettings.cellSize = XMFLOAT3(8.0f, 8.0f, 8.0f);
+     bakeSettings.resolution = 64;
+     const XMFLOAT3 sceneMin(-16.0f, 1.0f, -16.0f);
+     const XMFLOAT3 sceneMax(16.0f, 9.0f, 16.0f);
+     ThreadPool pool;
+     PvsBaker baker;
+     PvsTable table;
+     double bake = BenchRun("bake 4x1x4 cells", BenchIterations(settings, 3), [&]()
+          {
+               baker.Bake(pool, bounds, transforms, localCenter, localExtent, solid, sceneMin, sceneMax, bakeSettings, table);
+          });
+     size_t cellCount = table.GetCellCount();
+     std::printf("  %zu instances, %u threads, %.2f ms per cell, %zu bytes of sets\n", transforms.Size(), pool.GetThreadCount(),
+          bake / cellCount, table.GetDataSize());
+
+     Bitset visible;
+     double lookup = BenchRun("GetVisibleSet of every cell", BenchIterations(settings, 200), [&]()
+          {
+               for (size_t cell = 0; cell < cellCount; ++cell)
+               {
+                    table.GetVisibleSet(static_cast<int>(cell), visible);
+               }
+          });
+     size_t setBits = 0;
+     for (size_t cell = 0; cell < cellCount; ++cell)
+     {
+          table.GetVisibleSet(static_cast<int>(cell), visible);
+          for (size_t i = 0; i < visible.Size(); ++i)
+          {
+               setBits += visible.Test(i);
+          }
+     }
+     std::printf("  %.0f ns per lookup, %.1f instances per set on average\n", lookup * 1e6 / cellCount,
+          static_cast<double>(setBits) / cellCount);
+}
@@ -0,0 +1,60 @@
+#include "Bench.h"
+#include "Frustum.h"
+#include "VisibilityPass.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Visibility pass over 1M boxes on pools of 1 to hardware_concurrency workers: every chunk of VisibilityPass
+// is frustum tested with CheckAABBBatch and its visible ids are gathered in order
+void ScalingBench(const BenchSettings& settings)
+{
+     const size_t count = 1 << 20;
+     std::mt19937 rng(7);
+     std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+     std::uniform_real_distribution<float> size(0.1f, 2.0f);
+     BoundsSoA bounds;
+     bounds.Resize(count);
+     for (size_t i = 0; i < count; ++i)
+     {
+          bounds.Set(i, XMFLOAT3(position(rng), position(rng), position(rng)), XMFLOAT3(size(rng), size(rng), size(rng)));
+     }
+
+     XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f);
+     Frustum frustum;
+     frustum.Init(0.1f);
+     frustum.ConstructFrustum(view, proj);
+
+     unsigned maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+     double single = 0.0;
+     for (unsigned workers = 1; workers <= maxWorkers; ++workers)
+     {
+          ThreadPool pool(workers);
+          VisibilityPass pass;
+          std::vector<uint32_t> visible;
+          char label[64];
+          std::snprintf(label, sizeof(label), "visibility pass, %u workers", workers);
+          double elapsed = BenchRun(label, BenchIterations(settings, 20), [&]()
+               {
+                    pass.Gather(pool, count, [&](size_t begin, size_t end, std::vector<uint32_t>& output)
+                         {
+                              uint8_t inside[VisibilityPass::chunkSize];
+                              frustum.CheckAABBBatch(bounds.centerX.data() + begin, bounds.centerY.data() + begin,
+                                   bounds.centerZ.data() + begin, bounds.extentX.data() + begin, bounds.extentY.data() + begin,
+                                   bounds.extentZ.data() + begin, end - begin, inside);
+                              for (size_t idx = begin; idx < end; ++idx)
+                              {
+                                   if (inside[idx - begin])
+                                   {
+                                        output.push_back(static_cast<uint32_t>(idx));
+                                   }
+                              }
+                         }, visible);
+               });
+          single = workers == 1 ? elapsed : single;
+          std::printf("  %zu visible, %.2fx of one worker\n", visible.size(), single / elapsed);
+     }
+}
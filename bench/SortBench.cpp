@@ -0,0 +1,58 @@
+#include "Bench.h"
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Draw order sort of 1M visible instances with keys laid out like Scene builds them: LOD level in bits 40-47,
+// material in bits 24-39 and quantized depth below. Radix sort is compared with std::stable_sort of key/id pairs
+void SortBench(const BenchSettings& settings)
+{
+     const size_t count = 1 << 20;
+     std::mt19937_64 rng(23);
+     std::uniform_int_distribution<uint64_t> level(0, 2);
+     std::uniform_int_distribution<uint64_t> depth(0, 0xFFFFFF);
+     std::vector<uint64_t> source(count);
+     for (uint16_t materialCount : { uint16_t(1), uint16_t(16), uint16_t(1024) })
+     {
+          std::uniform_int_distribution<uint64_t> material(0, materialCount - 1);
+          for (uint64_t& key : source)
+          {
+               key = level(rng) << 40 | material(rng) << 24 | depth(rng);
+          }
+          std::printf("  %u materials\n", materialCount);
+
+          std::vector<uint64_t> keys;
+          std::vector<uint32_t> ids(count);
+          std::vector<uint64_t> keyScratch;
+          std::vector<uint32_t> idScratch;
+          double radix = BenchRun("RadixSort", BenchIterations(settings, 20), [&]()
+               {
+                    keys = source;
+                    std::iota(ids.begin(), ids.end(), 0u);
+                    RadixSort(keys, ids, keyScratch, idScratch);
+               });
+          bool sorted = std::is_sorted(keys.begin(), keys.end());
+
+          std::vector<std::pair<uint64_t, uint32_t>> pairs(count);
+          double stable = BenchRun("std::stable_sort of key/id pairs", BenchIterations(settings, 20), [&]()
+               {
+                    for (uint32_t i = 0; i < count; ++i)
+                    {
+                         pairs[i] = std::make_pair(source[i], i);
+                    }
+                    std::stable_sort(pairs.begin(), pairs.end(),
+                         [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b) { return a.first < b.first; });
+               });
+
+          bool same = sorted;
+          for (size_t i = 0; i < count && same; ++i)
+          {
+               same = pairs[i].second == ids[i];
+          }
+          std::printf("  %.2f ns per key, %.1fx faster, %s\n", radix * 1e6 / count, stable / radix,
+               same ? "same order" : "ORDER DIFFERS");
+     }
+}
@@ -0,0 +1,90 @@
+#include "BVH.h"
+#include "Bench.h"
+#include "DynamicAABBTree.h"
+
+#include <numeric>
+#include <random>
+#include <vector>
+
+// 100K boxes drifting through a 200 unit cube at up to 5 units per second at 60 fps, the part given by --moving
+// steps every frame. Updating the dynamic tree with MoveProxy and querying it is compared with building a tree
+// or a BVH from scratch every frame
+void TreeBench(const BenchSettings& settings)
+{
+     const size_t count = 100000;
+     std::mt19937 rng(4);
+     std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+     std::uniform_real_distribution<float> size(0.1f, 2.0f);
+     std::uniform_real_distribution<float> step(-0.05f, 0.05f);
+     BoundsSoA bounds;
+     bounds.Resize(count);
+     std::vector<XMFLOAT3> velocities(count);
+     DynamicAABBTree tree;
+     std::vector<int32_t> proxies(count);
+     for (size_t i = 0; i < count; ++i)
+     {
+          bounds.Set(i, XMFLOAT3(position(rng), position(rng), position(rng)), XMFLOAT3(size(rng), size(rng), size(rng)));
+          velocities[i] = XMFLOAT3(step(rng), step(rng), step(rng));
+          proxies[i] = tree.CreateProxy(XMFLOAT3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]),
+               XMFLOAT3(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]), static_cast<uint32_t>(i));
+     }
+
+     XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f);
+     Frustum frustum;
+     frustum.Init(0.1f);
+     frustum.ConstructFrustum(view, proj);
+     ThreadPool pool(1);
+     std::vector<uint8_t> visible(count);
+
+     // Every frame moves the next slice of boxes, so all of them move over a few frames.
+     const size_t moving = static_cast<size_t>(settings.moving * count);
+     size_t next = 0;
+     size_t reinserted = 0;
+     size_t moves = 0;
+     double update = BenchRun("MoveProxy of moving boxes", BenchIterations(settings, 100), [&]()
+          {
+               for (size_t m = 0; m < moving; ++m, next = (next + 1) % count)
+               {
+                    bounds.centerX[next] += velocities[next].x;
+                    bounds.centerY[next] += velocities[next].y;
+                    bounds.centerZ[next] += velocities[next].z;
+                    reinserted += tree.MoveProxy(proxies[next], XMFLOAT3(bounds.centerX[next], bounds.centerY[next], bounds.centerZ[next]),
+                         XMFLOAT3(bounds.extentX[next], bounds.extentY[next], bounds.extentZ[next]));
+               }
+               moves += moving;
+          });
+     double query = BenchRun("Query", BenchIterations(settings, 100), [&]()
+          {
+               std::fill(visible.begin(), visible.end(), uint8_t(0));
+               tree.Query(pool, frustum, bounds, visible.data());
+          });
+     std::printf("  %zu of %zu boxes moving (--moving %.2f), %.1f%% of moves reinserted, tree height %d\n", moving, count,
+          settings.moving, moves ? 100.0 * reinserted / moves : 0.0, tree.GetHeight());
+
+     DynamicAABBTree rebuilt;
+     double rebuild = BenchRun("rebuild tree and Query", BenchIterations(settings, 5), [&]()
+          {
+               rebuilt.Clear();
+               for (size_t i = 0; i < count; ++i)
+               {
+                    rebuilt.CreateProxy(XMFLOAT3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]),
+                         XMFLOAT3(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]), static_cast<uint32_t>(i));
+               }
+               std::fill(visible.begin(), visible.end(), uint8_t(0));
+               rebuilt.Query(pool, frustum, bounds, visible.data());
+          });
+
+     std::vector<uint32_t> ids(count);
+     std::iota(ids.begin(), ids.end(), 0);
+     BVH bvh;
+     std::vector<uint32_t> culled;
+     double bvhRebuild = BenchRun("BVH build and Cull", BenchIterations(settings, 5), [&]()
+          {
+               bvh.Build(bounds, ids.data(), count, 1);
+               culled.clear();
+               bvh.Cull(frustum, culled);
+          });
+     std::printf("  incremental %.3f ms per frame, %.2fx speedup over a tree rebuild, %.2fx over a BVH rebuild\n",
+          update + query, rebuild / (update + query), bvhRebuild / (update + query));
+}
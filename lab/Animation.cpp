@@ -0,0 +1,241 @@
+#include "Animation.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+void AnimationsSoA::Resize(size_t count)
+{
+     flags.resize(count, MotionNone);
+     for (auto& row : rest)
+     {
+          for (auto& column : row)
+          {
+               column.resize(count);
+          }
+     }
+     for (int r = 0; r < 4; r++)
+     {
+          for (int c = 0; c < 3; c++)
+          {
+               base[r][c].resize(count, r == c ? 1.0f : 0.0f);
+          }
+     }
+     centerX.resize(count);
+     centerY.resize(count);
+     centerZ.resize(count);
+     orbitRadius.resize(count);
+     orbitSpeed.resize(count);
+     bobAmplitude.resize(count);
+     bobSpeed.resize(count);
+     spinSpeed.resize(count);
+     phase.resize(count);
+}
+
+void AnimationsSoA::Set(size_t idx, const Motion& motion, FXMMATRIX restTransform)
+{
+     XMFLOAT4X3 value;
+     XMStoreFloat4x3(&value, restTransform);
+     for (int r = 0; r < 3; r++)
+     {
+          for (int c = 0; c < 3; c++)
+          {
+               rest[r][c][idx] = value.m[r][c];
+          }
+     }
+     flags[idx] = motion.flags;
+     centerX[idx] = motion.center.x;
+     centerY[idx] = motion.center.y;
+     centerZ[idx] = motion.center.z;
+     bool orbit = (motion.flags & MotionOrbit) != 0;
+     bool bob = (motion.flags & MotionBob) != 0;
+     orbitRadius[idx] = orbit ? motion.orbitRadius : 0.0f;
+     orbitSpeed[idx] = orbit ? motion.orbitSpeed : 0.0f;
+     bobAmplitude[idx] = bob ? motion.bobAmplitude : 0.0f;
+     bobSpeed[idx] = bob ? motion.bobSpeed : 0.0f;
+     spinSpeed[idx] = (motion.flags & MotionSpin) ? motion.spinSpeed : 0.0f;
+     phase[idx] = motion.phase;
+}
+
+void AnimationsSoA::SetBase(size_t idx, FXMMATRIX baseTransform)
+{
+     XMFLOAT4X3 value;
+     XMStoreFloat4x3(&value, baseTransform);
+     for (int r = 0; r < 4; r++)
+     {
+          for (int c = 0; c < 3; c++)
+          {
+               base[r][c][idx] = value.m[r][c];
+          }
+     }
+}
+
+XMMATRIX AnimationsSoA::GetBase(size_t idx) const
+{
+     XMFLOAT4X3 value;
+     for (int r = 0; r < 4; r++)
+     {
+          for (int c = 0; c < 3; c++)
+          {
+               value.m[r][c] = base[r][c][idx];
+          }
+     }
+     return XMLoadFloat4x3(&value);
+}
+
+void AnimationsSoA::Copy(size_t from, size_t to)
+{
+     flags[to] = flags[from];
+     for (auto& row : rest)
+     {
+          for (auto& column : row)
+          {
+               column[to] = column[from];
+          }
+     }
+     for (auto& row : base)
+     {
+          for (auto& column : row)
+          {
+               column[to] = column[from];
+          }
+     }
+     centerX[to] = centerX[from];
+     centerY[to] = centerY[from];
+     centerZ[to] = centerZ[from];
+     orbitRadius[to] = orbitRadius[from];
+     orbitSpeed[to] = orbitSpeed[from];
+     bobAmplitude[to] = bobAmplitude[from];
+     bobSpeed[to] = bobSpeed[from];
+     spinSpeed[to] = spinSpeed[from];
+     phase[to] = phase[from];
+}
+
+static XMVECTOR LoadLanes(const std::vector<float>& values, size_t idx)
+{
+     return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(values.data() + idx));
+}
+
+static void StoreLanes(std::vector<float>& values, size_t idx, FXMVECTOR lanes)
+{
+     XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(values.data() + idx), lanes);
+}
+
+size_t AnimateTransforms(const AnimationsSoA& animations, float time, size_t begin, size_t end, TransformsSoA& transforms)
+{
+     const XMVECTOR t = XMVectorReplicate(time);
+     size_t animated = 0;
+     size_t idx = begin;
+     for (; idx + 4 <= end; idx += 4)
+     {
+          uint32_t flags;
+          memcpy(&flags, animations.flags.data() + idx, sizeof(flags));
+          if (!flags)
+          {
+               continue;
+          }
+
+          // Position is center + radius * (cos, 0, sin) of the orbit angle plus the bob offset along y,
+          // rest rows are rotated about y by the spin angle.
+          XMVECTOR phase = LoadLanes(animations.phase, idx);
+          XMVECTOR orbitSin, orbitCos, spinSin, spinCos;
+          XMVectorSinCos(&orbitSin, &orbitCos, XMVectorMultiplyAdd(LoadLanes(animations.orbitSpeed, idx), t, phase));
+          XMVECTOR bobSin = XMVectorSin(XMVectorMultiplyAdd(LoadLanes(animations.bobSpeed, idx), t, phase));
+          XMVectorSinCos(&spinSin, &spinCos, XMVectorMultiply(LoadLanes(animations.spinSpeed, idx), t));
+          XMVECTOR radius = LoadLanes(animations.orbitRadius, idx);
+
+          XMVECTOR local[4][3];
+          local[3][0] = XMVectorMultiplyAdd(radius, orbitCos, LoadLanes(animations.centerX, idx));
+          local[3][1] = XMVectorMultiplyAdd(LoadLanes(animations.bobAmplitude, idx), bobSin, LoadLanes(animations.centerY, idx));
+          local[3][2] = XMVectorMultiplyAdd(radius, orbitSin, LoadLanes(animations.centerZ, idx));
+          for (int r = 0; r < 3; r++)
+          {
+               XMVECTOR x = LoadLanes(animations.rest[r][0], idx);
+               XMVECTOR z = LoadLanes(animations.rest[r][2], idx);
+               local[r][0] = XMVectorMultiplyAdd(z, spinSin, XMVectorMultiply(x, spinCos));
+               local[r][1] = LoadLanes(animations.rest[r][1], idx);
+               local[r][2] = XMVectorNegativeMultiplySubtract(x, spinSin, XMVectorMultiply(z, spinCos));
+          }
+
+          // World transform is the motion followed by the base frame.
+          XMVECTOR base[4][3];
+          for (int r = 0; r < 4; r++)
+          {
+               for (int c = 0; c < 3; c++)
+               {
+                    base[r][c] = LoadLanes(animations.base[r][c], idx);
+               }
+          }
+          XMVECTOR m[4][3];
+          for (int r = 0; r < 4; r++)
+          {
+               for (int c = 0; c < 3; c++)
+               {
+                    XMVECTOR value = r == 3 ? base[3][c] : XMVectorZero();
+                    value = XMVectorMultiplyAdd(local[r][0], base[0][c], value);
+                    value = XMVectorMultiplyAdd(local[r][1], base[1][c], value);
+                    m[r][c] = XMVectorMultiplyAdd(local[r][2], base[2][c], value);
+               }
+          }
+
+          // Lanes without motion keep their transforms.
+          uint32_t laneMask[4];
+          for (size_t lane = 0; lane < 4; ++lane)
+          {
+               laneMask[lane] = animations.flags[idx + lane] ? 0xFFFFFFFF : 0;
+               if (laneMask[lane])
+               {
+                    transforms.dirty[idx + lane] = 1;
+                    ++animated;
+               }
+          }
+          XMVECTOR select = XMLoadInt4(laneMask);
+          for (int r = 0; r < 4; r++)
+          {
+               for (int c = 0; c < 3; c++)
+               {
+                    StoreLanes(transforms.m[r][c], idx, XMVectorSelect(LoadLanes(transforms.m[r][c], idx), m[r][c], select));
+               }
+          }
+     }
+
+     for (; idx < end; ++idx)
+     {
+          if (!animations.flags[idx])
+          {
+               continue;
+          }
+
+          float phase = animations.phase[idx];
+          float orbitAngle = animations.orbitSpeed[idx] * time + phase;
+          float spinAngle = animations.spinSpeed[idx] * time;
+          float spinSin = sinf(spinAngle);
+          float spinCos = cosf(spinAngle);
+          float local[4][3];
+          local[3][0] = animations.centerX[idx] + animations.orbitRadius[idx] * cosf(orbitAngle);
+          local[3][1] = animations.centerY[idx] + animations.bobAmplitude[idx] * sinf(animations.bobSpeed[idx] * time + phase);
+          local[3][2] = animations.centerZ[idx] + animations.orbitRadius[idx] * sinf(orbitAngle);
+          for (int r = 0; r < 3; r++)
+          {
+               float x = animations.rest[r][0][idx];
+               float z = animations.rest[r][2][idx];
+               local[r][0] = x * spinCos + z * spinSin;
+               local[r][1] = animations.rest[r][1][idx];
+               local[r][2] = z * spinCos - x * spinSin;
+          }
+          for (int r = 0; r < 4; r++)
+          {
+               for (int c = 0; c < 3; c++)
+               {
+                    float value = r == 3 ? animations.base[3][c][idx] : 0.0f;
+                    value += local[r][0] * animations.base[0][c][idx];
+                    value += local[r][1] * animations.base[1][c][idx];
+                    transforms.m[r][c][idx] = value + local[r][2] * animations.base[2][c][idx];
+               }
+          }
+          transforms.dirty[idx] = 1;
+          ++animated;
+     }
+     return animated;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Transforms.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+// Kinds of procedural motion, an instance may combine several of them
+enum MotionFlags : uint8_t
+{
+     MotionNone = 0,
+     // Circle of orbitRadius around center in the xz plane
+     MotionOrbit = 1,
+     // Sine offset of bobAmplitude along y
+     MotionBob = 2,
+     // Rotation about the y axis through the instance origin
+     MotionSpin = 4
+};
+
+// Parametric motion of an instance. Speeds are in radians per second, phase shifts orbit and bob
+struct Motion
+{
+     uint8_t flags = MotionNone;
+     // Orbit center, the instance position when it does not orbit. In the base frame of the instance
+     DirectX::XMFLOAT3 center = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+     float orbitRadius = 0.0f;
+     float orbitSpeed = 0.0f;
+     float bobAmplitude = 0.0f;
+     float bobSpeed = 0.0f;
+     float spinSpeed = 0.0f;
+     float phase = 0.0f;
+};
+
+// Motions stored as structure of arrays. Parameters of motion kinds an instance does not have are
+// zero, so every instance is evaluated with the same formula
+struct AnimationsSoA
+{
+     std::vector<uint8_t> flags;
+     // Rotation-scale rows of the rest transform, rest[r][c] like TransformsSoA::m
+     std::vector<float> rest[3][3];
+     // Frame the motion happens in, rows like TransformsSoA::m. Identity unless the instance follows
+     // a scene node, then it is the world transform of the node
+     std::vector<float> base[4][3];
+     std::vector<float> centerX;
+     std::vector<float> centerY;
+     std::vector<float> centerZ;
+     std::vector<float> orbitRadius;
+     std::vector<float> orbitSpeed;
+     std::vector<float> bobAmplitude;
+     std::vector<float> bobSpeed;
+     std::vector<float> spinSpeed;
+     std::vector<float> phase;
+
+     size_t Size() const { return flags.size(); }
+
+     void Resize(size_t count);
+     // Function to set motion of instance with rest transform, only rotation and scale of rest are used
+     void Set(size_t idx, const Motion& motion, DirectX::FXMMATRIX restTransform);
+     // Function to set frame of motion, center and rest pose are relative to it
+     void SetBase(size_t idx, DirectX::FXMMATRIX baseTransform);
+     DirectX::XMMATRIX GetBase(size_t idx) const;
+     void Copy(size_t from, size_t to);
+};
+
+// Function to evaluate motions of [begin, end) at time in seconds and apply them on top of their base frames,
+// transforms of animated instances are overwritten and flagged dirty. Returns the number of animated instances, transform version is not changed
+size_t AnimateTransforms(const AnimationsSoA& animations, float time, size_t begin, size_t end, TransformsSoA& transforms);
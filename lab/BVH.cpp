@@ -0,0 +1,301 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <future>
+#include <thread>
+
+namespace
+{
+     float HalfArea(FXMVECTOR min, FXMVECTOR max)
+     {
+          XMFLOAT3 size;
+          XMStoreFloat3(&size, XMVectorMax(XMVectorSubtract(max, min), XMVectorZero()));
+          return size.x * size.y + size.y * size.z + size.z * size.x;
+     }
+}
+
+void BVH::Build(const BoundsSoA& bounds, const uint32_t* ids, size_t idCount, unsigned threadCount)
+{
+     Clear();
+
+     uint32_t count = static_cast<uint32_t>(idCount);
+     if (count == 0)
+     {
+          return;
+     }
+
+     centers.resize(count);
+     extents.resize(count);
+     indices.resize(count);
+     for (uint32_t i = 0; i < count; ++i)
+     {
+          uint32_t id = ids[i];
+          centers[i] = XMFLOAT3(bounds.centerX[id], bounds.centerY[id], bounds.centerZ[id]);
+          extents[i] = XMFLOAT3(bounds.extentX[id], bounds.extentY[id], bounds.extentZ[id]);
+          indices[i] = i;
+     }
+
+     if (threadCount == 0)
+     {
+          threadCount = std::max(1u, std::thread::hardware_concurrency());
+     }
+     freeThreads = static_cast<int>(threadCount) - 1;
+
+     nodes.resize(2 * static_cast<size_t>(count) - 1);
+     nodeCount = 1;
+     BuildNode(0, 0, count, 0);
+     nodes.resize(nodeCount);
+
+     // Store primitive bounds in hierarchy order so leaves read them sequentially, primitives become ids.
+     std::vector<XMFLOAT3> orderedCenters(count), orderedExtents(count);
+     for (uint32_t i = 0; i < count; ++i)
+     {
+          orderedCenters[i] = centers[indices[i]];
+          orderedExtents[i] = extents[indices[i]];
+          indices[i] = ids[indices[i]];
+     }
+     centers.swap(orderedCenters);
+     extents.swap(orderedExtents);
+}
+
+void BVH::Clear()
+{
+     nodes.clear();
+     indices.clear();
+     centers.clear();
+     extents.clear();
+     nodeCount = 0;
+}
+
+void BVH::MakeLeaf(uint32_t nodeIdx, uint32_t first, uint32_t count)
+{
+     nodes[nodeIdx].first = first;
+     nodes[nodeIdx].count = count;
+     nodes[nodeIdx].child = 0;
+}
+
+void BVH::BuildNode(uint32_t nodeIdx, uint32_t first, uint32_t count, int depth)
+{
+     // Calculate node bounds and bounds of primitive centers.
+     XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+     XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+     XMVECTOR centroidMin = boundsMin;
+     XMVECTOR centroidMax = boundsMax;
+     for (uint32_t i = first; i < first + count; ++i)
+     {
+          XMVECTOR center = XMLoadFloat3(&centers[indices[i]]);
+          XMVECTOR extent = XMLoadFloat3(&extents[indices[i]]);
+          boundsMin = XMVectorMin(boundsMin, XMVectorSubtract(center, extent));
+          boundsMax = XMVectorMax(boundsMax, XMVectorAdd(center, extent));
+          centroidMin = XMVectorMin(centroidMin, center);
+          centroidMax = XMVectorMax(centroidMax, center);
+     }
+
+     Node& node = nodes[nodeIdx];
+     XMStoreFloat3(&node.center, XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f));
+     XMStoreFloat3(&node.extent, XMVectorScale(XMVectorSubtract(boundsMax, boundsMin), 0.5f));
+
+     if (count <= maxLeafSize || depth >= maxDepth - 1)
+     {
+          MakeLeaf(nodeIdx, first, count);
+          return;
+     }
+
+     // Split along the axis with the largest spread of centers.
+     XMFLOAT3 cMin, cSize;
+     XMStoreFloat3(&cMin, centroidMin);
+     XMStoreFloat3(&cSize, XMVectorSubtract(centroidMax, centroidMin));
+     int axis = 0;
+     float axisSize = cSize.x;
+     float axisMin = cMin.x;
+     if (cSize.y > axisSize)
+     {
+          axis = 1;
+          axisSize = cSize.y;
+          axisMin = cMin.y;
+     }
+     if (cSize.z > axisSize)
+     {
+          axis = 2;
+          axisSize = cSize.z;
+          axisMin = cMin.z;
+     }
+
+     uint32_t mid = first + count / 2;
+     auto axisValue = [axis](const XMFLOAT3& v) { return axis == 0 ? v.x : (axis == 1 ? v.y : v.z); };
+     if (axisSize > 0.0f)
+     {
+          struct Bin
+          {
+               XMVECTOR min;
+               XMVECTOR max;
+               uint32_t count;
+          };
+          Bin bins[binCount];
+          for (int b = 0; b < binCount; ++b)
+          {
+               bins[b] = { XMVectorReplicate(FLT_MAX), XMVectorReplicate(-FLT_MAX), 0 };
+          }
+
+          const float scale = binCount / axisSize;
+          auto binIndex = [&](uint32_t prim)
+          {
+               int b = static_cast<int>((axisValue(centers[prim]) - axisMin) * scale);
+               return std::min(b, binCount - 1);
+          };
+
+          for (uint32_t i = first; i < first + count; ++i)
+          {
+               Bin& bin = bins[binIndex(indices[i])];
+               XMVECTOR center = XMLoadFloat3(&centers[indices[i]]);
+               XMVECTOR extent = XMLoadFloat3(&extents[indices[i]]);
+               bin.min = XMVectorMin(bin.min, XMVectorSubtract(center, extent));
+               bin.max = XMVectorMax(bin.max, XMVectorAdd(center, extent));
+               bin.count++;
+          }
+
+          // Sweep bins from the right to get cost of every right side, then from the left to pick the best plane.
+          float rightCost[binCount];
+          XMVECTOR accMin = XMVectorReplicate(FLT_MAX);
+          XMVECTOR accMax = XMVectorReplicate(-FLT_MAX);
+          uint32_t accCount = 0;
+          for (int b = binCount - 1; b > 0; --b)
+          {
+               accMin = XMVectorMin(accMin, bins[b].min);
+               accMax = XMVectorMax(accMax, bins[b].max);
+               accCount += bins[b].count;
+               rightCost[b] = accCount ? HalfArea(accMin, accMax) * accCount : 0.0f;
+          }
+
+          float bestCost = FLT_MAX;
+          int bestSplit = -1;
+          accMin = XMVectorReplicate(FLT_MAX);
+          accMax = XMVectorReplicate(-FLT_MAX);
+          accCount = 0;
+          for (int b = 0; b < binCount - 1; ++b)
+          {
+               accMin = XMVectorMin(accMin, bins[b].min);
+               accMax = XMVectorMax(accMax, bins[b].max);
+               accCount += bins[b].count;
+               if (accCount == 0 || accCount == count)
+               {
+                    continue;
+               }
+               float cost = HalfArea(accMin, accMax) * accCount + rightCost[b + 1];
+               if (cost < bestCost)
+               {
+                    bestCost = cost;
+                    bestSplit = b;
+               }
+          }
+
+          float leafCost = HalfArea(boundsMin, boundsMax) * count;
+          if (bestSplit < 0)
+          {
+               // All centers fell into a single bin, fall back to a median split.
+               std::nth_element(indices.begin() + first, indices.begin() + mid, indices.begin() + first + count,
+                    [&](uint32_t a, uint32_t b) { return axisValue(centers[a]) < axisValue(centers[b]); });
+          }
+          else if (bestCost >= leafCost && count <= 4 * maxLeafSize)
+          {
+               MakeLeaf(nodeIdx, first, count);
+               return;
+          }
+          else
+          {
+               auto splitIt = std::partition(indices.begin() + first, indices.begin() + first + count,
+                    [&](uint32_t prim) { return binIndex(prim) <= bestSplit; });
+               mid = static_cast<uint32_t>(splitIt - indices.begin());
+          }
+     }
+     else if (count <= 4 * maxLeafSize)
+     {
+          // Coincident centers cannot be separated spatially.
+          MakeLeaf(nodeIdx, first, count);
+          return;
+     }
+
+     uint32_t child = nodeCount.fetch_add(2);
+     node.first = first;
+     node.count = count;
+     node.child = child;
+
+     // Hand the left subtree to another thread while there are free ones.
+     bool parallel = false;
+     if (count > parallelThreshold)
+     {
+          int free = freeThreads.load();
+          while (free > 0 && !freeThreads.compare_exchange_weak(free, free - 1))
+          {
+          }
+          parallel = free > 0;
+     }
+
+     uint32_t leftCount = mid - first;
+     if (parallel)
+     {
+          auto left = std::async(std::launch::async, [=]() { BuildNode(child, first, leftCount, depth + 1); });
+          BuildNode(child + 1, mid, count - leftCount, depth + 1);
+          left.wait();
+          freeThreads.fetch_add(1);
+     }
+     else
+     {
+          BuildNode(child, first, leftCount, depth + 1);
+          BuildNode(child + 1, mid, count - leftCount, depth + 1);
+     }
+}
+
+void BVH::Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+     if (nodes.empty())
+     {
+          return;
+     }
+
+     struct StackEntry
+     {
+          uint32_t node;
+          uint32_t planeMask;
+     };
+     StackEntry stack[maxDepth + 1];
+     int stackSize = 0;
+     stack[stackSize++] = { 0, Frustum::allPlanesMask };
+
+     while (stackSize > 0)
+     {
+          StackEntry entry = stack[--stackSize];
+          const Node& node = nodes[entry.node];
+
+          uint32_t planeMask = entry.planeMask;
+          FrustumTest result = frustum.CheckAABB(node.center, node.extent, planeMask);
+          if (result == FrustumTest::Outside)
+          {
+               continue;
+          }
+
+          if (result == FrustumTest::Inside)
+          {
+               // Whole subtree is visible, its primitives are stored contiguously.
+               visible.insert(visible.end(), indices.begin() + node.first, indices.begin() + node.first + node.count);
+               continue;
+          }
+
+          if (node.child)
+          {
+               stack[stackSize++] = { node.child + 1, planeMask };
+               stack[stackSize++] = { node.child, planeMask };
+               continue;
+          }
+
+          for (uint32_t i = node.first; i < node.first + node.count; ++i)
+          {
+               uint32_t primMask = planeMask;
+               if (frustum.CheckAABB(centers[i], extents[i], primMask) != FrustumTest::Outside)
+               {
+                    visible.push_back(indices[i]);
+               }
+          }
+     }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Frustum.h"
+
+#include <DirectXMath.h>
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+// Static bounding volume hierarchy over instance bounds built with binned SAH
+class BVH
+{
+public:
+     // Function to build hierarchy over boxes ids[0..idCount) of bounds, subtrees are built in parallel
+     // on up to threadCount threads
+     void Build(const BoundsSoA& bounds, const uint32_t* ids, size_t idCount, unsigned threadCount = 0);
+     // Function to append ids of boxes in frustum to visible
+     void Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+     void Clear();
+
+     size_t GetNodeCount() const { return nodes.size(); }
+private:
+     struct Node
+     {
+          XMFLOAT3 center;
+          XMFLOAT3 extent;
+          uint32_t first;  // first primitive of the subtree in indices
+          uint32_t count;  // number of primitives in the subtree
+          uint32_t child;  // index of the left child, right one follows it; 0 for leaves
+     };
+
+     static constexpr uint32_t maxLeafSize = 4;
+     static constexpr int binCount = 16;
+     static constexpr uint32_t parallelThreshold = 4096;
+     static constexpr int maxDepth = 64;
+
+     void BuildNode(uint32_t nodeIdx, uint32_t first, uint32_t count, int depth);
+     void MakeLeaf(uint32_t nodeIdx, uint32_t first, uint32_t count);
+
+     std::vector<Node> nodes;
+     // Ids of the boxes in hierarchy order, every node covers a contiguous range
+     std::vector<uint32_t> indices;
+     std::vector<XMFLOAT3> centers;
+     std::vector<XMFLOAT3> extents;
+
+     std::atomic<uint32_t> nodeCount{ 0 };
+     std::atomic<int> freeThreads{ 0 };
+};
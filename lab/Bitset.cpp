@@ -0,0 +1,43 @@
+#include "Bitset.h"
+
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+namespace
+{
+     // Lane offsets of set bits for every 4-bit mask, left packed.
+     alignas(16) const uint32_t leftPackTable[16][4] = {
+          { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 1, 0, 0, 0 }, { 0, 1, 0, 0 },
+          { 2, 0, 0, 0 }, { 0, 2, 0, 0 }, { 1, 2, 0, 0 }, { 0, 1, 2, 0 },
+          { 3, 0, 0, 0 }, { 0, 3, 0, 0 }, { 1, 3, 0, 0 }, { 0, 1, 3, 0 },
+          { 2, 3, 0, 0 }, { 0, 2, 3, 0 }, { 1, 2, 3, 0 }, { 0, 1, 2, 3 },
+     };
+
+     const uint8_t bitCountTable[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+}
+
+size_t CompactBitset(const Bitset& bitset, uint32_t* output)
+{
+     size_t written = 0;
+     for (size_t word = 0; word < bitset.GetWordCount(); ++word)
+     {
+          uint32_t bits = bitset.words[word];
+          if (!bits)
+          {
+               continue;
+          }
+
+          // Index of a nibble start is a multiple of 4, so adding a lane offset is a bitwise or.
+          // Nibbles are stored unconditionally and the write position only advances by their bit count.
+          uint32_t base = static_cast<uint32_t>(word * 32);
+          for (; bits; bits >>= 4, base += 4)
+          {
+               uint32_t nibble = bits & 0xF;
+               XMVECTOR packed = XMVectorOrInt(XMVectorReplicateInt(base), XMLoadInt4A(leftPackTable[nibble]));
+               XMStoreInt4(output + written, packed);
+               written += bitCountTable[nibble];
+          }
+     }
+     return written;
+}
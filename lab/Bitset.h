@@ -0,0 +1,33 @@
+#pragma once
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+// Bit per instance, 32 instances per word. Bits past Size() are always zero.
+struct Bitset
+{
+     std::vector<uint32_t> words;
+     size_t count = 0;
+
+     size_t Size() const { return count; }
+     size_t GetWordCount() const { return words.size(); }
+
+     void Resize(size_t newCount)
+     {
+          count = newCount;
+          words.assign((newCount + 31) / 32, 0);
+     }
+
+     void Clear()
+     {
+          std::fill(words.begin(), words.end(), 0);
+     }
+
+     void Set(size_t idx) { words[idx >> 5] |= 1u << (idx & 31); }
+     bool Test(size_t idx) const { return (words[idx >> 5] >> (idx & 31)) & 1; }
+};
+
+// Function to write indices of set bits in ascending order, returns number of written indices.
+// Four indices are stored at a time, so output must have room for Size() + 3 values
+size_t CompactBitset(const Bitset& bitset, uint32_t* output);
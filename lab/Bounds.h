@@ -0,0 +1,47 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+// Axis aligned bounding boxes in center/extent form stored as structure of arrays
+struct BoundsSoA
+{
+     std::vector<float> centerX;
+     std::vector<float> centerY;
+     std::vector<float> centerZ;
+     std::vector<float> extentX;
+     std::vector<float> extentY;
+     std::vector<float> extentZ;
+
+     size_t Size() const { return centerX.size(); }
+
+     void Resize(size_t count)
+     {
+          centerX.resize(count);
+          centerY.resize(count);
+          centerZ.resize(count);
+          extentX.resize(count);
+          extentY.resize(count);
+          extentZ.resize(count);
+     }
+
+     void Set(size_t idx, const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extent)
+     {
+          centerX[idx] = center.x;
+          centerY[idx] = center.y;
+          centerZ[idx] = center.z;
+          extentX[idx] = extent.x;
+          extentY[idx] = extent.y;
+          extentZ[idx] = extent.z;
+     }
+
+     void Copy(size_t from, size_t to)
+     {
+          centerX[to] = centerX[from];
+          centerY[to] = centerY[from];
+          centerZ[to] = centerZ[from];
+          extentX[to] = extentX[from];
+          extentY[to] = extentY[from];
+          extentZ[to] = extentZ[from];
+     }
+};
@@ -20,16 +20,28 @@ const DirectX::XMMATRIX& Camera::GetViewMatrix() const
 
 void Camera::MoveCamera(float dPhi, float dTheta, float dR)
 {
-     phi -= dPhi;
-     theta += dTheta;
-     theta = std::min(std::max(theta, -XM_PIDIV2), XM_PIDIV2);
-     r += dR;
-     if (r < 1.0f) {
-          r = 1.0f;
+     float newPhi = phi - dPhi;
+     float newTheta = std::min(std::max(theta + dTheta, -XM_PIDIV2), XM_PIDIV2);
+     float newR = r + dR;
+     if (newR < 1.0f) {
+          newR = 1.0f;
      }
+     if (newPhi == phi && newTheta == theta && newR == r) {
+          return;
+     }
+
+     phi = newPhi;
+     theta = newTheta;
+     r = newR;
+     ++version;
      CalcMatrix();
 }
 
+uint64_t Camera::GetVersion() const
+{
+     return version;
+}
+
 XMFLOAT3 Camera::GetPosition() const
 {
      XMFLOAT3 eye = XMFLOAT3(cosf(theta) * cosf(phi), sinf(theta), cosf(theta) * sinf(phi));
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <directxmath.h>
+#include <DirectXMath.h>
+#include <stdint.h>
 
 class Camera
 {
@@ -13,12 +14,15 @@ public:
      const DirectX::XMMATRIX& GetViewMatrix() const;
      void MoveCamera(float dPhi, float dTheta, float dR);
      DirectX::XMFLOAT3 GetPosition() const;
+     // Function to get counter that changes whenever the view matrix changes
+     uint64_t GetVersion() const;
 private:
      DirectX::XMMATRIX viewMatrix;
      DirectX::XMFLOAT3 focus;
      float phi;
      float theta;
      float r;
+     uint64_t version = 0;
 
      inline void CalcMatrix();
 };
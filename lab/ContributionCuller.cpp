@@ -0,0 +1,95 @@
+#include "ContributionCuller.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+void ContributionCuller::Init(float minPixelArea)
+{
+     SetMinPixelArea(minPixelArea);
+}
+
+void ContributionCuller::SetMinPixelArea(float minPixelArea)
+{
+     this->minPixelArea = minPixelArea;
+     areaScale = minPixelArea > 0.0f ? XM_PI * pixelScale * pixelScale / minPixelArea : std::numeric_limits<float>::infinity();
+}
+
+float ContributionCuller::GetMinPixelArea() const
+{
+     return minPixelArea;
+}
+
+void ContributionCuller::Setup(const XMFLOAT3& viewPosition, const XMMATRIX& projection, unsigned viewportHeight)
+{
+     this->viewPosition = viewPosition;
+     XMFLOAT4X4 proj;
+     XMStoreFloat4x4(&proj, projection);
+     pixelScale = proj._22 * viewportHeight * 0.5f;
+     SetMinPixelArea(minPixelArea);
+}
+
+void ContributionCuller::Cull(const BoundsSoA& bounds, const float* maxDistance, size_t begin, size_t end, uint8_t* visible) const
+{
+     // With r the bounding sphere radius and d the distance to its center, the sphere covers
+     // pi * (r * pixelScale / d)^2 pixels. Tests compare squared distances:
+     // too small when r^2 * areaScale < d^2, too far when (maxDistance + r)^2 < d^2.
+     const XMVECTOR px = XMVectorReplicate(viewPosition.x);
+     const XMVECTOR py = XMVectorReplicate(viewPosition.y);
+     const XMVECTOR pz = XMVectorReplicate(viewPosition.z);
+     const XMVECTOR scale = XMVectorReplicate(areaScale);
+
+     size_t idx = begin;
+     for (; idx + 4 <= end; idx += 4)
+     {
+          uint32_t flags;
+          memcpy(&flags, visible + idx, sizeof(flags));
+          if (!flags)
+          {
+               continue;
+          }
+
+          XMVECTOR dx = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bounds.centerX[idx])), px);
+          XMVECTOR dy = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bounds.centerY[idx])), py);
+          XMVECTOR dz = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bounds.centerZ[idx])), pz);
+          XMVECTOR distanceSq = XMVectorMultiplyAdd(dz, dz, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dx, dx)));
+
+          XMVECTOR ex = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bounds.extentX[idx]));
+          XMVECTOR ey = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bounds.extentY[idx]));
+          XMVECTOR ez = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bounds.extentZ[idx]));
+          XMVECTOR radiusSq = XMVectorMultiplyAdd(ez, ez, XMVectorMultiplyAdd(ey, ey, XMVectorMultiply(ex, ex)));
+
+          XMVECTOR reach = XMVectorAdd(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(maxDistance + idx)), XMVectorSqrt(radiusSq));
+
+          XMVECTOR rejected = XMVectorOrInt(
+               XMVectorLess(XMVectorMultiply(radiusSq, scale), distanceSq),
+               XMVectorLess(XMVectorMultiply(reach, reach), distanceSq));
+
+          uint32_t lanes[4];
+          XMStoreInt4(lanes, rejected);
+          for (int lane = 0; lane < 4; lane++)
+          {
+               visible[idx + lane] &= static_cast<uint8_t>(~lanes[lane] & 1);
+          }
+     }
+
+     for (; idx < end; ++idx)
+     {
+          if (!visible[idx])
+          {
+               continue;
+          }
+
+          float dx = bounds.centerX[idx] - viewPosition.x;
+          float dy = bounds.centerY[idx] - viewPosition.y;
+          float dz = bounds.centerZ[idx] - viewPosition.z;
+          float distanceSq = dx * dx + dy * dy + dz * dz;
+          float radiusSq = bounds.extentX[idx] * bounds.extentX[idx] + bounds.extentY[idx] * bounds.extentY[idx]
+               + bounds.extentZ[idx] * bounds.extentZ[idx];
+          float reach = maxDistance[idx] + sqrtf(radiusSq);
+          if (radiusSq * areaScale < distanceSq || reach * reach < distanceSq)
+          {
+               visible[idx] = 0;
+          }
+     }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Bounds.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+
+using namespace DirectX;
+
+// Rejects instances whose bounding sphere covers too few pixels or lies beyond their max draw distance
+class ContributionCuller
+{
+public:
+     // Function to set pixel area threshold, zero disables the size test
+     void Init(float minPixelArea);
+     void SetMinPixelArea(float minPixelArea);
+     float GetMinPixelArea() const;
+
+     // Function to set view position and pixel scale from a perspective projection and viewport height
+     void Setup(const XMFLOAT3& viewPosition, const XMMATRIX& projection, unsigned viewportHeight);
+
+     // Function to clear visible flags of boxes in [begin, end) that fail the size or distance test
+     void Cull(const BoundsSoA& bounds, const float* maxDistance, size_t begin, size_t end, uint8_t* visible) const;
+private:
+     XMFLOAT3 viewPosition = XMFLOAT3(0.0f, 0.0f, 0.0f);
+     float minPixelArea = 0.0f;
+     // pi * pixelScale^2 / minPixelArea, infinite when the size test is disabled
+     float areaScale = 0.0f;
+     float pixelScale = 0.0f;
+};
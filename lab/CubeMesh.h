@@ -0,0 +1,29 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <stdint.h>
+
+// Positions and triangles of the unit cube centered at the origin, the same faces and winding
+// as the renderer cube. Headless code rasterizes it as an occluder
+static const DirectX::XMFLOAT3 cubePositions[24] = {
+     {-0.5f, -0.5f, 0.5f}, {0.5f, -0.5f, 0.5f}, {0.5f, -0.5f, -0.5f}, {-0.5f, -0.5f, -0.5f},
+     {-0.5f, 0.5f, -0.5f}, {0.5f, 0.5f, -0.5f}, {0.5f, 0.5f, 0.5f}, {-0.5f, 0.5f, 0.5f},
+     {0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, 0.5f}, {0.5f, 0.5f, 0.5f}, {0.5f, 0.5f, -0.5f},
+     {-0.5f, -0.5f, 0.5f}, {-0.5f, -0.5f, -0.5f}, {-0.5f, 0.5f, -0.5f}, {-0.5f, 0.5f, 0.5f},
+     {0.5f, -0.5f, 0.5f}, {-0.5f, -0.5f, 0.5f}, {-0.5f, 0.5f, 0.5f}, {0.5f, 0.5f, 0.5f},
+     {-0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, -0.5f}, {-0.5f, 0.5f, -0.5f}
+};
+
+static const uint16_t cubeIndices[36] = {
+     0, 2, 1, 0, 3, 2,
+     4, 6, 5, 4, 7, 6,
+     8, 10, 9, 8, 11, 10,
+     12, 14, 13, 12, 15, 14,
+     16, 18, 17, 16, 19, 18,
+     20, 22, 21, 20, 23, 22
+};
+
+// LOD chain of the cube from the most detailed level: every face is split into a grid of
+// cubeLodSubdivisions[l] squares per side, the level is used from cubeLodScreenRadius[l] pixels
+static const unsigned cubeLodSubdivisions[3] = { 4, 2, 1 };
+static const float cubeLodScreenRadius[3] = { 80.0f, 30.0f, 0.0f };
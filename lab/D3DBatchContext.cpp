@@ -0,0 +1,94 @@
+#include "D3DBatchContext.h"
+#include "utils.h"
+
+#include <string.h>
+
+HRESULT D3DBatchContext::Init(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext, size_t pageSize)
+{
+     this->pDevice = pDevice;
+     this->pDeviceContext = pDeviceContext;
+
+     D3D11_BUFFER_DESC desc = {};
+     desc.ByteWidth = static_cast<UINT>(sizeof(uint32_t) * pageSize);
+     desc.Usage = D3D11_USAGE_DYNAMIC;
+     desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+     desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+     desc.MiscFlags = 0;
+     desc.StructureByteStride = 0;
+
+     return pDevice->CreateBuffer(&desc, NULL, &pIdBuffer);
+}
+
+void D3DBatchContext::Bind()
+{
+     pDeviceContext->VSSetShaderResources(2, 1, &pInstanceView);
+     pDeviceContext->PSSetShaderResources(2, 1, &pInstanceView);
+     pDeviceContext->VSSetConstantBuffers(2, 1, &pIdBuffer);
+}
+
+bool D3DBatchContext::CreateInstanceBuffer(size_t capacity, size_t stride)
+{
+     SAFE_RELEASE(pInstanceView);
+     SAFE_RELEASE(pInstanceBuffer);
+     pInstanceView = nullptr;
+     pInstanceBuffer = nullptr;
+
+     D3D11_BUFFER_DESC desc = {};
+     desc.ByteWidth = static_cast<UINT>(capacity * stride);
+     desc.Usage = D3D11_USAGE_DEFAULT;
+     desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+     desc.CPUAccessFlags = 0;
+     desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+     desc.StructureByteStride = static_cast<UINT>(stride);
+     if (FAILED(pDevice->CreateBuffer(&desc, NULL, &pInstanceBuffer)))
+     {
+          return false;
+     }
+
+     D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+     viewDesc.Format = DXGI_FORMAT_UNKNOWN;
+     viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+     viewDesc.Buffer.FirstElement = 0;
+     viewDesc.Buffer.NumElements = static_cast<UINT>(capacity);
+     return SUCCEEDED(pDevice->CreateShaderResourceView(pInstanceBuffer, &viewDesc, &pInstanceView));
+}
+
+bool D3DBatchContext::UploadInstances(const void* data, size_t size)
+{
+     // Only the used part of the buffer is written.
+     D3D11_BOX box = { 0, 0, 0, static_cast<UINT>(size), 1, 1 };
+     pDeviceContext->UpdateSubresource(pInstanceBuffer, 0, &box, data, 0, 0);
+     return true;
+}
+
+bool D3DBatchContext::UploadIds(const uint32_t* ids, size_t count)
+{
+     D3D11_MAPPED_SUBRESOURCE subresource;
+     HRESULT result = pDeviceContext->Map(pIdBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subresource);
+     if (SUCCEEDED(result))
+     {
+          memcpy(subresource.pData, ids, sizeof(uint32_t) * count);
+          pDeviceContext->Unmap(pIdBuffer, 0);
+     }
+     return SUCCEEDED(result);
+}
+
+void D3DBatchContext::DrawIndexedInstanced(const BatchMesh& mesh, size_t instanceCount)
+{
+     pDeviceContext->DrawIndexedInstanced(mesh.indexCount, static_cast<UINT>(instanceCount), mesh.startIndex, mesh.baseVertex, 0);
+}
+
+void D3DBatchContext::Cleanup()
+{
+     SAFE_RELEASE(pInstanceView);
+     SAFE_RELEASE(pInstanceBuffer);
+     SAFE_RELEASE(pIdBuffer);
+     pInstanceView = nullptr;
+     pInstanceBuffer = nullptr;
+     pIdBuffer = nullptr;
+}
+
+D3DBatchContext::~D3DBatchContext()
+{
+     Cleanup();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "InstanceBatcher.h"
+
+#include <d3d11.h>
+
+// Batch context over D3D11: instance data in a structured buffer at t2 of both shader stages
+// and the id page in a dynamic constant buffer at b2 of the vertex shader
+class D3DBatchContext : public BatchContext
+{
+public:
+     HRESULT Init(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext, size_t pageSize);
+     // Function to bind buffers, has to be repeated after the instance buffer is recreated
+     void Bind();
+     void Cleanup();
+     ~D3DBatchContext();
+
+     bool CreateInstanceBuffer(size_t capacity, size_t stride) override;
+     bool UploadInstances(const void* data, size_t size) override;
+     bool UploadIds(const uint32_t* ids, size_t count) override;
+     void DrawIndexedInstanced(const BatchMesh& mesh, size_t instanceCount) override;
+private:
+     ID3D11Device* pDevice = nullptr;
+     ID3D11DeviceContext* pDeviceContext = nullptr;
+
+     ID3D11Buffer* pInstanceBuffer = nullptr;
+     ID3D11ShaderResourceView* pInstanceView = nullptr;
+     ID3D11Buffer* pIdBuffer = nullptr;
+};
@@ -0,0 +1,157 @@
+#include "DemoScene.h"
+#include "CubeMesh.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+     const size_t ringInstances = 20;
+     const size_t portalRooms = 3;
+     const float wallThickness = 0.2f;
+
+     // Function to add cube scaled to the box between min and max to every cell of the list
+     InstanceHandle AddBox(Scene& scene, const XMFLOAT3& min, const XMFLOAT3& max, uint16_t material, const int* cells, size_t cellCount)
+     {
+          XMMATRIX world = XMMatrixMultiply(XMMatrixScaling(max.x - min.x, max.y - min.y, max.z - min.z),
+               XMMatrixTranslation((min.x + max.x) / 2, (min.y + max.y) / 2, (min.z + max.z) / 2));
+          InstanceHandle handle = scene.AddInstance(world, material);
+          for (size_t i = 0; i < cellCount; ++i)
+          {
+               scene.AddInstanceToCell(cells[i], handle);
+          }
+          return handle;
+     }
+
+     // Function to add wall across z at depth z with doorway in the middle when door is set
+     void AddCrossWall(Scene& scene, const XMFLOAT3& origin, float z, bool door, uint16_t material, const int* cells, size_t cellCount)
+     {
+          float half = portalRoomSize / 2;
+          float t = wallThickness / 2;
+          if (!door)
+          {
+               AddBox(scene, XMFLOAT3(origin.x - half, origin.y, z - t), XMFLOAT3(origin.x + half, origin.y + portalRoomHeight, z + t),
+                    material, cells, cellCount);
+               return;
+          }
+
+          float doorHalf = portalDoorWidth / 2;
+          AddBox(scene, XMFLOAT3(origin.x - half, origin.y, z - t), XMFLOAT3(origin.x - doorHalf, origin.y + portalRoomHeight, z + t),
+               material, cells, cellCount);
+          AddBox(scene, XMFLOAT3(origin.x + doorHalf, origin.y, z - t), XMFLOAT3(origin.x + half, origin.y + portalRoomHeight, z + t),
+               material, cells, cellCount);
+          AddBox(scene, XMFLOAT3(origin.x - doorHalf, origin.y + portalDoorHeight, z - t),
+               XMFLOAT3(origin.x + doorHalf, origin.y + portalRoomHeight, z + t), material, cells, cellCount);
+     }
+}
+
+std::vector<LodLevel> BuildCubeLodChain()
+{
+     std::vector<LodLevel> chain;
+     uint32_t startIndex = 0;
+     int32_t baseVertex = 0;
+     for (size_t l = 0; l < sizeof(cubeLodSubdivisions) / sizeof(cubeLodSubdivisions[0]); ++l)
+     {
+          unsigned n = cubeLodSubdivisions[l];
+          LodLevel level;
+          level.mesh.startIndex = startIndex;
+          level.mesh.indexCount = 6 * 6 * n * n;
+          level.mesh.baseVertex = baseVertex;
+          level.minScreenRadius = cubeLodScreenRadius[l];
+          chain.push_back(level);
+          startIndex += level.mesh.indexCount;
+          baseVertex += static_cast<int32_t>(6 * (n + 1) * (n + 1));
+     }
+     return chain;
+}
+
+std::vector<PortalRoom> BuildPortalLevel(Scene& scene, const XMFLOAT3& origin, size_t roomCount, uint16_t material)
+{
+     float half = portalRoomSize / 2;
+     float t = wallThickness / 2;
+     std::vector<PortalRoom> rooms(roomCount);
+     for (size_t idx = 0; idx < roomCount; ++idx)
+     {
+          float z = origin.z + portalRoomSize * idx;
+          rooms[idx].cell = scene.AddCell(XMFLOAT3(origin.x, origin.y + portalRoomHeight / 2, z + half),
+               XMFLOAT3(half, portalRoomHeight / 2, half));
+     }
+
+     for (size_t idx = 0; idx < roomCount; ++idx)
+     {
+          float z = origin.z + portalRoomSize * idx;
+          int cell = rooms[idx].cell;
+          AddBox(scene, XMFLOAT3(origin.x - half - t, origin.y, z), XMFLOAT3(origin.x - half + t, origin.y + portalRoomHeight, z + portalRoomSize),
+               material, &cell, 1);
+          AddBox(scene, XMFLOAT3(origin.x + half - t, origin.y, z), XMFLOAT3(origin.x + half + t, origin.y + portalRoomHeight, z + portalRoomSize),
+               material, &cell, 1);
+          if (idx == 0)
+          {
+               AddCrossWall(scene, origin, z, false, material, &cell, 1);
+          }
+          if (idx + 1 == roomCount)
+          {
+               AddCrossWall(scene, origin, z + portalRoomSize, false, material, &cell, 1);
+          }
+          else
+          {
+               // Wall between two rooms belongs to both of them.
+               int cells[2] = { cell, rooms[idx + 1].cell };
+               AddCrossWall(scene, origin, z + portalRoomSize, true, material, cells, 2);
+
+               float doorHalf = portalDoorWidth / 2;
+               float zDoor = z + portalRoomSize;
+               XMFLOAT3 corners[4] = {
+                    XMFLOAT3(origin.x - doorHalf, origin.y, zDoor),
+                    XMFLOAT3(origin.x - doorHalf, origin.y + portalDoorHeight, zDoor),
+                    XMFLOAT3(origin.x + doorHalf, origin.y + portalDoorHeight, zDoor),
+                    XMFLOAT3(origin.x + doorHalf, origin.y, zDoor)
+               };
+               scene.AddPortal(cell, rooms[idx + 1].cell, corners);
+          }
+
+          XMFLOAT3 center(origin.x, origin.y + 0.5f, z + half);
+          rooms[idx].center = AddBox(scene, XMFLOAT3(center.x - 0.5f, origin.y, center.z - 0.5f),
+               XMFLOAT3(center.x + 0.5f, origin.y + 1.0f, center.z + 0.5f), material, &cell, 1);
+          XMFLOAT3 corner(origin.x + half - 1.5f, origin.y + 0.5f, z + portalRoomSize - 1.5f);
+          rooms[idx].corner = AddBox(scene, XMFLOAT3(corner.x - 0.5f, origin.y, corner.z - 0.5f),
+               XMFLOAT3(corner.x + 0.5f, origin.y + 1.0f, corner.z + 0.5f), material, &cell, 1);
+     }
+     return rooms;
+}
+
+void BuildDemoScene(Scene& scene, size_t idsPerDraw)
+{
+     scene.Init(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f), BuildCubeLodChain(), idsPerDraw);
+
+     uint32_t ring = scene.AddSceneNode(SceneGraph::noParent, XMMatrixIdentity());
+     double deltaAngle = XM_2PI / ringInstances;
+     double r = 5.0;
+     for (size_t idx = 0; idx < ringInstances; ++idx)
+     {
+          double angle = deltaAngle * idx;
+          Material material;
+          material.specularPower = 0.1f + 0.1f * idx;
+          material.textureSlice = idx % 2;
+          material.flags = idx % 2 ? static_cast<uint32_t>(MaterialUnlit) : 0u;
+          XMMATRIX local = XMMatrixTranslation(static_cast<float>(r * std::sin(angle)), 0.0f, static_cast<float>(r * std::cos(angle)));
+          InstanceHandle instance = scene.AddInstance(local, scene.AddMaterial(material));
+          scene.AddSceneNode(ring, local, instance);
+
+          // Cubes spin in place at their ring nodes, every other one also bobs.
+          Motion motion;
+          motion.flags = static_cast<uint8_t>(MotionSpin | (idx % 2 ? MotionBob : MotionNone));
+          motion.spinSpeed = 0.5f + 0.1f * idx;
+          motion.bobAmplitude = 0.25f;
+          motion.bobSpeed = 2.0f;
+          motion.phase = static_cast<float>(angle);
+          scene.SetInstanceMotion(instance, motion);
+     }
+
+     Material wall;
+     wall.specularPower = 0.5f;
+     BuildPortalLevel(scene, XMFLOAT3(20.0f, -2.0f, -15.0f), portalRooms, scene.AddMaterial(wall));
+
+     scene.Build();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "LodSelector.h"
+#include "Scene.h"
+
+#include <stddef.h>
+#include <vector>
+
+// Function to get LOD levels of the cube mesh, ranges match the buffers the renderer builds from cubeLodSubdivisions
+std::vector<LodLevel> BuildCubeLodChain();
+
+// Room of the portal level with the cube standing in its middle and the one hidden in its far right corner
+struct PortalRoom
+{
+     int cell = -1;
+     InstanceHandle center;
+     InstanceHandle corner;
+};
+
+// Rooms are portalRoomSize wide and deep, joined one after another along +z by doorways in the middle of the walls
+constexpr float portalRoomSize = 10.0f;
+constexpr float portalRoomHeight = 4.0f;
+constexpr float portalDoorWidth = 2.0f;
+constexpr float portalDoorHeight = 3.0f;
+
+// Function to add closed rooms built of wall cubes, floor of the first room is centered at origin. Every room is a
+// portal cell, doorways are portals between them. Call before Scene::Build
+std::vector<PortalRoom> BuildPortalLevel(Scene& scene, const DirectX::XMFLOAT3& origin, size_t roomCount, uint16_t material);
+
+// Function to fill scene with the demo content and build it: a ring of spinning cubes around the origin and
+// a row of rooms next to it. The renderer and the headless tools show the same scene
+void BuildDemoScene(Scene& scene, size_t idsPerDraw);
@@ -0,0 +1,427 @@
+#include "DynamicAABBTree.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+     float Perimeter(const XMFLOAT3& min, const XMFLOAT3& max)
+     {
+          return (max.x - min.x) + (max.y - min.y) + (max.z - min.z);
+     }
+
+     float UnionPerimeter(const XMFLOAT3& minA, const XMFLOAT3& maxA, const XMFLOAT3& minB, const XMFLOAT3& maxB)
+     {
+          return (std::max(maxA.x, maxB.x) - std::min(minA.x, minB.x))
+               + (std::max(maxA.y, maxB.y) - std::min(minA.y, minB.y))
+               + (std::max(maxA.z, maxB.z) - std::min(minA.z, minB.z));
+     }
+
+     bool Contains(const XMFLOAT3& outerMin, const XMFLOAT3& outerMax, const XMFLOAT3& min, const XMFLOAT3& max)
+     {
+          return outerMin.x <= min.x && outerMin.y <= min.y && outerMin.z <= min.z
+               && max.x <= outerMax.x && max.y <= outerMax.y && max.z <= outerMax.z;
+     }
+}
+
+int32_t DynamicAABBTree::AllocateNode()
+{
+     if (freeList == nullNode)
+     {
+          nodes.emplace_back();
+          nodes.back().parent = nullNode;
+          freeList = static_cast<int32_t>(nodes.size() - 1);
+     }
+
+     int32_t node = freeList;
+     freeList = nodes[node].parent;
+     nodes[node].parent = nullNode;
+     nodes[node].child1 = nullNode;
+     nodes[node].child2 = nullNode;
+     nodes[node].height = 0;
+     nodes[node].userData = 0;
+     nodes[node].lastPlane = 0;
+     return node;
+}
+
+void DynamicAABBTree::FreeNode(int32_t node)
+{
+     nodes[node].parent = freeList;
+     nodes[node].height = -1;
+     freeList = node;
+}
+
+int32_t DynamicAABBTree::CreateProxy(const XMFLOAT3& center, const XMFLOAT3& extent, uint32_t userData)
+{
+     int32_t proxy = AllocateNode();
+     Node& node = nodes[proxy];
+     node.min = XMFLOAT3(center.x - extent.x - fatMargin, center.y - extent.y - fatMargin, center.z - extent.z - fatMargin);
+     node.max = XMFLOAT3(center.x + extent.x + fatMargin, center.y + extent.y + fatMargin, center.z + extent.z + fatMargin);
+     node.userData = userData;
+     InsertLeaf(proxy);
+     ++proxyCount;
+     return proxy;
+}
+
+void DynamicAABBTree::DestroyProxy(int32_t proxy)
+{
+     RemoveLeaf(proxy);
+     FreeNode(proxy);
+     --proxyCount;
+}
+
+bool DynamicAABBTree::MoveProxy(int32_t proxy, const XMFLOAT3& center, const XMFLOAT3& extent)
+{
+     XMFLOAT3 min(center.x - extent.x, center.y - extent.y, center.z - extent.z);
+     XMFLOAT3 max(center.x + extent.x, center.y + extent.y, center.z + extent.z);
+     if (Contains(nodes[proxy].min, nodes[proxy].max, min, max))
+     {
+          return false;
+     }
+
+     RemoveLeaf(proxy);
+     nodes[proxy].min = XMFLOAT3(min.x - fatMargin, min.y - fatMargin, min.z - fatMargin);
+     nodes[proxy].max = XMFLOAT3(max.x + fatMargin, max.y + fatMargin, max.z + fatMargin);
+     InsertLeaf(proxy);
+     return true;
+}
+
+void DynamicAABBTree::InsertLeaf(int32_t leaf)
+{
+     if (root == nullNode)
+     {
+          root = leaf;
+          nodes[root].parent = nullNode;
+          return;
+     }
+
+     // Descend to the sibling that gives the smallest increase of perimeter.
+     const XMFLOAT3 leafMin = nodes[leaf].min;
+     const XMFLOAT3 leafMax = nodes[leaf].max;
+     int32_t index = root;
+     while (!nodes[index].IsLeaf())
+     {
+          const Node& node = nodes[index];
+          float perimeter = Perimeter(node.min, node.max);
+          float combined = UnionPerimeter(node.min, node.max, leafMin, leafMax);
+
+          // Cost of creating a new parent for this node and the leaf, and minimum cost of pushing the leaf further down.
+          float cost = 2.0f * combined;
+          float inheritanceCost = 2.0f * (combined - perimeter);
+
+          float childCost[2];
+          for (int i = 0; i < 2; i++)
+          {
+               const Node& child = nodes[i == 0 ? node.child1 : node.child2];
+               float childCombined = UnionPerimeter(child.min, child.max, leafMin, leafMax);
+               childCost[i] = child.IsLeaf()
+                    ? childCombined + inheritanceCost
+                    : childCombined - Perimeter(child.min, child.max) + inheritanceCost;
+          }
+
+          if (cost < childCost[0] && cost < childCost[1])
+          {
+               break;
+          }
+          index = childCost[0] < childCost[1] ? node.child1 : node.child2;
+     }
+
+     int32_t sibling = index;
+     int32_t oldParent = nodes[sibling].parent;
+     int32_t newParent = AllocateNode();
+     nodes[newParent].parent = oldParent;
+     nodes[newParent].child1 = sibling;
+     nodes[newParent].child2 = leaf;
+     nodes[sibling].parent = newParent;
+     nodes[leaf].parent = newParent;
+     Refit(newParent);
+
+     if (oldParent != nullNode)
+     {
+          if (nodes[oldParent].child1 == sibling)
+          {
+               nodes[oldParent].child1 = newParent;
+          }
+          else
+          {
+               nodes[oldParent].child2 = newParent;
+          }
+     }
+     else
+     {
+          root = newParent;
+     }
+
+     // Walk back up fixing heights and bounds.
+     index = nodes[leaf].parent;
+     while (index != nullNode)
+     {
+          index = Balance(index);
+          Refit(index);
+          index = nodes[index].parent;
+     }
+}
+
+void DynamicAABBTree::RemoveLeaf(int32_t leaf)
+{
+     if (leaf == root)
+     {
+          root = nullNode;
+          return;
+     }
+
+     int32_t parent = nodes[leaf].parent;
+     int32_t grandParent = nodes[parent].parent;
+     int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+     if (grandParent != nullNode)
+     {
+          if (nodes[grandParent].child1 == parent)
+          {
+               nodes[grandParent].child1 = sibling;
+          }
+          else
+          {
+               nodes[grandParent].child2 = sibling;
+          }
+          nodes[sibling].parent = grandParent;
+          FreeNode(parent);
+
+          int32_t index = grandParent;
+          while (index != nullNode)
+          {
+               index = Balance(index);
+               Refit(index);
+               index = nodes[index].parent;
+          }
+     }
+     else
+     {
+          root = sibling;
+          nodes[sibling].parent = nullNode;
+          FreeNode(parent);
+     }
+}
+
+void DynamicAABBTree::Refit(int32_t index)
+{
+     Node& node = nodes[index];
+     const Node& child1 = nodes[node.child1];
+     const Node& child2 = nodes[node.child2];
+     node.min = XMFLOAT3(std::min(child1.min.x, child2.min.x), std::min(child1.min.y, child2.min.y), std::min(child1.min.z, child2.min.z));
+     node.max = XMFLOAT3(std::max(child1.max.x, child2.max.x), std::max(child1.max.y, child2.max.y), std::max(child1.max.z, child2.max.z));
+     node.height = 1 + std::max(child1.height, child2.height);
+}
+
+// Function to rotate subtree if it is imbalanced, returns index of the new subtree root
+int32_t DynamicAABBTree::Balance(int32_t a)
+{
+     if (nodes[a].IsLeaf() || nodes[a].height < 2)
+     {
+          return a;
+     }
+
+     int32_t b = nodes[a].child1;
+     int32_t c = nodes[a].child2;
+     int32_t balance = nodes[c].height - nodes[b].height;
+     if (balance >= -1 && balance <= 1)
+     {
+          return a;
+     }
+
+     // Promote the taller child: it takes the place of a, a takes one of its children.
+     bool rotateRight = balance > 1;
+     int32_t up = rotateRight ? c : b;
+     int32_t other = rotateRight ? b : c;
+     int32_t f = nodes[up].child1;
+     int32_t g = nodes[up].child2;
+
+     nodes[up].child1 = a;
+     nodes[up].parent = nodes[a].parent;
+     nodes[a].parent = up;
+     if (nodes[up].parent != nullNode)
+     {
+          int32_t parent = nodes[up].parent;
+          if (nodes[parent].child1 == a)
+          {
+               nodes[parent].child1 = up;
+          }
+          else
+          {
+               nodes[parent].child2 = up;
+          }
+     }
+     else
+     {
+          root = up;
+     }
+
+     // Keep the taller grandchild under the promoted node.
+     if (nodes[f].height < nodes[g].height)
+     {
+          std::swap(f, g);
+     }
+     nodes[up].child2 = f;
+     nodes[a].child1 = other;
+     nodes[a].child2 = g;
+     nodes[g].parent = a;
+     Refit(a);
+     Refit(up);
+     return up;
+}
+
+template <typename Emit>
+void DynamicAABBTree::QuerySubtree(const Frustum& frustum, const BoundsSoA& bounds, QueryEntry start, Emit&& emit)
+{
+     // Leaves under intersecting nodes are queued and their tight boxes are tested in batches,
+     // cached planes of the leaves go along and the rejecting ones are stored back.
+     const size_t leafBatch = 64;
+     uint32_t leaves[leafBatch];
+     int32_t leafNodes[leafBatch];
+     uint8_t leafPlanes[leafBatch];
+     uint8_t leafVisible[leafBatch];
+     size_t leafCount = 0;
+     auto flushLeaves = [&]()
+          {
+               frustum.CheckAABBBatch(bounds, leaves, leafCount, leafVisible, planeCache ? leafPlanes : nullptr);
+               for (size_t i = 0; i < leafCount; ++i)
+               {
+                    if (leafVisible[i])
+                    {
+                         emit(leaves[i]);
+                    }
+                    else if (planeCache)
+                    {
+                         nodes[leafNodes[i]].lastPlane = leafPlanes[i];
+                    }
+               }
+               leafCount = 0;
+          };
+
+     std::vector<QueryEntry> stack;
+     stack.reserve(64);
+     stack.push_back(start);
+
+     while (!stack.empty())
+     {
+          QueryEntry entry = stack.back();
+          stack.pop_back();
+          Node& node = nodes[entry.node];
+          uint32_t planeMask = entry.planeMask;
+
+          if (node.IsLeaf())
+          {
+               leaves[leafCount] = node.userData;
+               leafNodes[leafCount] = entry.node;
+               leafPlanes[leafCount++] = node.lastPlane;
+               if (leafCount == leafBatch)
+               {
+                    flushLeaves();
+               }
+               continue;
+          }
+
+          XMFLOAT3 center(0.5f * (node.min.x + node.max.x), 0.5f * (node.min.y + node.max.y), 0.5f * (node.min.z + node.max.z));
+          XMFLOAT3 extent(0.5f * (node.max.x - node.min.x), 0.5f * (node.max.y - node.min.y), 0.5f * (node.max.z - node.min.z));
+          uint8_t firstPlane = 0;
+          FrustumTest result = frustum.CheckAABB(center, extent, planeMask, planeCache ? node.lastPlane : firstPlane);
+          if (result == FrustumTest::Outside)
+          {
+               continue;
+          }
+
+          // Everything below a node inside the frustum is inside as well, tight boxes included.
+          if (result == FrustumTest::Inside)
+          {
+               CollectLeaves(entry.node, emit);
+          }
+          else
+          {
+               stack.push_back({ node.child2, planeMask });
+               stack.push_back({ node.child1, planeMask });
+          }
+     }
+     flushLeaves();
+}
+
+template <typename Emit>
+void DynamicAABBTree::CollectLeaves(int32_t index, Emit&& emit) const
+{
+     const Node& node = nodes[index];
+     if (node.IsLeaf())
+     {
+          emit(node.userData);
+          return;
+     }
+     CollectLeaves(node.child1, emit);
+     CollectLeaves(node.child2, emit);
+}
+
+void DynamicAABBTree::Query(ThreadPool& pool, const Frustum& frustum, const BoundsSoA& bounds, uint8_t* visibleMask)
+{
+     if (root == nullNode)
+     {
+          return;
+     }
+
+     // Expand the top of the tree breadth first until there are enough independent subtrees.
+     // Nodes are tested on the way down, rejected ones are dropped, children inherit the plane mask.
+     const size_t taskTarget = 4 * static_cast<size_t>(pool.GetThreadCount());
+     queryFrontier.clear();
+     queryFrontier.push_back({ root, Frustum::allPlanesMask });
+     bool expanded = true;
+     while (queryFrontier.size() < taskTarget && expanded)
+     {
+          expanded = false;
+          size_t levelSize = queryFrontier.size();
+          for (size_t i = 0; i < levelSize; ++i)
+          {
+               QueryEntry entry = queryFrontier[i];
+               Node& node = nodes[entry.node];
+               if (node.IsLeaf())
+               {
+                    continue;
+               }
+
+               XMFLOAT3 center(0.5f * (node.min.x + node.max.x), 0.5f * (node.min.y + node.max.y), 0.5f * (node.min.z + node.max.z));
+               XMFLOAT3 extent(0.5f * (node.max.x - node.min.x), 0.5f * (node.max.y - node.min.y), 0.5f * (node.max.z - node.min.z));
+               uint32_t planeMask = entry.planeMask;
+               uint8_t firstPlane = 0;
+               if (frustum.CheckAABB(center, extent, planeMask, planeCache ? node.lastPlane : firstPlane) == FrustumTest::Outside)
+               {
+                    queryFrontier[i].node = nullNode;
+                    continue;
+               }
+
+               queryFrontier[i] = { node.child1, planeMask };
+               queryFrontier.push_back({ node.child2, planeMask });
+               expanded = true;
+          }
+          queryFrontier.erase(std::remove_if(queryFrontier.begin(), queryFrontier.end(),
+               [](const QueryEntry& entry) { return entry.node == nullNode; }), queryFrontier.end());
+     }
+
+     // Subtrees are disjoint, so tasks touch different nodes and different mask entries.
+     // Each task counts on its own copy of the frustum to keep shared counters out of the loop.
+     std::vector<FrustumStats> taskStats(queryFrontier.size());
+     pool.ParallelFor(queryFrontier.size(), [&](size_t task, unsigned)
+          {
+               Frustum taskFrustum = frustum;
+               taskFrustum.ResetStats();
+               QuerySubtree(taskFrustum, bounds, queryFrontier[task], [visibleMask](uint32_t userData) { visibleMask[userData] = 1; });
+               taskStats[task] = taskFrustum.GetStats();
+          });
+
+     for (const FrustumStats& stats : taskStats)
+     {
+          frustum.AddStats(stats);
+     }
+}
+
+void DynamicAABBTree::Clear()
+{
+     nodes.clear();
+     root = nullNode;
+     freeList = nullNode;
+     proxyCount = 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Bounds.h"
+#include "Frustum.h"
+#include "ThreadPool.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+// Dynamic bounding volume tree for moving instances. Leaves store fat boxes
+// so small moves do not touch the tree, the tree is kept balanced with rotations.
+class DynamicAABBTree
+{
+public:
+     static constexpr int32_t nullNode = -1;
+
+     explicit DynamicAABBTree(float fatMargin = 0.1f) : fatMargin(fatMargin) {}
+
+     // Function to insert box, returns proxy handle
+     int32_t CreateProxy(const XMFLOAT3& center, const XMFLOAT3& extent, uint32_t userData);
+     void DestroyProxy(int32_t proxy);
+     // Function to update box of proxy, returns true if the proxy was reinserted
+     bool MoveProxy(int32_t proxy, const XMFLOAT3& center, const XMFLOAT3& extent);
+     uint32_t GetUserData(int32_t proxy) const { return nodes[proxy].userData; }
+     void SetUserData(int32_t proxy, uint32_t userData) { nodes[proxy].userData = userData; }
+
+     // Function to set visibleMask[userData] to 1 for proxies in frustum, top subtrees are traversed in parallel.
+     // Leaves are tested with the tight boxes in bounds indexed by user data, fat boxes only prune inner nodes
+     void Query(ThreadPool& pool, const Frustum& frustum, const BoundsSoA& bounds, uint8_t* visibleMask);
+
+     // Function to turn the per node plane cache on or off, with it off every node is tested from the first plane
+     void SetPlaneCache(bool enabled) { planeCache = enabled; }
+
+     int32_t GetHeight() const { return root == nullNode ? 0 : nodes[root].height; }
+     size_t GetProxyCount() const { return proxyCount; }
+     void Clear();
+private:
+     struct Node
+     {
+          XMFLOAT3 min;
+          XMFLOAT3 max;
+          uint32_t userData;
+          int32_t parent;  // next free node while the node is in the free list
+          int32_t child1;
+          int32_t child2;
+          int32_t height;  // 0 for leaves, -1 for free nodes
+          uint8_t lastPlane;  // plane that rejected the node last time
+
+          bool IsLeaf() const { return child1 == nullNode; }
+     };
+
+     struct QueryEntry
+     {
+          int32_t node;
+          uint32_t planeMask;
+     };
+
+     int32_t AllocateNode();
+     void FreeNode(int32_t node);
+     void InsertLeaf(int32_t leaf);
+     void RemoveLeaf(int32_t leaf);
+     int32_t Balance(int32_t node);
+     void Refit(int32_t node);
+     template <typename Emit>
+     void QuerySubtree(const Frustum& frustum, const BoundsSoA& bounds, QueryEntry start, Emit&& emit);
+     template <typename Emit>
+     void CollectLeaves(int32_t node, Emit&& emit) const;
+
+     std::vector<Node> nodes;
+     int32_t root = nullNode;
+     int32_t freeList = nullNode;
+     size_t proxyCount = 0;
+     float fatMargin;
+     bool planeCache = true;
+     std::vector<QueryEntry> queryFrontier;
+};
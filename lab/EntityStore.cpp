@@ -0,0 +1,220 @@
+#include "EntityStore.h"
+
+#include <cstring>
+
+static const size_t componentSizes[EntityChunk::componentCount] = {
+     sizeof(TransformComponent),
+     sizeof(BoundsComponent),
+     sizeof(MeshComponent),
+     sizeof(MaterialComponent),
+     sizeof(TransparencyComponent)
+};
+
+// Arrays start at multiples of this inside a chunk
+static constexpr size_t arrayAlignment = 16;
+
+size_t EntityChunk::ComponentIndex(uint32_t bit)
+{
+     size_t idx = 0;
+     while ((bit >> idx) != 1)
+     {
+          ++idx;
+     }
+     return idx;
+}
+
+uint32_t EntityStore::FindArchetype(uint32_t mask)
+{
+     for (uint32_t idx = 0; idx < archetypes.size(); ++idx)
+     {
+          if (archetypes[idx].mask == mask)
+          {
+               return idx;
+          }
+     }
+
+     Archetype archetype;
+     archetype.mask = mask;
+     size_t rowSize = sizeof(uint32_t);
+     for (size_t c = 0; c < EntityChunk::componentCount; ++c)
+     {
+          rowSize += (mask >> c) & 1 ? componentSizes[c] : 0;
+     }
+     // Every array may lose up to the alignment to padding.
+     archetype.capacity = (chunkBytes - arrayAlignment * (EntityChunk::componentCount + 1)) / rowSize;
+
+     size_t offset = (sizeof(uint32_t) * archetype.capacity + arrayAlignment - 1) & ~(arrayAlignment - 1);
+     for (size_t c = 0; c < EntityChunk::componentCount; ++c)
+     {
+          archetype.offsets[c] = offset;
+          if ((mask >> c) & 1)
+          {
+               offset = (offset + componentSizes[c] * archetype.capacity + arrayAlignment - 1) & ~(arrayAlignment - 1);
+          }
+     }
+     archetypes.push_back(std::move(archetype));
+     return static_cast<uint32_t>(archetypes.size() - 1);
+}
+
+void EntityStore::AllocateRow(uint32_t archetypeIdx, Record& record)
+{
+     Archetype& archetype = archetypes[archetypeIdx];
+     if (archetype.chunks.empty() || archetype.chunks.back()->count == archetype.capacity)
+     {
+          auto chunk = std::make_unique<EntityChunk>();
+          // new[] of a byte array is aligned for any fundamental type, which covers arrayAlignment.
+          chunk->memory.reset(new uint8_t[chunkBytes]);
+          chunk->entities = reinterpret_cast<uint32_t*>(chunk->memory.get());
+          for (size_t c = 0; c < EntityChunk::componentCount; ++c)
+          {
+               chunk->arrays[c] = (archetype.mask >> c) & 1 ? chunk->memory.get() + archetype.offsets[c] : nullptr;
+          }
+          archetype.chunks.push_back(std::move(chunk));
+     }
+
+     record.archetype = archetypeIdx;
+     record.chunk = static_cast<uint32_t>(archetype.chunks.size() - 1);
+     record.row = static_cast<uint32_t>(archetype.chunks.back()->count++);
+}
+
+void EntityStore::FreeRow(const Record& record)
+{
+     Archetype& archetype = archetypes[record.archetype];
+     EntityChunk& chunk = *archetype.chunks[record.chunk];
+     EntityChunk& last = *archetype.chunks.back();
+     size_t lastRow = last.count - 1;
+
+     if (&chunk != &last || record.row != lastRow)
+     {
+          uint32_t moved = last.entities[lastRow];
+          chunk.entities[record.row] = moved;
+          for (size_t c = 0; c < EntityChunk::componentCount; ++c)
+          {
+               if (chunk.arrays[c])
+               {
+                    memcpy(chunk.arrays[c] + componentSizes[c] * record.row, last.arrays[c] + componentSizes[c] * lastRow,
+                         componentSizes[c]);
+               }
+          }
+          records[moved].chunk = record.chunk;
+          records[moved].row = record.row;
+     }
+
+     if (--last.count == 0)
+     {
+          archetype.chunks.pop_back();
+     }
+}
+
+Entity EntityStore::Create(uint32_t mask)
+{
+     uint32_t idx = freeRecord;
+     if (idx != Entity::invalidIndex)
+     {
+          freeRecord = records[idx].row;
+     }
+     else
+     {
+          idx = static_cast<uint32_t>(records.size());
+          records.push_back({ 0, 0, 0, 0 });
+     }
+
+     Record& record = records[idx];
+     AllocateRow(FindArchetype(mask), record);
+     EntityChunk& chunk = *archetypes[record.archetype].chunks[record.chunk];
+     chunk.entities[record.row] = idx;
+     for (size_t c = 0; c < EntityChunk::componentCount; ++c)
+     {
+          if (chunk.arrays[c])
+          {
+               memset(chunk.arrays[c] + componentSizes[c] * record.row, 0, componentSizes[c]);
+          }
+     }
+     ++entityCount;
+
+     return Entity{ idx, record.generation };
+}
+
+bool EntityStore::Destroy(Entity entity)
+{
+     if (!IsValid(entity))
+     {
+          return false;
+     }
+
+     Record& record = records[entity.index];
+     FreeRow(record);
+     // Old handles of the record stop resolving.
+     ++record.generation;
+     record.archetype = Entity::invalidIndex;
+     record.row = freeRecord;
+     freeRecord = entity.index;
+     --entityCount;
+     return true;
+}
+
+bool EntityStore::SetComponents(Entity entity, uint32_t mask)
+{
+     if (!IsValid(entity))
+     {
+          return false;
+     }
+
+     Record& record = records[entity.index];
+     if (archetypes[record.archetype].mask == mask)
+     {
+          return true;
+     }
+
+     uint32_t target = FindArchetype(mask);
+     Record from = record;
+     AllocateRow(target, record);
+     const EntityChunk& source = *archetypes[from.archetype].chunks[from.chunk];
+     EntityChunk& chunk = *archetypes[target].chunks[record.chunk];
+     chunk.entities[record.row] = entity.index;
+     for (size_t c = 0; c < EntityChunk::componentCount; ++c)
+     {
+          if (!chunk.arrays[c])
+          {
+               continue;
+          }
+          uint8_t* value = chunk.arrays[c] + componentSizes[c] * record.row;
+          if (source.arrays[c])
+          {
+               memcpy(value, source.arrays[c] + componentSizes[c] * from.row, componentSizes[c]);
+          }
+          else
+          {
+               memset(value, 0, componentSizes[c]);
+          }
+     }
+     FreeRow(from);
+     return true;
+}
+
+void EntityStore::Clear()
+{
+     for (size_t idx = 0; idx < records.size(); ++idx)
+     {
+          if (records[idx].archetype != Entity::invalidIndex)
+          {
+               ++records[idx].generation;
+               records[idx].archetype = Entity::invalidIndex;
+          }
+          records[idx].row = idx + 1 < records.size() ? static_cast<uint32_t>(idx + 1) : Entity::invalidIndex;
+     }
+     freeRecord = records.empty() ? Entity::invalidIndex : 0;
+     archetypes.clear();
+     entityCount = 0;
+}
+
+bool EntityStore::IsValid(Entity entity) const
+{
+     return entity.index < records.size() && records[entity.index].generation == entity.generation
+          && records[entity.index].archetype != Entity::invalidIndex;
+}
+
+uint32_t EntityStore::GetMask(Entity entity) const
+{
+     return IsValid(entity) ? archetypes[records[entity.index].archetype].mask : 0;
+}
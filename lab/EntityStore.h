@@ -0,0 +1,145 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+// Components of renderable entities. Every type has its own bit, a set of bits selects an archetype
+struct TransformComponent
+{
+     static constexpr uint32_t bit = 1 << 0;
+     DirectX::XMFLOAT4X3 world;
+};
+
+struct BoundsComponent
+{
+     static constexpr uint32_t bit = 1 << 1;
+     DirectX::XMFLOAT3 center;
+     DirectX::XMFLOAT3 extent;
+};
+
+// Index range of the mesh in the index buffer of its renderer
+struct MeshComponent
+{
+     static constexpr uint32_t bit = 1 << 2;
+     uint32_t startIndex;
+     uint32_t indexCount;
+};
+
+struct MaterialComponent
+{
+     static constexpr uint32_t bit = 1 << 3;
+     uint16_t material;
+};
+
+// Blended color, entities with it are drawn back to front
+struct TransparencyComponent
+{
+     static constexpr uint32_t bit = 1 << 4;
+     DirectX::XMFLOAT4 color;
+};
+
+struct Entity
+{
+     static constexpr uint32_t invalidIndex = 0xFFFFFFFF;
+
+     uint32_t index = invalidIndex;
+     uint32_t generation = 0;
+
+     bool IsNull() const { return index == invalidIndex; }
+};
+
+// Fixed size block holding entities of one archetype, every component has its own packed array
+struct EntityChunk
+{
+     static constexpr size_t componentCount = 5;
+
+     size_t count = 0;
+     uint32_t* entities = nullptr;
+     uint8_t* arrays[componentCount] = {};
+     std::unique_ptr<uint8_t[]> memory;
+
+     // Function to get component array, nullptr when the archetype does not have the component
+     template <typename T>
+     T* Get() const { return reinterpret_cast<T*>(arrays[ComponentIndex(T::bit)]); }
+
+     static size_t ComponentIndex(uint32_t bit);
+};
+
+// Archetype based entity storage. Entities with the same component set share chunks, all chunks of an
+// archetype but the last one are full, so systems iterate tightly packed component arrays.
+class EntityStore
+{
+public:
+     static constexpr size_t chunkBytes = 16 * 1024;
+
+     Entity Create(uint32_t mask);
+     bool Destroy(Entity entity);
+     // Function to add and remove components, the entity moves to the archetype of the new mask and keeps
+     // values of the components it already had
+     bool SetComponents(Entity entity, uint32_t mask);
+     void Clear();
+
+     bool IsValid(Entity entity) const;
+     uint32_t GetMask(Entity entity) const;
+     size_t Size() const { return entityCount; }
+
+     // Function to get component of entity, nullptr when the entity does not have it
+     template <typename T>
+     T* Get(Entity entity) const
+     {
+          if (!IsValid(entity))
+          {
+               return nullptr;
+          }
+          const Record& record = records[entity.index];
+          T* values = archetypes[record.archetype].chunks[record.chunk]->Get<T>();
+          return values ? values + record.row : nullptr;
+     }
+
+     // Function to call fn(EntityChunk&) for every non empty chunk of archetypes that have all components of mask
+     template <typename Fn>
+     void ForEachChunk(uint32_t mask, Fn&& fn) const
+     {
+          for (const Archetype& archetype : archetypes)
+          {
+               if ((archetype.mask & mask) != mask)
+               {
+                    continue;
+               }
+               for (const auto& chunk : archetype.chunks)
+               {
+                    fn(*chunk);
+               }
+          }
+     }
+private:
+     struct Archetype
+     {
+          uint32_t mask;
+          size_t capacity;
+          size_t offsets[EntityChunk::componentCount];
+          std::vector<std::unique_ptr<EntityChunk>> chunks;
+     };
+
+     // Location of an entity, row holds the next free record while the record is free
+     struct Record
+     {
+          uint32_t archetype;
+          uint32_t chunk;
+          uint32_t row;
+          uint32_t generation;
+     };
+
+     uint32_t FindArchetype(uint32_t mask);
+     // Function to append row to the last chunk of archetype, returns its location in record
+     void AllocateRow(uint32_t archetype, Record& record);
+     // Function to fill the row with the last row of archetype, so chunks stay packed
+     void FreeRow(const Record& record);
+
+     std::vector<Archetype> archetypes;
+     std::vector<Record> records;
+     uint32_t freeRecord = Entity::invalidIndex;
+     size_t entityCount = 0;
+};
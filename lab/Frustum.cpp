@@ -1,8 +1,14 @@
 #include "Frustum.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
 
 // Function to build frustum
 void Frustum::ConstructFrustum(XMMATRIX viewMatrix, XMMATRIX projectionMatrix) 
 {
+     ResetStats();
+
      // Convert the projection matrix into a 4x4 float type.
      XMFLOAT4X4 pMatrix;
      XMStoreFloat4x4(&pMatrix, projectionMatrix);
@@ -102,6 +108,54 @@ void Frustum::ConstructFrustum(XMMATRIX viewMatrix, XMMATRIX projectionMatrix)
      planes[5][3] /= length;
 }
 
+bool Frustum::ConstructFromPortal(const Frustum& parent, const XMFLOAT3& eye, const XMFLOAT3 corners[4])
+{
+     *this = parent;
+     ResetStats();
+
+     XMVECTOR eyePos = XMLoadFloat3(&eye);
+     XMVECTOR centroid = XMVectorZero();
+     for (int i = 0; i < 4; i++)
+     {
+          centroid = XMVectorAdd(centroid, XMLoadFloat3(&corners[i]));
+     }
+     centroid = XMVectorScale(centroid, 0.25f);
+
+     // Side planes pass through the eye and one portal edge, oriented so the portal centroid is in front of them.
+     float sidePlanes[4][4];
+     for (int i = 0; i < 4; i++)
+     {
+          XMVECTOR a = XMVectorSubtract(XMLoadFloat3(&corners[i]), eyePos);
+          XMVECTOR b = XMVectorSubtract(XMLoadFloat3(&corners[(i + 1) % 4]), eyePos);
+          XMVECTOR normal = XMVector3Cross(a, b);
+          float length = XMVectorGetX(XMVector3Length(normal));
+          if (length < 1e-6f)
+          {
+               return false;
+          }
+          normal = XMVectorScale(normal, 1.0f / length);
+          float distance = -XMVectorGetX(XMVector3Dot(normal, eyePos));
+          if (XMVectorGetX(XMVector3Dot(normal, centroid)) + distance < 0.0f)
+          {
+               normal = XMVectorNegate(normal);
+               distance = -distance;
+          }
+          sidePlanes[i][0] = XMVectorGetX(normal);
+          sidePlanes[i][1] = XMVectorGetY(normal);
+          sidePlanes[i][2] = XMVectorGetZ(normal);
+          sidePlanes[i][3] = distance;
+     }
+
+     for (int i = 0; i < 4; i++)
+     {
+          for (int k = 0; k < 4; k++)
+          {
+               planes[2 + i][k] = sidePlanes[i][k];
+          }
+     }
+     return true;
+}
+
 bool Frustum::CheckRectangle(float maxWidth, float maxHeight, float maxDepth, float minWidth, float minHeight, float minDepth) 
 {
      // Check if any of the 6 planes of the rectangle are inside the view frustum.
@@ -159,4 +213,182 @@ bool Frustum::CheckRectangle(float maxWidth, float maxHeight, float maxDepth, fl
      }
 
      return true;
-}
\ No newline at end of file
+}
+
+void Frustum::CheckAABBBatch(const float* centerX, const float* centerY, const float* centerZ,
+     const float* extentX, const float* extentY, const float* extentZ, size_t count, uint8_t* visible, uint8_t* lastPlanes) const
+{
+     // Box is outside of a plane when its farthest point along the plane normal is behind it:
+     // dot(n, c) + d + dot(|n|, e) < 0. Two 4-wide vectors are processed per iteration.
+     XMVECTOR planeX[6], planeY[6], planeZ[6], planeW[6];
+     XMVECTOR absX[6], absY[6], absZ[6];
+     for (int i = 0; i < 6; i++)
+     {
+          planeX[i] = XMVectorReplicate(planes[i][0]);
+          planeY[i] = XMVectorReplicate(planes[i][1]);
+          planeZ[i] = XMVectorReplicate(planes[i][2]);
+          planeW[i] = XMVectorReplicate(planes[i][3]);
+          absX[i] = XMVectorAbs(planeX[i]);
+          absY[i] = XMVectorAbs(planeY[i]);
+          absZ[i] = XMVectorAbs(planeZ[i]);
+     }
+
+     FRUSTUM_STAT(stats.boxesTested += count);
+
+     const XMVECTOR zero = XMVectorZero();
+     size_t idx = 0;
+     for (; idx + 8 <= count; idx += 8)
+     {
+          XMVECTOR cx[2], cy[2], cz[2], ex[2], ey[2], ez[2], inside[2];
+          for (int k = 0; k < 2; k++)
+          {
+               size_t offset = idx + 4 * k;
+               cx[k] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(centerX + offset));
+               cy[k] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(centerY + offset));
+               cz[k] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(centerZ + offset));
+               ex[k] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(extentX + offset));
+               ey[k] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(extentY + offset));
+               ez[k] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(extentZ + offset));
+               inside[k] = XMVectorTrueInt();
+          }
+
+          // With the cache the block starts from the plane that last rejected its first box and stops once every
+          // box is rejected, neighbours in a batch are mostly rejected by the same plane.
+          int firstPlane = lastPlanes ? lastPlanes[idx] : 0;
+          for (int n = 0; n < 6; n++)
+          {
+               int i = n == 0 ? firstPlane : (n <= firstPlane ? n - 1 : n);
+               FRUSTUM_STAT(stats.planeTests += 8);
+               for (int k = 0; k < 2; k++)
+               {
+                    XMVECTOR dist = XMVectorMultiplyAdd(planeX[i], cx[k], planeW[i]);
+                    dist = XMVectorMultiplyAdd(planeY[i], cy[k], dist);
+                    dist = XMVectorMultiplyAdd(planeZ[i], cz[k], dist);
+                    dist = XMVectorMultiplyAdd(absX[i], ex[k], dist);
+                    dist = XMVectorMultiplyAdd(absY[i], ey[k], dist);
+                    dist = XMVectorMultiplyAdd(absZ[i], ez[k], dist);
+                    XMVECTOR before = inside[k];
+                    inside[k] = XMVectorAndInt(inside[k], XMVectorGreaterOrEqual(dist, zero));
+                    if (FRUSTUM_STATS || lastPlanes)
+                    {
+                         uint32_t rejected = XMVectorMoveMask(before) & ~XMVectorMoveMask(inside[k]);
+                         FRUSTUM_STAT(stats.planeRejects[i] += BitCount32(rejected));
+                         for (; lastPlanes && rejected; rejected &= rejected - 1)
+                         {
+                              lastPlanes[idx + 4 * k + BitScanForward32(rejected)] = static_cast<uint8_t>(i);
+                         }
+                    }
+               }
+               if (lastPlanes && !(XMVectorMoveMask(inside[0]) | XMVectorMoveMask(inside[1])))
+               {
+                    break;
+               }
+          }
+
+          for (int k = 0; k < 2; k++)
+          {
+               FRUSTUM_STAT(uint32_t accepted = BitCount32(XMVectorMoveMask(inside[k])));
+               FRUSTUM_STAT(stats.accepted += accepted);
+               FRUSTUM_STAT(stats.rejected += 4 - accepted);
+               uint32_t result[4];
+               XMStoreInt4(result, inside[k]);
+               for (int j = 0; j < 4; j++)
+               {
+                    visible[idx + 4 * k + j] = static_cast<uint8_t>(result[j] & 1);
+               }
+          }
+     }
+
+     // Process the remaining boxes one at a time, starting from the cached plane like CheckAABB.
+     for (; idx < count; idx++)
+     {
+          uint8_t inside = 1;
+          int lastPlane = lastPlanes ? lastPlanes[idx] : 0;
+          for (int k = 0; k < 6 && inside; k++)
+          {
+               int i = k == 0 ? lastPlane : (k <= lastPlane ? k - 1 : k);
+               FRUSTUM_STAT(stats.planeTests++);
+               float dist = planes[i][0] * centerX[idx] + planes[i][1] * centerY[idx] + planes[i][2] * centerZ[idx] + planes[i][3]
+                    + fabsf(planes[i][0]) * extentX[idx] + fabsf(planes[i][1]) * extentY[idx] + fabsf(planes[i][2]) * extentZ[idx];
+               if (dist < 0.0f)
+               {
+                    FRUSTUM_STAT(stats.planeRejects[i]++);
+                    inside = 0;
+                    if (lastPlanes)
+                    {
+                         lastPlanes[idx] = static_cast<uint8_t>(i);
+                    }
+               }
+          }
+          FRUSTUM_STAT(inside ? stats.accepted++ : stats.rejected++);
+          visible[idx] = inside;
+     }
+}
+
+void Frustum::CheckAABBBatch(const BoundsSoA& bounds, const uint32_t* ids, size_t count, uint8_t* visible, uint8_t* lastPlanes) const
+{
+     // Gather scattered boxes into small contiguous blocks the vector loop can load directly.
+     const size_t blockSize = 64;
+     alignas(16) float block[6][blockSize];
+     for (size_t begin = 0; begin < count; begin += blockSize)
+     {
+          size_t blockCount = std::min<size_t>(blockSize, count - begin);
+          for (size_t i = 0; i < blockCount; ++i)
+          {
+               uint32_t idx = ids[begin + i];
+               block[0][i] = bounds.centerX[idx];
+               block[1][i] = bounds.centerY[idx];
+               block[2][i] = bounds.centerZ[idx];
+               block[3][i] = bounds.extentX[idx];
+               block[4][i] = bounds.extentY[idx];
+               block[5][i] = bounds.extentZ[idx];
+          }
+          CheckAABBBatch(block[0], block[1], block[2], block[3], block[4], block[5], blockCount, visible + begin,
+               lastPlanes ? lastPlanes + begin : nullptr);
+     }
+}
+
+FrustumTest Frustum::CheckAABB(const XMFLOAT3& center, const XMFLOAT3& extent, uint32_t& planeMask) const
+{
+     uint8_t lastPlane = 0;
+     return CheckAABB(center, extent, planeMask, lastPlane);
+}
+
+FrustumTest Frustum::CheckAABB(const XMFLOAT3& center, const XMFLOAT3& extent) const
+{
+     uint32_t planeMask = allPlanesMask;
+     uint8_t lastPlane = 0;
+     return CheckAABB(center, extent, planeMask, lastPlane);
+}
+
+FrustumTest Frustum::CheckAABB(const XMFLOAT3& center, const XMFLOAT3& extent, uint32_t& planeMask, uint8_t& lastPlane) const
+{
+     FRUSTUM_STAT(stats.boxesTested++);
+     for (int k = 0; k < 6; k++)
+     {
+          // Start from the cached plane and visit the rest in order, skipping the cached one.
+          int i = k == 0 ? lastPlane : (k <= lastPlane ? k - 1 : k);
+          if (!(planeMask & (1u << i)))
+          {
+               continue;
+          }
+
+          FRUSTUM_STAT(stats.planeTests++);
+          float dist = planes[i][0] * center.x + planes[i][1] * center.y + planes[i][2] * center.z + planes[i][3];
+          float radius = fabsf(planes[i][0]) * extent.x + fabsf(planes[i][1]) * extent.y + fabsf(planes[i][2]) * extent.z;
+          if (dist + radius < 0.0f)
+          {
+               lastPlane = static_cast<uint8_t>(i);
+               FRUSTUM_STAT(stats.planeRejects[i]++);
+               FRUSTUM_STAT(stats.rejected++);
+               return FrustumTest::Outside;
+          }
+          if (dist - radius >= 0.0f)
+          {
+               planeMask &= ~(1u << i);
+          }
+     }
+
+     FRUSTUM_STAT(stats.accepted++);
+     return planeMask ? FrustumTest::Intersecting : FrustumTest::Inside;
+}
@@ -1,22 +1,103 @@
 #pragma once
 
-#include <directxmath.h>
+#include "Bounds.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
 using namespace DirectX;
 
+// Culling counters are compiled in when FRUSTUM_STATS is nonzero, debug builds have them by default
+#ifndef FRUSTUM_STATS
+#ifdef _DEBUG
+#define FRUSTUM_STATS 1
+#else
+#define FRUSTUM_STATS 0
+#endif
+#endif
+
+#if FRUSTUM_STATS
+#define FRUSTUM_STAT(statement) statement
+#else
+#define FRUSTUM_STAT(statement)
+#endif
+
+// Box tests done with a frustum since it was built, all zero when counters are compiled out
+struct FrustumStats
+{
+     uint64_t boxesTested = 0;
+     uint64_t planeTests = 0;
+     // Boxes rejected by each plane: near, far, left, right, top, bottom
+     uint64_t planeRejects[6] = {};
+     uint64_t accepted = 0;
+     uint64_t rejected = 0;
+
+     FrustumStats& operator+=(const FrustumStats& other)
+     {
+          boxesTested += other.boxesTested;
+          planeTests += other.planeTests;
+          for (int i = 0; i < 6; i++)
+          {
+               planeRejects[i] += other.planeRejects[i];
+          }
+          accepted += other.accepted;
+          rejected += other.rejected;
+          return *this;
+     }
+};
+
+enum class FrustumTest
+{
+     Outside,
+     Intersecting,
+     Inside
+};
+
 class Frustum 
 {
 public:
+     static constexpr uint32_t allPlanesMask = 0x3F;
+
      // Function to initialize frustum class
      void Init(float screenDepth) { this->screenDepth = screenDepth; };
      // Release function
      void Release() {};
      // Function to build frustum
      void ConstructFrustum(XMMATRIX viewMatrix, XMMATRIX projectionMatrix);
+     // Function to build frustum from eye through convex quad portal, near and far planes are taken from parent.
+     // Returns false and copies parent when the eye lies in the portal plane
+     bool ConstructFromPortal(const Frustum& parent, const XMFLOAT3& eye, const XMFLOAT3 corners[4]);
 
      // Functions to check if rectengle is in frustum
      bool CheckRectangle(float maxWidth, float maxHeight, float maxDepth, float minWidth, float minHeight, float minDepth);
+
+     // Function to check a batch of center/extent boxes, writes 1 to visible[i] for boxes in frustum and 0 otherwise.
+     // With lastPlanes the cached plane of every box is tested first and blocks it rejects skip the other planes,
+     // the plane that rejected box i is stored in lastPlanes[i]
+     void CheckAABBBatch(const float* centerX, const float* centerY, const float* centerZ,
+          const float* extentX, const float* extentY, const float* extentZ, size_t count, uint8_t* visible,
+          uint8_t* lastPlanes = nullptr) const;
+     // Same as above for boxes ids[0..count) of bounds, visible[i] and lastPlanes[i] are for ids[i]
+     void CheckAABBBatch(const BoundsSoA& bounds, const uint32_t* ids, size_t count, uint8_t* visible,
+          uint8_t* lastPlanes = nullptr) const;
+
+     // Function to classify center/extent box against frustum. Only planes set in planeMask are tested,
+     // planes the box is fully inside are cleared from the mask so children of the box can skip them
+     FrustumTest CheckAABB(const XMFLOAT3& center, const XMFLOAT3& extent, uint32_t& planeMask) const;
+     FrustumTest CheckAABB(const XMFLOAT3& center, const XMFLOAT3& extent) const;
+     // Same as above but tests plane lastPlane first and stores the rejecting plane there,
+     // coherent callers keep lastPlane per object between frames
+     FrustumTest CheckAABB(const XMFLOAT3& center, const XMFLOAT3& extent, uint32_t& planeMask, uint8_t& lastPlane) const;
+
+     // Function to get plane as (normal, distance), planes are near, far, left, right, top, bottom
+     XMFLOAT4 GetPlane(int idx) const { return XMFLOAT4(planes[idx][0], planes[idx][1], planes[idx][2], planes[idx][3]); }
+
+     const FrustumStats& GetStats() const { return stats; }
+     // Function to add counters gathered elsewhere, e.g. on per thread copies of the frustum
+     void AddStats([[maybe_unused]] const FrustumStats& other) const { FRUSTUM_STAT(stats += other); }
+     void ResetStats() { stats = FrustumStats(); }
 private:
      float screenDepth;
      float planes[6][4];
+     mutable FrustumStats stats;
 };
 
@@ -0,0 +1,66 @@
+#include "InstanceBatcher.h"
+
+InstanceBatcher::InstanceBatcher(size_t pageSize)
+{
+     pageSize &= ~size_t(3);
+     this->pageSize = pageSize == 0 ? 4 : (pageSize > maxPageSize ? maxPageSize : pageSize);
+}
+
+bool InstanceBatcher::UploadInstances(BatchContext& context, const void* data, size_t count, size_t stride)
+{
+     if (count == 0)
+     {
+          return true;
+     }
+
+     if (count > capacity || stride != this->stride)
+     {
+          size_t newCapacity = stride == this->stride && 2 * capacity > count ? 2 * capacity : count;
+          if (!context.CreateInstanceBuffer(newCapacity, stride))
+          {
+               capacity = 0;
+               return false;
+          }
+          capacity = newCapacity;
+          this->stride = stride;
+     }
+
+     return context.UploadInstances(data, count * stride);
+}
+
+bool InstanceBatcher::Draw(BatchContext& context, const BatchMesh& mesh, const uint32_t* ids, size_t count, bool idsChanged)
+{
+     if (count == 0)
+     {
+          return true;
+     }
+     if (ids == residentIds && count == residentCount && !idsChanged)
+     {
+          context.DrawIndexedInstanced(mesh, count);
+          return true;
+     }
+
+     residentIds = nullptr;
+     for (size_t first = 0; first < count; first += pageSize)
+     {
+          size_t batch = count - first < pageSize ? count - first : pageSize;
+          if (!context.UploadIds(ids + first, batch))
+          {
+               return false;
+          }
+          context.DrawIndexedInstanced(mesh, batch);
+     }
+     if (count <= pageSize)
+     {
+          residentIds = ids;
+          residentCount = count;
+     }
+     return true;
+}
+
+void InstanceBatcher::Reset()
+{
+     capacity = 0;
+     stride = 0;
+     residentIds = nullptr;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Index range drawn for every instance of a batch
+struct BatchMesh
+{
+     uint32_t startIndex;
+     uint32_t indexCount;
+     int32_t baseVertex;
+};
+
+// Device calls used to draw instances in batches. The renderer implements them over a D3D11 context,
+// any other implementation can record them to check batches without a device.
+class BatchContext
+{
+public:
+     virtual ~BatchContext() = default;
+
+     // Function to replace the instance buffer with one of capacity elements of stride bytes
+     virtual bool CreateInstanceBuffer(size_t capacity, size_t stride) = 0;
+     // Function to write size bytes to the start of the instance buffer
+     virtual bool UploadInstances(const void* data, size_t size) = 0;
+     // Function to write count ids to the id page read by the next draw
+     virtual bool UploadIds(const uint32_t* ids, size_t count) = 0;
+     virtual void DrawIndexedInstanced(const BatchMesh& mesh, size_t instanceCount) = 0;
+};
+
+// Splits a visible id list into draws of at most one id page each. Instance data lives in a single
+// buffer indexed by id, so only the ids are uploaded per draw.
+class InstanceBatcher
+{
+public:
+     // Ids that fit in a constant buffer of 4096 uint4 elements
+     static constexpr size_t maxPageSize = 4 * 4096;
+
+     // Function to set ids per draw, rounded down to a multiple of four and clamped to maxPageSize
+     explicit InstanceBatcher(size_t pageSize = maxPageSize);
+
+     // Function to upload data of count instances, the buffer grows at least twice when it is too small
+     bool UploadInstances(BatchContext& context, const void* data, size_t count, size_t stride);
+     // Function to draw mesh for instances with given ids, one draw per page. A single page is not uploaded
+     // again while the same ids are drawn and idsChanged is false
+     bool Draw(BatchContext& context, const BatchMesh& mesh, const uint32_t* ids, size_t count, bool idsChanged);
+     // Function to forget device state, the next uploads recreate it
+     void Reset();
+
+     size_t GetDrawCount(size_t count) const { return (count + pageSize - 1) / pageSize; }
+     size_t GetPageSize() const { return pageSize; }
+     size_t GetCapacity() const { return capacity; }
+private:
+     size_t pageSize;
+     size_t capacity = 0;
+     size_t stride = 0;
+     // Id list held by the id page when it fits in one page
+     const uint32_t* residentIds = nullptr;
+     size_t residentCount = 0;
+};
@@ -0,0 +1,144 @@
+#include "InstanceStore.h"
+
+#include "DynamicAABBTree.h"
+#include "SpatialOrder.h"
+
+InstanceHandle InstanceStore::Add(DirectX::FXMMATRIX world, uint16_t material, float maxDistance)
+{
+     uint32_t slot = freeSlot;
+     if (slot != npos)
+     {
+          freeSlot = slots[slot].index;
+     }
+     else
+     {
+          slot = static_cast<uint32_t>(slots.size());
+          slots.push_back({ npos, 0 });
+     }
+
+     uint32_t idx = static_cast<uint32_t>(owners.size());
+     slots[slot].index = idx;
+     Resize(idx + 1);
+     owners[idx] = slot;
+     transforms.Set(idx, world);
+     materials[idx] = material;
+     maxDistances[idx] = maxDistance;
+     animations.flags[idx] = MotionNone;
+     lods[idx] = 0;
+     proxies[idx] = DynamicAABBTree::nullNode;
+
+     return InstanceHandle{ slot, slots[slot].generation };
+}
+
+uint32_t InstanceStore::Remove(InstanceHandle handle)
+{
+     if (!IsValid(handle))
+     {
+          return npos;
+     }
+
+     uint32_t idx = slots[handle.slot].index;
+     uint32_t last = static_cast<uint32_t>(owners.size()) - 1;
+     uint32_t moved = npos;
+     if (idx != last)
+     {
+          transforms.Copy(last, idx);
+          bounds.Copy(last, idx);
+          materials[idx] = materials[last];
+          maxDistances[idx] = maxDistances[last];
+          animations.Copy(last, idx);
+          lods[idx] = lods[last];
+          proxies[idx] = proxies[last];
+          owners[idx] = owners[last];
+          slots[owners[idx]].index = idx;
+          moved = last;
+     }
+     Resize(last);
+
+     // New generation makes every copy of the old handle invalid.
+     slots[handle.slot].generation++;
+     slots[handle.slot].index = freeSlot;
+     freeSlot = handle.slot;
+     return moved;
+}
+
+void InstanceStore::Clear()
+{
+     for (uint32_t slot : owners)
+     {
+          slots[slot].generation++;
+          slots[slot].index = freeSlot;
+          freeSlot = slot;
+     }
+     Resize(0);
+     transforms.version++;
+}
+
+bool InstanceStore::IsValid(InstanceHandle handle) const
+{
+     return handle.slot < slots.size() && slots[handle.slot].generation == handle.generation;
+}
+
+void InstanceStore::Reorder(const std::vector<uint32_t>& order)
+{
+     for (auto& row : transforms.m)
+     {
+          for (auto& column : row)
+          {
+               ApplyOrder(column, order);
+          }
+     }
+     ApplyOrder(transforms.dirty, order);
+     ApplyOrder(bounds.centerX, order);
+     ApplyOrder(bounds.centerY, order);
+     ApplyOrder(bounds.centerZ, order);
+     ApplyOrder(bounds.extentX, order);
+     ApplyOrder(bounds.extentY, order);
+     ApplyOrder(bounds.extentZ, order);
+     ApplyOrder(materials, order);
+     ApplyOrder(maxDistances, order);
+     ApplyOrder(animations.flags, order);
+     for (auto& row : animations.rest)
+     {
+          for (auto& column : row)
+          {
+               ApplyOrder(column, order);
+          }
+     }
+     for (auto& row : animations.base)
+     {
+          for (auto& column : row)
+          {
+               ApplyOrder(column, order);
+          }
+     }
+     ApplyOrder(animations.centerX, order);
+     ApplyOrder(animations.centerY, order);
+     ApplyOrder(animations.centerZ, order);
+     ApplyOrder(animations.orbitRadius, order);
+     ApplyOrder(animations.orbitSpeed, order);
+     ApplyOrder(animations.bobAmplitude, order);
+     ApplyOrder(animations.bobSpeed, order);
+     ApplyOrder(animations.spinSpeed, order);
+     ApplyOrder(animations.phase, order);
+     ApplyOrder(lods, order);
+     ApplyOrder(proxies, order);
+     ApplyOrder(owners, order);
+
+     for (uint32_t idx = 0; idx < owners.size(); ++idx)
+     {
+          slots[owners[idx]].index = idx;
+     }
+}
+
+void InstanceStore::Resize(size_t count)
+{
+     transforms.Resize(count);
+     bounds.Resize(count);
+     materials.resize(count);
+     maxDistances.resize(count);
+     animations.Resize(count);
+     lods.resize(count);
+     proxies.resize(count);
+     owners.resize(count);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Animation.h"
+#include "Bounds.h"
+#include "Transforms.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+// Handle of an instance, stays valid until the instance is removed
+struct InstanceHandle
+{
+     static constexpr uint32_t invalidSlot = 0xFFFFFFFF;
+
+     uint32_t slot = invalidSlot;
+     uint32_t generation = 0;
+
+     bool IsNull() const { return slot == invalidSlot; }
+};
+
+// Slot map of instances. Data lives in dense arrays indexed by position, handles resolve
+// to positions through slots. Removal moves the last instance into the freed position.
+class InstanceStore
+{
+public:
+     static constexpr uint32_t npos = 0xFFFFFFFF;
+
+     InstanceHandle Add(DirectX::FXMMATRIX world, uint16_t material, float maxDistance);
+     // Function to remove instance, returns old position of the instance moved into its place or npos
+     uint32_t Remove(InstanceHandle handle);
+     void Clear();
+
+     bool IsValid(InstanceHandle handle) const;
+     // Function to get dense position of a valid handle
+     uint32_t GetIndex(InstanceHandle handle) const { return slots[handle.slot].index; }
+     InstanceHandle GetHandle(uint32_t idx) const { return InstanceHandle{ owners[idx], slots[owners[idx]].generation }; }
+     size_t Size() const { return owners.size(); }
+
+     // Function to rearrange dense arrays so that position i holds the instance from position order[i]
+     void Reorder(const std::vector<uint32_t>& order);
+
+     // Dense arrays, all of Size() length. Bounds are filled by UpdateWorldBounds from dirty transforms
+     TransformsSoA transforms;
+     BoundsSoA bounds;
+     std::vector<uint16_t> materials;
+     std::vector<float> maxDistances;
+     // Procedural motion, evaluated into transforms every frame
+     AnimationsSoA animations;
+     // Current LOD level, kept between frames for hysteresis
+     std::vector<uint8_t> lods;
+     // Proxy of every instance in a spatial tree owned by the caller
+     std::vector<int32_t> proxies;
+private:
+     struct Slot
+     {
+          // Dense position while alive, next free slot otherwise
+          uint32_t index;
+          uint32_t generation;
+     };
+
+     void Resize(size_t count);
+
+     std::vector<Slot> slots;
+     // Slot owning every dense position
+     std::vector<uint32_t> owners;
+     uint32_t freeSlot = npos;
+};
@@ -0,0 +1,66 @@
+#include "LodSelector.h"
+
+#include <algorithm>
+
+void LodSelector::Init(float hysteresis)
+{
+     this->hysteresis = hysteresis;
+}
+
+void LodSelector::Setup(const XMFLOAT3& viewPosition, const XMMATRIX& projection, unsigned viewportHeight)
+{
+     this->viewPosition = viewPosition;
+     XMFLOAT4X4 proj;
+     XMStoreFloat4x4(&proj, projection);
+     pixelScale = proj._22 * viewportHeight * 0.5f;
+}
+
+void LodSelector::Select(ThreadPool& pool, const std::vector<LodLevel>& chain, const BoundsSoA& bounds, const uint32_t* ids,
+     size_t count, uint8_t* lods) const
+{
+     const size_t levelCount = std::min(chain.size(), maxLevels);
+     if (levelCount == 0)
+     {
+          return;
+     }
+
+     // Squared projected radius r^2 * pixelScale^2 / d^2 is compared to squared thresholds widened by the
+     // hysteresis: a finer level needs (1 + h) * threshold, the current level is kept down to (1 - h) * threshold.
+     const unsigned last = static_cast<unsigned>(levelCount - 1);
+     float finer[maxLevels] = {};
+     float coarser[maxLevels] = {};
+     for (unsigned l = 0; l < last; l++)
+     {
+          float up = chain[l].minScreenRadius * (1.0f + hysteresis);
+          float down = chain[l].minScreenRadius * (1.0f - hysteresis);
+          finer[l] = up * up;
+          coarser[l] = down * down;
+     }
+     const float pixelScaleSq = pixelScale * pixelScale;
+
+     pool.ParallelFor((count + chunkSize - 1) / chunkSize, [&](size_t chunk, unsigned)
+          {
+               size_t end = std::min(count, (chunk + 1) * chunkSize);
+               for (size_t i = chunk * chunkSize; i < end; ++i)
+               {
+                    uint32_t idx = ids[i];
+                    float dx = bounds.centerX[idx] - viewPosition.x;
+                    float dy = bounds.centerY[idx] - viewPosition.y;
+                    float dz = bounds.centerZ[idx] - viewPosition.z;
+                    float radiusSq = bounds.extentX[idx] * bounds.extentX[idx] + bounds.extentY[idx] * bounds.extentY[idx]
+                         + bounds.extentZ[idx] * bounds.extentZ[idx];
+                    float sizeSq = radiusSq * pixelScaleSq / std::max(dx * dx + dy * dy + dz * dz, 1e-6f);
+
+                    unsigned lod = std::min<unsigned>(lods[idx], last);
+                    while (lod > 0 && sizeSq >= finer[lod - 1])
+                    {
+                         --lod;
+                    }
+                    while (lod < last && sizeSq < coarser[lod])
+                    {
+                         ++lod;
+                    }
+                    lods[idx] = static_cast<uint8_t>(lod);
+               }
+          });
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Bounds.h"
+#include "InstanceBatcher.h"
+#include "ThreadPool.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace DirectX;
+
+// Level of a mesh LOD chain, levels go from the most detailed to the coarsest
+struct LodLevel
+{
+     BatchMesh mesh;
+     // Projected bounding sphere radius in pixels from which the level is used, ignored for the last level
+     float minScreenRadius;
+};
+
+// Picks LOD levels from projected bounding sphere size. A level changes only after the size leaves
+// the threshold by the hysteresis fraction, so instances near a threshold do not flicker between levels.
+class LodSelector
+{
+public:
+     static constexpr size_t maxLevels = 8;
+     static constexpr size_t chunkSize = 4096;
+
+     void Init(float hysteresis);
+     // Function to set view position and pixel scale from a perspective projection and viewport height
+     void Setup(const XMFLOAT3& viewPosition, const XMMATRIX& projection, unsigned viewportHeight);
+
+     // Function to update levels of the given instances in lods
+     void Select(ThreadPool& pool, const std::vector<LodLevel>& chain, const BoundsSoA& bounds, const uint32_t* ids,
+          size_t count, uint8_t* lods) const;
+private:
+     XMFLOAT3 viewPosition = XMFLOAT3(0.0f, 0.0f, 0.0f);
+     float pixelScale = 0.0f;
+     float hysteresis = 0.0f;
+};
@@ -0,0 +1,43 @@
+#include "MaterialRegistry.h"
+
+#include <cstring>
+
+uint16_t MaterialRegistry::Add(const Material& material)
+{
+     uint64_t hash = Hash(material);
+     auto range = lookup.equal_range(hash);
+     for (auto it = range.first; it != range.second; ++it)
+     {
+          if (memcmp(&table[it->second], &material, sizeof(Material)) == 0)
+          {
+               return it->second;
+          }
+     }
+
+     if (table.size() >= invalidIndex)
+     {
+          return invalidIndex;
+     }
+     uint16_t idx = static_cast<uint16_t>(table.size());
+     table.push_back(material);
+     lookup.emplace(hash, idx);
+     return idx;
+}
+
+void MaterialRegistry::Clear()
+{
+     table.clear();
+     lookup.clear();
+}
+
+// Function to hash material bytes with FNV-1a
+uint64_t MaterialRegistry::Hash(const Material& material)
+{
+     const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&material);
+     uint64_t hash = 14695981039346656037ull;
+     for (size_t i = 0; i < sizeof(Material); ++i)
+     {
+          hash = (hash ^ bytes[i]) * 1099511628211ull;
+     }
+     return hash;
+}
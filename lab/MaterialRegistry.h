@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+enum MaterialFlags : uint32_t
+{
+     // Only ambient light, no normal mapping and specular
+     MaterialUnlit = 1
+};
+
+// Shading parameters of an instance, matches Material in pixel_shader.hlsl
+struct Material
+{
+     float specularPower = 0.0f;
+     // Slice of the cube texture array
+     uint32_t textureSlice = 0;
+     uint32_t flags = 0;
+     uint32_t padding = 0;
+};
+
+// Table of unique materials indexed by 16 bit material ids. Bitwise identical parameter sets
+// share one entry, entries are only appended, so uploaded ones never change.
+class MaterialRegistry
+{
+public:
+     static constexpr uint16_t invalidIndex = 0xFFFF;
+
+     // Function to get index of the material, adds it if there is no identical one. Returns invalidIndex when the table is full
+     uint16_t Add(const Material& material);
+     void Clear();
+
+     const Material* GetTable() const { return table.data(); }
+     size_t Size() const { return table.size(); }
+private:
+     static uint64_t Hash(const Material& material);
+
+     std::vector<Material> table;
+     // Hash of parameters to indices of table entries with it
+     std::unordered_multimap<uint64_t, uint16_t> lookup;
+};
@@ -0,0 +1,108 @@
+#include "MultiFrustum.h"
+#include "Simd.h"
+
+#include <cmath>
+
+int MultiFrustum::AddView(const Frustum& frustum)
+{
+     if (viewCount >= maxViews)
+     {
+          return -1;
+     }
+
+     ViewPlanes& view = views[viewCount];
+     for (int i = 0; i < 6; i++)
+     {
+          XMFLOAT4 plane = frustum.GetPlane(i);
+          view.x[i] = XMVectorReplicate(plane.x);
+          view.y[i] = XMVectorReplicate(plane.y);
+          view.z[i] = XMVectorReplicate(plane.z);
+          view.w[i] = XMVectorReplicate(plane.w);
+          view.absX[i] = XMVectorReplicate(fabsf(plane.x));
+          view.absY[i] = XMVectorReplicate(fabsf(plane.y));
+          view.absZ[i] = XMVectorReplicate(fabsf(plane.z));
+     }
+     return static_cast<int>(viewCount++);
+}
+
+void MultiFrustum::Cull(const BoundsSoA& bounds, uint32_t* viewMasks, std::vector<uint32_t>* viewVisible) const
+{
+     for (size_t v = 0; v < viewCount; ++v)
+     {
+          viewVisible[v].clear();
+     }
+
+     // Load four boxes once and test them against every view.
+     const XMVECTOR zero = XMVectorZero();
+     const size_t count = bounds.Size();
+     size_t idx = 0;
+     for (; idx < count; idx += 4)
+     {
+          XMVECTOR cx, cy, cz, ex, ey, ez;
+          if (idx + 4 <= count)
+          {
+               cx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(bounds.centerX.data() + idx));
+               cy = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(bounds.centerY.data() + idx));
+               cz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(bounds.centerZ.data() + idx));
+               ex = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(bounds.extentX.data() + idx));
+               ey = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(bounds.extentY.data() + idx));
+               ez = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(bounds.extentZ.data() + idx));
+          }
+          else
+          {
+               // Pad the tail by repeating the last box, extra lanes are ignored below.
+               float tail[6][4];
+               for (size_t lane = 0; lane < 4; ++lane)
+               {
+                    size_t src = idx + lane < count ? idx + lane : count - 1;
+                    tail[0][lane] = bounds.centerX[src];
+                    tail[1][lane] = bounds.centerY[src];
+                    tail[2][lane] = bounds.centerZ[src];
+                    tail[3][lane] = bounds.extentX[src];
+                    tail[4][lane] = bounds.extentY[src];
+                    tail[5][lane] = bounds.extentZ[src];
+               }
+               cx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(tail[0]));
+               cy = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(tail[1]));
+               cz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(tail[2]));
+               ex = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(tail[3]));
+               ey = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(tail[4]));
+               ez = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(tail[5]));
+          }
+
+          uint32_t masks[4] = { 0, 0, 0, 0 };
+          for (size_t v = 0; v < viewCount; ++v)
+          {
+               const ViewPlanes& view = views[v];
+               XMVECTOR inside = XMVectorTrueInt();
+               for (int i = 0; i < 6; i++)
+               {
+                    XMVECTOR dist = XMVectorMultiplyAdd(view.x[i], cx, view.w[i]);
+                    dist = XMVectorMultiplyAdd(view.y[i], cy, dist);
+                    dist = XMVectorMultiplyAdd(view.z[i], cz, dist);
+                    dist = XMVectorMultiplyAdd(view.absX[i], ex, dist);
+                    dist = XMVectorMultiplyAdd(view.absY[i], ey, dist);
+                    dist = XMVectorMultiplyAdd(view.absZ[i], ez, dist);
+                    inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(dist, zero));
+               }
+
+               uint32_t lanes = XMVectorMoveMask(inside);
+               for (int lane = 0; lane < 4; lane++)
+               {
+                    masks[lane] |= ((lanes >> lane) & 1u) << v;
+               }
+          }
+
+          size_t laneCount = idx + 4 <= count ? 4 : count - idx;
+          for (size_t lane = 0; lane < laneCount; ++lane)
+          {
+               viewMasks[idx + lane] = masks[lane];
+               uint32_t mask = masks[lane];
+               while (mask)
+               {
+                    viewVisible[BitScanForward32(mask)].push_back(static_cast<uint32_t>(idx + lane));
+                    mask &= mask - 1;
+               }
+          }
+     }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Frustum.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+// Set of up to 32 frusta (shadow cascades, cube map faces, split views) culled in one pass over the bounds
+class MultiFrustum
+{
+public:
+     static constexpr size_t maxViews = 32;
+
+     void Clear() { viewCount = 0; }
+     // Function to add view, returns its index or -1 if all views are taken
+     int AddView(const Frustum& frustum);
+     size_t GetViewCount() const { return viewCount; }
+
+     // Function to cull boxes against every view. Bit v of viewMasks[i] is set if box i is in view v,
+     // viewVisible[v] receives ids of boxes in view v in increasing order. viewVisible must hold GetViewCount() lists
+     void Cull(const BoundsSoA& bounds, uint32_t* viewMasks, std::vector<uint32_t>* viewVisible) const;
+private:
+     // Plane components replicated across lanes, abs variants give the box projection radius
+     struct ViewPlanes
+     {
+          XMVECTOR x[6];
+          XMVECTOR y[6];
+          XMVECTOR z[6];
+          XMVECTOR w[6];
+          XMVECTOR absX[6];
+          XMVECTOR absY[6];
+          XMVECTOR absZ[6];
+     };
+
+     ViewPlanes views[maxViews];
+     size_t viewCount = 0;
+};
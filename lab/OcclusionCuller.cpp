@@ -0,0 +1,276 @@
+#include "OcclusionCuller.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+
+void OcclusionCuller::Init(unsigned width, unsigned height)
+{
+     tilesX = (width + tileWidth - 1) / tileWidth;
+     tilesY = (height + tileHeight - 1) / tileHeight;
+     coarseX = (tilesX + coarseTiles - 1) / coarseTiles;
+     coarseY = (tilesY + coarseTiles - 1) / coarseTiles;
+     tiles.resize(tilesX * tilesY);
+     coarse.resize(coarseX * coarseY);
+     viewProj = XMMatrixIdentity();
+}
+
+void OcclusionCuller::Clear(const XMMATRIX& viewProj)
+{
+     this->viewProj = viewProj;
+     std::fill(tiles.begin(), tiles.end(), Tile{ 0, 1.0f, 0.0f });
+     std::fill(coarse.begin(), coarse.end(), 0.0f);
+}
+
+void OcclusionCuller::RenderOccluder(const void* vertices, size_t vertexStride, size_t vertexCount,
+     const uint16_t* indices, size_t indexCount, const XMMATRIX& world)
+{
+     // Transform vertices to screen space, w keeps clip w to detect vertices behind the camera.
+     XMMATRIX worldViewProj = XMMatrixMultiply(world, viewProj);
+     const float halfWidth = 0.5f * GetWidth();
+     const float halfHeight = 0.5f * GetHeight();
+     transformed.resize(vertexCount);
+     for (size_t i = 0; i < vertexCount; ++i)
+     {
+          const XMFLOAT3* pos = reinterpret_cast<const XMFLOAT3*>(static_cast<const uint8_t*>(vertices) + i * vertexStride);
+          XMFLOAT4 clip;
+          XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(pos), worldViewProj));
+          if (clip.w > minW)
+          {
+               float invW = 1.0f / clip.w;
+               transformed[i] = XMFLOAT4(
+                    (clip.x * invW + 1.0f) * halfWidth,
+                    (1.0f - clip.y * invW) * halfHeight,
+                    clip.z * invW,
+                    clip.w);
+          }
+          else
+          {
+               transformed[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, clip.w);
+          }
+     }
+
+     for (size_t i = 0; i + 2 < indexCount; i += 3)
+     {
+          const XMFLOAT4& a = transformed[indices[i]];
+          const XMFLOAT4& b = transformed[indices[i + 1]];
+          const XMFLOAT4& c = transformed[indices[i + 2]];
+          // Triangles crossing the near plane are skipped, that only makes the buffer less occluding.
+          if (a.w <= minW || b.w <= minW || c.w <= minW)
+          {
+               continue;
+          }
+          RasterizeTriangle(XMLoadFloat4(&a), XMLoadFloat4(&b), XMLoadFloat4(&c));
+     }
+}
+
+void OcclusionCuller::RasterizeTriangle(FXMVECTOR v0, FXMVECTOR v1, FXMVECTOR v2)
+{
+     XMFLOAT4 p[3];
+     XMStoreFloat4(&p[0], v0);
+     XMStoreFloat4(&p[1], v1);
+     XMStoreFloat4(&p[2], v2);
+
+     // Screen y goes down, so front faces (clockwise in D3D) have positive area.
+     float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+     if (area <= 0.0f)
+     {
+          return;
+     }
+
+     float minX = std::min({ p[0].x, p[1].x, p[2].x });
+     float maxX = std::max({ p[0].x, p[1].x, p[2].x });
+     float minY = std::min({ p[0].y, p[1].y, p[2].y });
+     float maxY = std::max({ p[0].y, p[1].y, p[2].y });
+     if (maxX < 0.0f || maxY < 0.0f || minX >= GetWidth() || minY >= GetHeight())
+     {
+          return;
+     }
+     int tileMinX = std::max(0, static_cast<int>(minX) / static_cast<int>(tileWidth));
+     int tileMinY = std::max(0, static_cast<int>(minY) / static_cast<int>(tileHeight));
+     int tileMaxX = std::min(static_cast<int>(tilesX) - 1, static_cast<int>(maxX) / static_cast<int>(tileWidth));
+     int tileMaxY = std::min(static_cast<int>(tilesY) - 1, static_cast<int>(maxY) / static_cast<int>(tileHeight));
+
+     // Depth is linear in screen space, so the farthest vertex bounds the whole triangle.
+     float z = std::min({ p[0].z, p[1].z, p[2].z });
+
+     // Edge functions e = a * x + b * y + c, positive inside the triangle.
+     // An edge is always set up from the same end, so two triangles sharing it get exactly negated
+     // functions and no pixel on the edge is missed by both of them.
+     XMVECTOR edgeA[3], edgeB[3], edgeC[3];
+     for (int i = 0; i < 3; i++)
+     {
+          const XMFLOAT4& from = p[i];
+          const XMFLOAT4& to = p[(i + 1) % 3];
+          bool swap = to.y < from.y || (to.y == from.y && to.x < from.x);
+          const XMFLOAT4& v0 = swap ? to : from;
+          const XMFLOAT4& v1 = swap ? from : to;
+          float a = v0.y - v1.y;
+          float b = v1.x - v0.x;
+          float c = -a * v0.x - b * v0.y;
+          float sign = swap ? -1.0f : 1.0f;
+          edgeA[i] = XMVectorReplicate(sign * a);
+          edgeB[i] = XMVectorReplicate(sign * b);
+          edgeC[i] = XMVectorReplicate(sign * c);
+     }
+
+     const XMVECTOR laneOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+     const XMVECTOR zero = XMVectorZero();
+     for (int ty = tileMinY; ty <= tileMaxY; ++ty)
+     {
+          for (int tx = tileMinX; tx <= tileMaxX; ++tx)
+          {
+               XMVECTOR x = XMVectorAdd(XMVectorReplicate(static_cast<float>(tx * tileWidth)), laneOffsets);
+               XMVECTOR y = XMVectorReplicate(ty * tileHeight + 0.5f);
+
+               // Evaluate edges at the first row of both 4 pixel halves, then step down the rows.
+               XMVECTOR left[3], right[3];
+               for (int i = 0; i < 3; i++)
+               {
+                    left[i] = XMVectorMultiplyAdd(edgeA[i], x, XMVectorMultiplyAdd(edgeB[i], y, edgeC[i]));
+                    right[i] = XMVectorMultiplyAdd(edgeA[i], XMVectorReplicate(4.0f), left[i]);
+               }
+
+               uint32_t mask = 0;
+               for (unsigned row = 0; row < tileHeight; ++row)
+               {
+                    XMVECTOR insideLeft = XMVectorGreaterOrEqual(left[0], zero);
+                    XMVECTOR insideRight = XMVectorGreaterOrEqual(right[0], zero);
+                    for (int i = 1; i < 3; i++)
+                    {
+                         insideLeft = XMVectorAndInt(insideLeft, XMVectorGreaterOrEqual(left[i], zero));
+                         insideRight = XMVectorAndInt(insideRight, XMVectorGreaterOrEqual(right[i], zero));
+                    }
+                    mask |= (XMVectorMoveMask(insideLeft) | (XMVectorMoveMask(insideRight) << 4)) << (row * tileWidth);
+
+                    for (int i = 0; i < 3; i++)
+                    {
+                         left[i] = XMVectorAdd(left[i], edgeB[i]);
+                         right[i] = XMVectorAdd(right[i], edgeB[i]);
+                    }
+               }
+
+               if (mask)
+               {
+                    UpdateTile(tiles[ty * tilesX + tx], mask, z);
+               }
+          }
+     }
+}
+
+void OcclusionCuller::UpdateTile(Tile& tile, uint32_t mask, float z)
+{
+     // Nothing to gain from a triangle behind the layer that already covers the tile.
+     if (z <= tile.zCommitted)
+     {
+          return;
+     }
+
+     tile.mask |= mask;
+     tile.zWorking = std::min(tile.zWorking, z);
+     if (tile.mask == ~0u)
+     {
+          // Working layer covers the whole tile, it becomes the committed one.
+          tile.zCommitted = std::max(tile.zCommitted, tile.zWorking);
+          tile.mask = 0;
+          tile.zWorking = 1.0f;
+     }
+}
+
+void OcclusionCuller::BuildHierarchy()
+{
+     for (unsigned cy = 0; cy < coarseY; ++cy)
+     {
+          for (unsigned cx = 0; cx < coarseX; ++cx)
+          {
+               float z = 1.0f;
+               for (unsigned ty = cy * coarseTiles; ty < std::min(tilesY, (cy + 1) * coarseTiles); ++ty)
+               {
+                    for (unsigned tx = cx * coarseTiles; tx < std::min(tilesX, (cx + 1) * coarseTiles); ++tx)
+                    {
+                         z = std::min(z, tiles[ty * tilesX + tx].zCommitted);
+                    }
+               }
+               coarse[cy * coarseX + cx] = z;
+          }
+     }
+}
+
+bool OcclusionCuller::TestAABB(const XMFLOAT3& center, const XMFLOAT3& extent) const
+{
+     // Project box corners and take their screen rectangle and nearest depth.
+     float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, zNear = 0.0f;
+     for (int i = 0; i < 8; i++)
+     {
+          XMVECTOR corner = XMVectorSet(
+               center.x + ((i & 1) ? extent.x : -extent.x),
+               center.y + ((i & 2) ? extent.y : -extent.y),
+               center.z + ((i & 4) ? extent.z : -extent.z),
+               1.0f);
+          XMFLOAT4 clip;
+          XMStoreFloat4(&clip, XMVector4Transform(corner, viewProj));
+          if (clip.w <= minW)
+          {
+               return true;
+          }
+          float invW = 1.0f / clip.w;
+          float x = (clip.x * invW + 1.0f) * 0.5f * GetWidth();
+          float y = (1.0f - clip.y * invW) * 0.5f * GetHeight();
+          minX = std::min(minX, x);
+          maxX = std::max(maxX, x);
+          minY = std::min(minY, y);
+          maxY = std::max(maxY, y);
+          zNear = std::max(zNear, clip.z * invW);
+     }
+
+     if (maxX < 0.0f || maxY < 0.0f || minX >= GetWidth() || minY >= GetHeight())
+     {
+          return true;
+     }
+     int pixMinX = std::max(0, static_cast<int>(minX));
+     int pixMinY = std::max(0, static_cast<int>(minY));
+     int pixMaxX = std::min(static_cast<int>(GetWidth()) - 1, static_cast<int>(maxX));
+     int pixMaxY = std::min(static_cast<int>(GetHeight()) - 1, static_cast<int>(maxY));
+     int tileMinX = pixMinX / tileWidth, tileMaxX = pixMaxX / tileWidth;
+     int tileMinY = pixMinY / tileHeight, tileMaxY = pixMaxY / tileHeight;
+
+     for (int ty = tileMinY; ty <= tileMaxY; ++ty)
+     {
+          for (int tx = tileMinX; tx <= tileMaxX; ++tx)
+          {
+               // Coarse cell fully in front of the box hides all of its tiles.
+               if (coarse[(ty / coarseTiles) * coarseX + tx / coarseTiles] > zNear)
+               {
+                    continue;
+               }
+
+               const Tile& tile = tiles[ty * tilesX + tx];
+               if (tile.zCommitted > zNear)
+               {
+                    continue;
+               }
+
+               // Pixels of the box rectangle inside this tile may still be hidden by the working layer.
+               int x0 = std::max(pixMinX - tx * static_cast<int>(tileWidth), 0);
+               int x1 = std::min(pixMaxX - tx * static_cast<int>(tileWidth), static_cast<int>(tileWidth) - 1);
+               int y0 = std::max(pixMinY - ty * static_cast<int>(tileHeight), 0);
+               int y1 = std::min(pixMaxY - ty * static_cast<int>(tileHeight), static_cast<int>(tileHeight) - 1);
+               uint32_t rowMask = ((1u << (x1 - x0 + 1)) - 1) << x0;
+               uint32_t rectMask = 0;
+               for (int row = y0; row <= y1; ++row)
+               {
+                    rectMask |= rowMask << (row * tileWidth);
+               }
+               if (tile.zWorking > zNear && (tile.mask & rectMask) == rectMask)
+               {
+                    continue;
+               }
+
+               return true;
+          }
+     }
+
+     return false;
+}
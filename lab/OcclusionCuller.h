@@ -0,0 +1,51 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+// Software occlusion culling against a low resolution masked depth buffer.
+// The buffer is split into 8x4 pixel tiles, every tile keeps a depth that covers the whole tile
+// and a working layer made of a coverage mask and its depth. Depth is reversed: 1 is near, 0 is far.
+class OcclusionCuller
+{
+public:
+     // Function to allocate buffer, size is rounded up to whole tiles
+     void Init(unsigned width, unsigned height);
+     // Function to reset depth and set view-projection used by following calls
+     void Clear(const DirectX::XMMATRIX& viewProj);
+     // Function to rasterize indexed triangle list as occluder, positions are read as XMFLOAT3 at the given stride
+     void RenderOccluder(const void* vertices, size_t vertexStride, size_t vertexCount,
+          const uint16_t* indices, size_t indexCount, const DirectX::XMMATRIX& world);
+     // Function to update coarse level, call after the last occluder
+     void BuildHierarchy();
+     // Function to check box against occluders, returns false only if box is fully hidden
+     bool TestAABB(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extent) const;
+
+     unsigned GetWidth() const { return tilesX * tileWidth; }
+     unsigned GetHeight() const { return tilesY * tileHeight; }
+private:
+     struct Tile
+     {
+          uint32_t mask;    // pixels covered by the working layer
+          float zWorking;   // farthest depth of the working layer
+          float zCommitted; // farthest depth of occluders covering the whole tile
+     };
+
+     static constexpr unsigned tileWidth = 8;
+     static constexpr unsigned tileHeight = 4;
+     static constexpr unsigned coarseTiles = 4;  // tiles per coarse cell side
+     static constexpr float minW = 1e-4f;
+
+     void RasterizeTriangle(DirectX::FXMVECTOR v0, DirectX::FXMVECTOR v1, DirectX::FXMVECTOR v2);
+     void UpdateTile(Tile& tile, uint32_t mask, float z);
+
+     DirectX::XMMATRIX viewProj;
+     unsigned tilesX = 0;
+     unsigned tilesY = 0;
+     unsigned coarseX = 0;
+     unsigned coarseY = 0;
+     std::vector<Tile> tiles;
+     std::vector<float> coarse;  // farthest committed depth over a block of tiles
+     std::vector<DirectX::XMFLOAT4> transformed;
+};
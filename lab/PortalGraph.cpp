@@ -0,0 +1,169 @@
+#include "PortalGraph.h"
+
+#include <cmath>
+
+int PortalGraph::AddCell(const XMFLOAT3& center, const XMFLOAT3& extent)
+{
+     Cell cell;
+     cell.center = center;
+     cell.extent = extent;
+     cells.push_back(std::move(cell));
+     onPath.push_back(0);
+     return static_cast<int>(cells.size()) - 1;
+}
+
+int PortalGraph::AddPortal(int cellA, int cellB, const XMFLOAT3 corners[4])
+{
+     Portal portal;
+     portal.cells[0] = cellA;
+     portal.cells[1] = cellB;
+     for (int i = 0; i < 4; i++)
+     {
+          portal.corners[i] = corners[i];
+     }
+     portals.push_back(portal);
+
+     int idx = static_cast<int>(portals.size()) - 1;
+     cells[cellA].portals.push_back(idx);
+     cells[cellB].portals.push_back(idx);
+     return idx;
+}
+
+void PortalGraph::AddInstance(int cell, uint32_t instance)
+{
+     cells[cell].instances.push_back(instance);
+}
+
+void PortalGraph::ClearInstances()
+{
+     for (Cell& cell : cells)
+     {
+          cell.instances.clear();
+     }
+}
+
+void PortalGraph::Clear()
+{
+     cells.clear();
+     portals.clear();
+     onPath.clear();
+}
+
+int PortalGraph::FindCell(const XMFLOAT3& point) const
+{
+     for (size_t idx = 0; idx < cells.size(); ++idx)
+     {
+          const Cell& cell = cells[idx];
+          if (fabsf(point.x - cell.center.x) <= cell.extent.x
+               && fabsf(point.y - cell.center.y) <= cell.extent.y
+               && fabsf(point.z - cell.center.z) <= cell.extent.z)
+          {
+               return static_cast<int>(idx);
+          }
+     }
+     return -1;
+}
+
+size_t PortalGraph::Cull(const Frustum& frustum, const XMFLOAT3& eye, const BoundsSoA& bounds, uint8_t* visibleMask)
+{
+     visitedCells = 0;
+     int cell = FindCell(eye);
+     if (cell < 0)
+     {
+          return 0;
+     }
+
+     Visit(cell, frustum, frustum, eye, bounds, visibleMask, 0);
+     return visitedCells;
+}
+
+void PortalGraph::Visit(int cellIdx, const Frustum& view, const Frustum& frustum, const XMFLOAT3& eye, const BoundsSoA& bounds, uint8_t* visibleMask, int depth)
+{
+     const Cell& cell = cells[cellIdx];
+     ++visitedCells;
+     onPath[cellIdx] = 1;
+
+     for (uint32_t instance : cell.instances)
+     {
+          if (visibleMask[instance])
+          {
+               continue;
+          }
+          XMFLOAT3 center(bounds.centerX[instance], bounds.centerY[instance], bounds.centerZ[instance]);
+          XMFLOAT3 extent(bounds.extentX[instance], bounds.extentY[instance], bounds.extentZ[instance]);
+          // Narrowed frustum takes its side planes from the portal only, a portal partly out of the view
+          // would let instances beside the view through without the view test.
+          if (frustum.CheckAABB(center, extent) != FrustumTest::Outside && view.CheckAABB(center, extent) != FrustumTest::Outside)
+          {
+               visibleMask[instance] = 1;
+          }
+     }
+
+     if (depth < maxDepth)
+     {
+          for (int portalIdx : cell.portals)
+          {
+               const Portal& portal = portals[portalIdx];
+               int next = portal.cells[0] == cellIdx ? portal.cells[1] : portal.cells[0];
+               if (onPath[next] || !IsPortalVisible(portal, frustum))
+               {
+                    continue;
+               }
+
+               // Eye standing in the portal plane sees the whole next cell through the current frustum.
+               Frustum narrowed;
+               narrowed.ConstructFromPortal(frustum, eye, portal.corners);
+               Visit(next, view, narrowed, eye, bounds, visibleMask, depth + 1);
+               frustum.AddStats(narrowed.GetStats());
+          }
+     }
+
+     onPath[cellIdx] = 0;
+}
+
+bool PortalGraph::IsPortalVisible(const Portal& portal, const Frustum& frustum) const
+{
+     // Sutherland-Hodgman clipping of the quad by all planes, each plane adds at most one vertex.
+     static constexpr int maxVertices = 4 + 6;
+     XMFLOAT3 buffers[2][maxVertices];
+     int counts[2] = { 4, 0 };
+     for (int i = 0; i < 4; i++)
+     {
+          buffers[0][i] = portal.corners[i];
+     }
+
+     int current = 0;
+     for (int planeIdx = 0; planeIdx < 6; planeIdx++)
+     {
+          XMFLOAT4 plane = frustum.GetPlane(planeIdx);
+          const XMFLOAT3* input = buffers[current];
+          XMFLOAT3* output = buffers[current ^ 1];
+          int inputCount = counts[current];
+          int outputCount = 0;
+
+          for (int i = 0; i < inputCount; i++)
+          {
+               const XMFLOAT3& a = input[i];
+               const XMFLOAT3& b = input[(i + 1) % inputCount];
+               float da = plane.x * a.x + plane.y * a.y + plane.z * a.z + plane.w;
+               float db = plane.x * b.x + plane.y * b.y + plane.z * b.z + plane.w;
+               if (da >= 0.0f)
+               {
+                    output[outputCount++] = a;
+               }
+               if ((da >= 0.0f) != (db >= 0.0f))
+               {
+                    float t = da / (da - db);
+                    output[outputCount++] = XMFLOAT3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+               }
+          }
+
+          if (outputCount == 0)
+          {
+               return false;
+          }
+          counts[current ^ 1] = outputCount;
+          current ^= 1;
+     }
+     return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Bounds.h"
+#include "Frustum.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace DirectX;
+
+// Cells connected by convex quad portals. Cells are traversed from the one containing the eye,
+// every portal narrows the frustum it is seen through, instances of reached cells are tested
+// against the narrowed frustum only.
+class PortalGraph
+{
+public:
+     // Longest chain of portals followed from the view cell
+     static constexpr int maxDepth = 16;
+
+     // Function to add cell with box used to locate the eye, returns cell index
+     int AddCell(const XMFLOAT3& center, const XMFLOAT3& extent);
+     // Function to connect two cells through a convex quad, corners go around the quad, returns portal index
+     int AddPortal(int cellA, int cellB, const XMFLOAT3 corners[4]);
+     // Function to register instance in cell, an instance crossing cells is added to each of them
+     void AddInstance(int cell, uint32_t instance);
+     // Function to unregister every instance and keep cells and portals
+     void ClearInstances();
+     void Clear();
+
+     size_t GetCellCount() const { return cells.size(); }
+     // Function to find the first cell containing point, returns -1 if there is none
+     int FindCell(const XMFLOAT3& point) const;
+
+     // Function to set visibleMask[instance] to 1 for instances of reachable cells inside the narrowed frustums.
+     // Returns number of visited cells, 0 means eye is outside of every cell and nothing was culled
+     size_t Cull(const Frustum& frustum, const XMFLOAT3& eye, const BoundsSoA& bounds, uint8_t* visibleMask);
+private:
+     struct Cell
+     {
+          XMFLOAT3 center;
+          XMFLOAT3 extent;
+          std::vector<int> portals;
+          std::vector<uint32_t> instances;
+     };
+
+     struct Portal
+     {
+          int cells[2];
+          XMFLOAT3 corners[4];
+     };
+
+     void Visit(int cell, const Frustum& view, const Frustum& frustum, const XMFLOAT3& eye, const BoundsSoA& bounds, uint8_t* visibleMask, int depth);
+     // Function to clip portal quad by frustum planes, returns true if anything is left
+     bool IsPortalVisible(const Portal& portal, const Frustum& frustum) const;
+
+     std::vector<Cell> cells;
+     std::vector<Portal> portals;
+     // Cells on the current traversal path, they are not entered again to avoid cycles
+     std::vector<uint8_t> onPath;
+     size_t visitedCells = 0;
+};
@@ -0,0 +1,153 @@
+#include "PvsBaker.h"
+
+#include "CubeMesh.h"
+#include "MultiFrustum.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+     const XMFLOAT3 faceDirections[6] = {
+          { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+          { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+     };
+
+     const XMFLOAT3 faceUps[6] = {
+          { 0.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f },
+          { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+     };
+}
+
+void PvsBaker::Bake(ThreadPool& pool, const BoundsSoA& bounds, const TransformsSoA& transforms, const XMFLOAT3& localCenter,
+     const XMFLOAT3& localExtent, const std::vector<uint8_t>& solid, const XMFLOAT3& sceneMin, const XMFLOAT3& sceneMax,
+     const PvsBakeSettings& settings, PvsTable& table)
+{
+     XMUINT3 dims(
+          std::max(1u, static_cast<unsigned>(ceilf((sceneMax.x - sceneMin.x) / settings.cellSize.x))),
+          std::max(1u, static_cast<unsigned>(ceilf((sceneMax.y - sceneMin.y) / settings.cellSize.y))),
+          std::max(1u, static_cast<unsigned>(ceilf((sceneMax.z - sceneMin.z) / settings.cellSize.z))));
+     size_t cellCount = static_cast<size_t>(dims.x) * dims.y * dims.z;
+
+     std::vector<OcclusionCuller> occlusion(pool.GetThreadCount());
+     for (OcclusionCuller& buffer : occlusion)
+     {
+          buffer.Init(settings.resolution, settings.resolution);
+     }
+
+     // Boxes are grown once by the margin that covers views between samples.
+     XMFLOAT3 margin(settings.cellSize.x * settings.margin, settings.cellSize.y * settings.margin, settings.cellSize.z * settings.margin);
+     BoundsSoA grown = bounds;
+     for (size_t idx = 0; idx < grown.Size(); ++idx)
+     {
+          grown.extentX[idx] += margin.x;
+          grown.extentY[idx] += margin.y;
+          grown.extentZ[idx] += margin.z;
+     }
+
+     // Unit cube to the local box, the world transform of an instance follows.
+     XMMATRIX localBox = XMMatrixMultiply(XMMatrixScaling(2.0f * localExtent.x, 2.0f * localExtent.y, 2.0f * localExtent.z),
+          XMMatrixTranslation(localCenter.x, localCenter.y, localCenter.z));
+
+     std::vector<Bitset> cellSets(cellCount);
+     pool.ParallelFor(cellCount, [&](size_t cell, unsigned thread)
+          {
+               size_t x = cell % dims.x;
+               size_t y = cell / dims.x % dims.y;
+               size_t z = cell / dims.x / dims.y;
+               XMFLOAT3 cellMin(
+                    sceneMin.x + x * settings.cellSize.x,
+                    sceneMin.y + y * settings.cellSize.y,
+                    sceneMin.z + z * settings.cellSize.z);
+               BakeCell(cellMin, bounds, grown, transforms, localBox, solid, settings, occlusion[thread], cellSets[cell]);
+          });
+
+     table.Build(sceneMin, settings.cellSize, dims, bounds.Size(), cellSets);
+}
+
+void PvsBaker::BakeCell(const XMFLOAT3& cellMin, const BoundsSoA& bounds, const BoundsSoA& grown, const TransformsSoA& transforms,
+     FXMMATRIX localBox, const std::vector<uint8_t>& solid, const PvsBakeSettings& settings, OcclusionCuller& occlusion,
+     Bitset& visible) const
+{
+     visible.Resize(bounds.Size());
+
+     // Projection matches the renderer: left handed with reversed depth.
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, settings.farZ, settings.nearZ);
+     Frustum frustum;
+     frustum.Init(settings.nearZ);
+     MultiFrustum faces;
+     std::vector<uint32_t> faceMasks(bounds.Size());
+     std::vector<uint32_t> faceVisible[6];
+     std::vector<uint32_t> solidIds;
+     for (uint32_t idx = 0; idx < bounds.Size(); ++idx)
+     {
+          if (solid[idx])
+          {
+               solidIds.push_back(idx);
+          }
+     }
+     std::vector<float> distances(bounds.Size());
+
+     unsigned steps = std::max(1u, settings.samplesPerAxis);
+     for (unsigned s = 0; s < steps * steps * steps; ++s)
+     {
+          float tx = steps > 1 ? float(s % steps) / (steps - 1) : 0.5f;
+          float ty = steps > 1 ? float(s / steps % steps) / (steps - 1) : 0.5f;
+          float tz = steps > 1 ? float(s / steps / steps) / (steps - 1) : 0.5f;
+          XMVECTOR eye = XMVectorSet(
+               cellMin.x + tx * settings.cellSize.x,
+               cellMin.y + ty * settings.cellSize.y,
+               cellMin.z + tz * settings.cellSize.z, 1.0f);
+
+          // All six faces are frustum culled in one pass over the grown boxes.
+          XMMATRIX views[6];
+          faces.Clear();
+          for (int face = 0; face < 6; face++)
+          {
+               views[face] = XMMatrixLookToLH(eye, XMLoadFloat3(&faceDirections[face]), XMLoadFloat3(&faceUps[face]));
+               frustum.ConstructFrustum(views[face], proj);
+               faces.AddView(frustum);
+          }
+          faces.Cull(grown, faceMasks.data(), faceVisible);
+
+          // Occluders go front to back, a far box drawn first would merge into tiles of a nearer one and
+          // keep their depth far.
+          XMFLOAT3 point;
+          XMStoreFloat3(&point, eye);
+          for (uint32_t idx : solidIds)
+          {
+               float dx = std::max(fabsf(bounds.centerX[idx] - point.x) - bounds.extentX[idx], 0.0f);
+               float dy = std::max(fabsf(bounds.centerY[idx] - point.y) - bounds.extentY[idx], 0.0f);
+               float dz = std::max(fabsf(bounds.centerZ[idx] - point.z) - bounds.extentZ[idx], 0.0f);
+               distances[idx] = dx * dx + dy * dy + dz * dz;
+          }
+          std::sort(solidIds.begin(), solidIds.end(), [&distances](uint32_t a, uint32_t b) { return distances[a] < distances[b]; });
+
+          // The world box of a rotated instance covers more than the instance, only its real shape may occlude.
+          for (int face = 0; face < 6; face++)
+          {
+               occlusion.Clear(XMMatrixMultiply(views[face], proj));
+               for (uint32_t idx : solidIds)
+               {
+                    XMMATRIX world = XMMatrixMultiply(localBox, transforms.Get(idx));
+                    occlusion.RenderOccluder(cubePositions, sizeof(XMFLOAT3), sizeof(cubePositions) / sizeof(cubePositions[0]),
+                         cubeIndices, sizeof(cubeIndices) / sizeof(cubeIndices[0]), world);
+               }
+               occlusion.BuildHierarchy();
+
+               for (uint32_t idx : faceVisible[face])
+               {
+                    if (visible.Test(idx))
+                    {
+                         continue;
+                    }
+                    XMFLOAT3 center(grown.centerX[idx], grown.centerY[idx], grown.centerZ[idx]);
+                    XMFLOAT3 extent(grown.extentX[idx], grown.extentY[idx], grown.extentZ[idx]);
+                    if (occlusion.TestAABB(center, extent))
+                    {
+                         visible.Set(idx);
+                    }
+               }
+          }
+     }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Bounds.h"
+#include "OcclusionCuller.h"
+#include "PvsTable.h"
+#include "ThreadPool.h"
+#include "Transforms.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace DirectX;
+
+struct PvsBakeSettings
+{
+     XMFLOAT3 cellSize = XMFLOAT3(4.0f, 4.0f, 4.0f);
+     // Sample points per cell axis, spread over the cell box including its faces
+     unsigned samplesPerAxis = 2;
+     // Side of the square occlusion buffer of every cube map face
+     unsigned resolution = 128;
+     // Tested boxes are grown by this part of the cell size to cover views between samples
+     float margin = 0.25f;
+     float nearZ = 0.05f;
+     float farZ = 100.0f;
+};
+
+// Offline baker of potentially visible sets. From every sample point of a cell the six cube map
+// directions are rasterized into software occlusion buffers, instances marked solid are drawn as the cube
+// filling their local box with their world transform and occlude the rest. Cells are baked in parallel with one occlusion buffer per thread.
+class PvsBaker
+{
+public:
+     // Function to bake sets for grid covering [sceneMin, sceneMax], bounds are the world boxes of the instances
+     // and transforms place their local box [localCenter - localExtent, localCenter + localExtent]
+     void Bake(ThreadPool& pool, const BoundsSoA& bounds, const TransformsSoA& transforms, const XMFLOAT3& localCenter,
+          const XMFLOAT3& localExtent, const std::vector<uint8_t>& solid, const XMFLOAT3& sceneMin, const XMFLOAT3& sceneMax,
+          const PvsBakeSettings& settings, PvsTable& table);
+private:
+     // Function to bake one cell, grown holds the boxes enlarged by the margin
+     void BakeCell(const XMFLOAT3& cellMin, const BoundsSoA& bounds, const BoundsSoA& grown, const TransformsSoA& transforms,
+          FXMMATRIX localBox, const std::vector<uint8_t>& solid, const PvsBakeSettings& settings, OcclusionCuller& occlusion,
+          Bitset& visible) const;
+};
@@ -0,0 +1,203 @@
+#include "PvsTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+     void WriteRun(std::vector<uint8_t>& data, size_t run)
+     {
+          while (run >= 0x80)
+          {
+               data.push_back(static_cast<uint8_t>(run | 0x80));
+               run >>= 7;
+          }
+          data.push_back(static_cast<uint8_t>(run));
+     }
+
+     // Function to read one run, returns false when its bytes go past end or do not fit in 32 bits
+     bool ReadRun(const uint8_t*& pos, const uint8_t* end, size_t& run)
+     {
+          run = 0;
+          for (int shift = 0; pos < end && shift < 32; shift += 7)
+          {
+               uint8_t byte = *pos++;
+               run |= static_cast<size_t>(byte & 0x7F) << shift;
+               if (!(byte & 0x80))
+               {
+                    return true;
+               }
+          }
+          return false;
+     }
+}
+
+void PvsTable::Build(const XMFLOAT3& origin, const XMFLOAT3& cellSize, const XMUINT3& dims, size_t instanceCount,
+     const std::vector<Bitset>& cellSets)
+{
+     this->origin = origin;
+     this->cellSize = cellSize;
+     this->dims = dims;
+     this->instanceCount = instanceCount;
+
+     data.clear();
+     cellOffsets.clear();
+     cellOffsets.reserve(cellSets.size() + 1);
+     for (const Bitset& set : cellSets)
+     {
+          cellOffsets.push_back(static_cast<uint32_t>(data.size()));
+          bool value = false;
+          size_t runStart = 0;
+          for (size_t idx = 0; idx < instanceCount; ++idx)
+          {
+               if (set.Test(idx) != value)
+               {
+                    WriteRun(data, idx - runStart);
+                    runStart = idx;
+                    value = !value;
+               }
+          }
+          WriteRun(data, instanceCount - runStart);
+     }
+     cellOffsets.push_back(static_cast<uint32_t>(data.size()));
+}
+
+void PvsTable::Clear()
+{
+     dims = XMUINT3(0, 0, 0);
+     instanceCount = 0;
+     cellOffsets.clear();
+     data.clear();
+}
+
+bool PvsTable::Save(const char* path) const
+{
+     std::ofstream file(path, std::ios::binary);
+     if (!file)
+     {
+          return false;
+     }
+
+     uint32_t header[] = { fileMagic, dims.x, dims.y, dims.z, static_cast<uint32_t>(instanceCount), static_cast<uint32_t>(data.size()) };
+     float grid[] = { origin.x, origin.y, origin.z, cellSize.x, cellSize.y, cellSize.z };
+     file.write(reinterpret_cast<const char*>(header), sizeof(header));
+     file.write(reinterpret_cast<const char*>(grid), sizeof(grid));
+     file.write(reinterpret_cast<const char*>(cellOffsets.data()), cellOffsets.size() * sizeof(uint32_t));
+     file.write(reinterpret_cast<const char*>(data.data()), data.size());
+     return static_cast<bool>(file);
+}
+
+bool PvsTable::Load(const char* path)
+{
+     Clear();
+     std::ifstream file(path, std::ios::binary);
+     if (!file)
+     {
+          return false;
+     }
+
+     uint32_t header[6];
+     float grid[6];
+     file.read(reinterpret_cast<char*>(header), sizeof(header));
+     file.read(reinterpret_cast<char*>(grid), sizeof(grid));
+     if (!file || header[0] != fileMagic)
+     {
+          return false;
+     }
+
+     // Sizes from the header have to match the rest of the file before anything is allocated.
+     std::streamoff start = file.tellg();
+     file.seekg(0, std::ios::end);
+     uint64_t remaining = static_cast<uint64_t>(file.tellg() - start);
+     file.seekg(start);
+     uint64_t cellCount = static_cast<uint64_t>(header[1]) * header[2] * header[3];
+     if (cellCount == 0 || cellCount > remaining || (cellCount + 1) * sizeof(uint32_t) + header[5] != remaining)
+     {
+          return false;
+     }
+
+     cellOffsets.resize(static_cast<size_t>(cellCount) + 1);
+     data.resize(header[5]);
+     file.read(reinterpret_cast<char*>(cellOffsets.data()), cellOffsets.size() * sizeof(uint32_t));
+     file.read(reinterpret_cast<char*>(data.data()), data.size());
+     if (!file || cellOffsets.front() != 0 || cellOffsets.back() != data.size())
+     {
+          Clear();
+          return false;
+     }
+
+     // Every cell holds at least one run, offsets increase and each cell ends on the last byte of a run.
+     for (size_t cell = 0; cell + 1 < cellOffsets.size(); ++cell)
+     {
+          if (cellOffsets[cell] >= cellOffsets[cell + 1])
+          {
+               Clear();
+               return false;
+          }
+          const uint8_t* pos = data.data() + cellOffsets[cell];
+          const uint8_t* end = data.data() + cellOffsets[cell + 1];
+          size_t run;
+          while (pos < end)
+          {
+               if (!ReadRun(pos, end, run))
+               {
+                    Clear();
+                    return false;
+               }
+          }
+     }
+
+     dims = XMUINT3(header[1], header[2], header[3]);
+     instanceCount = header[4];
+     origin = XMFLOAT3(grid[0], grid[1], grid[2]);
+     cellSize = XMFLOAT3(grid[3], grid[4], grid[5]);
+     return true;
+}
+
+int PvsTable::FindCell(const XMFLOAT3& point) const
+{
+     if (IsEmpty())
+     {
+          return -1;
+     }
+
+     float x = floorf((point.x - origin.x) / cellSize.x);
+     float y = floorf((point.y - origin.y) / cellSize.y);
+     float z = floorf((point.z - origin.z) / cellSize.z);
+     if (x < 0.0f || y < 0.0f || z < 0.0f || x >= dims.x || y >= dims.y || z >= dims.z)
+     {
+          return -1;
+     }
+     return static_cast<int>(x) + static_cast<int>(dims.x) * (static_cast<int>(y) + static_cast<int>(dims.y) * static_cast<int>(z));
+}
+
+bool PvsTable::GetVisibleSet(int cell, Bitset& visible) const
+{
+     if (cell < 0 || static_cast<size_t>(cell) >= GetCellCount())
+     {
+          return false;
+     }
+
+     visible.Resize(instanceCount);
+     const uint8_t* pos = data.data() + cellOffsets[cell];
+     const uint8_t* end = data.data() + cellOffsets[cell + 1];
+     bool value = false;
+     size_t idx = 0;
+     size_t run;
+     while (pos < end && ReadRun(pos, end, run))
+     {
+          // Runs past the instance count are cut, the set never grows over the table size.
+          run = std::min(run, instanceCount - idx);
+          if (value)
+          {
+               for (size_t bit = idx; bit < idx + run; ++bit)
+               {
+                    visible.Set(bit);
+               }
+          }
+          idx += run;
+          value = !value;
+     }
+     return true;
+}
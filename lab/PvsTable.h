@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Bitset.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace DirectX;
+
+// Potentially visible sets of static instances for a regular grid of view cells.
+// Every cell keeps its set as run lengths of alternating clear and set bits, starting with clear ones,
+// each run stored as a variable length integer.
+class PvsTable
+{
+public:
+     // Function to replace table with sets of all cells, cell index is x + dimX * (y + dimY * z)
+     void Build(const XMFLOAT3& origin, const XMFLOAT3& cellSize, const XMUINT3& dims, size_t instanceCount,
+          const std::vector<Bitset>& cellSets);
+     void Clear();
+
+     bool Save(const char* path) const;
+     // Function to read table saved by Save, returns false and leaves the table empty when the file is
+     // truncated or its cell offsets or runs do not fit the data
+     bool Load(const char* path);
+
+     bool IsEmpty() const { return cellOffsets.empty(); }
+     size_t GetInstanceCount() const { return instanceCount; }
+     size_t GetCellCount() const { return IsEmpty() ? 0 : cellOffsets.size() - 1; }
+     size_t GetDataSize() const { return data.size(); }
+
+     // Function to find cell containing point, returns -1 outside of the grid
+     int FindCell(const XMFLOAT3& point) const;
+     // Function to decode set of cell, visible is resized to instance count. Returns false for cells outside of
+     // the grid
+     bool GetVisibleSet(int cell, Bitset& visible) const;
+private:
+     static constexpr uint32_t fileMagic = 0x31535650; // "PVS1"
+
+     XMFLOAT3 origin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+     XMFLOAT3 cellSize = XMFLOAT3(1.0f, 1.0f, 1.0f);
+     XMUINT3 dims = XMUINT3(0, 0, 0);
+     size_t instanceCount = 0;
+     std::vector<uint32_t> cellOffsets;
+     std::vector<uint8_t> data;
+};
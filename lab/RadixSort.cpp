@@ -0,0 +1,47 @@
+#include "RadixSort.h"
+
+#include <stddef.h>
+
+void RadixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values,
+     std::vector<uint64_t>& keyScratch, std::vector<uint32_t>& valueScratch)
+{
+     const size_t count = keys.size();
+     keyScratch.resize(count);
+     valueScratch.resize(count);
+
+     // Histograms of all bytes are gathered in one read of the keys.
+     static constexpr int byteCount = sizeof(uint64_t);
+     size_t histograms[byteCount * 256] = {};
+     for (uint64_t key : keys)
+     {
+          for (int b = 0; b < byteCount; b++)
+          {
+               ++histograms[b * 256 + ((key >> (8 * b)) & 0xFF)];
+          }
+     }
+
+     for (int b = 0; b < byteCount; b++)
+     {
+          size_t* histogram = histograms + b * 256;
+          if (count == 0 || histogram[(keys[0] >> (8 * b)) & 0xFF] == count)
+          {
+               continue;
+          }
+
+          size_t offset = 0;
+          for (int digit = 0; digit < 256; digit++)
+          {
+               size_t digitCount = histogram[digit];
+               histogram[digit] = offset;
+               offset += digitCount;
+          }
+          for (size_t i = 0; i < count; ++i)
+          {
+               size_t dst = histogram[(keys[i] >> (8 * b)) & 0xFF]++;
+               keyScratch[dst] = keys[i];
+               valueScratch[dst] = values[i];
+          }
+          keys.swap(keyScratch);
+          values.swap(valueScratch);
+     }
+}
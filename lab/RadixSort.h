@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// Function to sort keys together with their values by LSD radix sort on bytes. Equal keys keep their order,
+// bytes that are the same in every key cost no pass. Scratch arrays are resized as needed
+void RadixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values,
+     std::vector<uint64_t>& keyScratch, std::vector<uint32_t>& valueScratch);
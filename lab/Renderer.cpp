@@ -1,9 +1,12 @@
 #include "Renderer.h"
+#include "CubeMesh.h"
+#include "DemoScene.h"
 #include "utils.h"
 
 #include <d3dcompiler.h>
 #include "directxtk/DDSTextureLoader.h"
 
+#include <algorithm>
 #include <chrono>
 #include <string>
 #include <cmath>
@@ -100,6 +103,7 @@ bool Renderer::Init(const HWND hWnd, std::shared_ptr<const Camera> pCamera)
      if (!SUCCEEDED(result))
           return false;
 
+     BuildMeshLods();
      result = CreateVertexBuffer();
      if (!SUCCEEDED(result))
           return false;
@@ -108,10 +112,6 @@ bool Renderer::Init(const HWND hWnd, std::shared_ptr<const Camera> pCamera)
      if (!SUCCEEDED(result))
           return false;
 
-     result = CreateWorldMatrixBuffer();
-     if (!SUCCEEDED(result))
-          return false;
-
      result = CreateSceneMatrixBuffer();
      if (!SUCCEEDED(result))
           return false;
@@ -136,7 +136,7 @@ bool Renderer::Init(const HWND hWnd, std::shared_ptr<const Camera> pCamera)
      if (!SUCCEEDED(result))
           return false;
 
-     result = CreateWorldBufferInstVis();
+     result = batchContext.Init(pDevice, pDeviceContext, instanceBatcher.GetPageSize());
      if (!SUCCEEDED(result))
           return false;
 
@@ -204,23 +204,11 @@ bool Renderer::Init(const HWND hWnd, std::shared_ptr<const Camera> pCamera)
                }
           });
 
-     worldMatricies.reserve(maxInst);
-     double deltaAngle = DirectX::XM_2PI / maxInst;
-     double r = 5.0;
-     for (size_t idx = 0; idx < maxInst; ++idx)
-     {
-          WorldMatrixBuffer worldMatrixBuffer;
-          double angle = deltaAngle * idx;
-          worldMatrixBuffer.worldMatrix = DirectX::XMMatrixTranslation(r*std::sin(angle), 0.0f*idx, r*std::cos(angle));
-          worldMatrixBuffer.shine.x = 0.1+0.1*idx;
-          worldMatrixBuffer.shine.z = float(idx % 2);
-          worldMatricies.push_back(std::move(worldMatrixBuffer));
-     }
-
-     frustum.Init(0.1f);
+     BuildDemoScene(scene, instanceBatcher.GetPageSize());
+     scene.LoadPvs("static.pvs");
 
      return sky.Init(pDevice, pDeviceContext, width, height)
-          && trans.Init(pDevice, pDeviceContext, width, height);
+          && trans.Init(pDevice, pDeviceContext, width, height, entities);
 }
 
 bool Renderer::Render()
@@ -267,19 +255,25 @@ bool Renderer::Render()
      pDeviceContext->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
      pDeviceContext->IASetInputLayout(pInputLayout);
      pDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-     pDeviceContext->VSSetConstantBuffers(0, 1, &pWorldMatrixBuffer);
      pDeviceContext->VSSetConstantBuffers(1, 1, &pViewMatrixBuffer);
-     pDeviceContext->VSSetConstantBuffers(2, 1, &pWorldBufferInstVis);
-     pDeviceContext->PSSetConstantBuffers(0, 1, &pWorldMatrixBuffer);
      pDeviceContext->PSSetConstantBuffers(1, 1, &pViewMatrixBuffer);
+     batchContext.Bind();
+     pDeviceContext->PSSetShaderResources(3, 1, &pMaterialView);
      pDeviceContext->PSSetShader(pPixelShader, nullptr, 0);
      pDeviceContext->VSSetShader(pVertexShader, nullptr, 0);
      
-     pDeviceContext->DrawIndexedInstanced(36, ids.size(), 0, 0, 0);
+     for (size_t level = 0; level < cubeLods.size(); ++level)
+     {
+          if (!instanceBatcher.Draw(batchContext, cubeLods[level].mesh, scene.GetLodIds(level), scene.GetLodIdCount(level), uploadIds))
+          {
+               return false;
+          }
+     }
+     uploadIds = false;
 
      sky.Render();
 
-     trans.Render();
+     trans.Render(entities, scene.GetFrustum(), pCamera->GetPosition());
 
      ID3D11RenderTargetView* views[] = { pBackBufferRTV };
      pDeviceContext->OMSetRenderTargets(1, views, pDepthBufferDSV);
@@ -293,6 +287,61 @@ bool Renderer::Render()
      return SUCCEEDED(result);
 }
 
+InstanceHandle Renderer::AddInstance(const DirectX::XMMATRIX& world, uint16_t material)
+{
+     return scene.AddInstance(world, material);
+}
+
+bool Renderer::RemoveInstance(InstanceHandle handle)
+{
+     return scene.RemoveInstance(handle);
+}
+
+bool Renderer::SetInstanceTransform(InstanceHandle handle, const DirectX::XMMATRIX& world)
+{
+     return scene.SetInstanceTransform(handle, world);
+}
+
+bool Renderer::SetInstanceMotion(InstanceHandle handle, const Motion& motion)
+{
+     return scene.SetInstanceMotion(handle, motion);
+}
+
+uint32_t Renderer::AddSceneNode(uint32_t parent, const DirectX::XMMATRIX& local, InstanceHandle instance)
+{
+     return scene.AddSceneNode(parent, local, instance);
+}
+
+bool Renderer::SetSceneNodeTransform(uint32_t node, const DirectX::XMMATRIX& local)
+{
+     return scene.SetSceneNodeTransform(node, local);
+}
+
+uint16_t Renderer::AddMaterial(const Material& material)
+{
+     return scene.AddMaterial(material);
+}
+
+int Renderer::AddCell(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extent)
+{
+     return scene.AddCell(center, extent);
+}
+
+int Renderer::AddPortal(int cellA, int cellB, const DirectX::XMFLOAT3 corners[4])
+{
+     return scene.AddPortal(cellA, cellB, corners);
+}
+
+bool Renderer::AddInstanceToCell(int cell, InstanceHandle handle)
+{
+     return scene.AddInstanceToCell(cell, handle);
+}
+
+void Renderer::SetMinPixelArea(float pixelArea)
+{
+     scene.SetMinPixelArea(pixelArea);
+}
+
 bool Renderer::Update()
 {
      static size_t start = 
@@ -304,27 +353,25 @@ bool Renderer::Update()
 
      DirectX::XMMATRIX view = pCamera->GetViewMatrix();
      DirectX::XMMATRIX proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3, width / (FLOAT)height, 100.0f, 0.1f);
+     DirectX::XMMATRIX viewProj = DirectX::XMMatrixMultiply(view, proj);
+     DirectX::XMFLOAT3 pov = pCamera->GetPosition();
 
-     pDeviceContext->UpdateSubresource(pWorldMatrixBuffer, 0, nullptr, worldMatricies.data(), 0, 0);
-
-     ids.clear();
-     ids.reserve(worldMatricies.size());
-     frustum.ConstructFrustum(view, proj);
-     for (int i = 0; i < worldMatricies.size(); ++i)
+     if (scene.Update(angle, view, proj, pov, pCamera->GetVersion(), height))
      {
-          XMFLOAT4 min, max;
-          XMStoreFloat4(&min, XMVector4Transform(XMLoadFloat4(&AABB[0]), worldMatricies[i].worldMatrix));
-          XMStoreFloat4(&max, XMVector4Transform(XMLoadFloat4(&AABB[1]), worldMatricies[i].worldMatrix));
-          if (frustum.CheckRectangle(max.x, max.y, max.z, min.x, min.y, min.z))
-          {
-               ids.push_back(XMINT4(i, 0, 0, 0));
-          }
+          uploadIds = true;
+     }
+     if (scene.PackInstances(packedInstances)
+          && !instanceBatcher.UploadInstances(batchContext, packedInstances.data(), packedInstances.size(), sizeof(PackedInstance)))
+     {
+          return false;
+     }
+     if (uploadedMaterials != scene.GetMaterials().Size() && FAILED(UploadMaterials()))
+     {
+          return false;
      }
-     pDeviceContext->UpdateSubresource(pWorldBufferInstVis, 0, nullptr, ids.data(), 0, 0);
 
      SceneBuffer sceneBuffer;
-     sceneBuffer.viewProjMatrix = DirectX::XMMatrixMultiply(view, proj);
-     DirectX::XMFLOAT3 pov = pCamera->GetPosition();
+     sceneBuffer.viewProjMatrix = viewProj;
      sceneBuffer.cameraPosition.x = pov.x;
      sceneBuffer.cameraPosition.y = pov.y;
      sceneBuffer.cameraPosition.z = pov.z;
@@ -414,10 +461,66 @@ HRESULT Renderer::CompileShaders()
      return hr;
 }
 
+// Function to build LOD chain of the cube. Levels split every face into a grid, the coarsest
+// level is the cube itself and is also used for occluders
+void Renderer::BuildMeshLods()
+{
+     for (size_t l = 0; l < ARRAYSIZE(cubeLodSubdivisions); ++l)
+     {
+          LodLevel level;
+          level.mesh.startIndex = static_cast<uint32_t>(meshIndices.size());
+          level.mesh.baseVertex = static_cast<int32_t>(meshVertices.size());
+          level.minScreenRadius = cubeLodScreenRadius[l];
+
+          const unsigned n = cubeLodSubdivisions[l];
+          for (size_t face = 0; face < 6; ++face)
+          {
+               // Face corners go around the quad, grid point (i, j) lies between them bilinearly.
+               const Vertex* corners = vertices + face * 4;
+               USHORT first = static_cast<USHORT>(meshVertices.size() - level.mesh.baseVertex);
+               for (unsigned j = 0; j <= n; ++j)
+               {
+                    for (unsigned i = 0; i <= n; ++i)
+                    {
+                         XMVECTOR u = XMVectorReplicate(static_cast<float>(i) / n);
+                         XMVECTOR v = XMVectorReplicate(static_cast<float>(j) / n);
+                         auto lerp = [&](const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c, const XMFLOAT3& d)
+                         {
+                              XMVECTOR bottom = XMVectorLerpV(XMLoadFloat3(&a), XMLoadFloat3(&b), u);
+                              XMVECTOR top = XMVectorLerpV(XMLoadFloat3(&d), XMLoadFloat3(&c), u);
+                              XMFLOAT3 result;
+                              XMStoreFloat3(&result, XMVectorLerpV(bottom, top, v));
+                              return result;
+                         };
+                         XMFLOAT3 uv0(corners[0].uv.x, corners[0].uv.y, 0.0f), uv1(corners[1].uv.x, corners[1].uv.y, 0.0f);
+                         XMFLOAT3 uv2(corners[2].uv.x, corners[2].uv.y, 0.0f), uv3(corners[3].uv.x, corners[3].uv.y, 0.0f);
+                         XMFLOAT3 uv = lerp(uv0, uv1, uv2, uv3);
+                         meshVertices.push_back(Vertex{ lerp(corners[0].pos, corners[1].pos, corners[2].pos, corners[3].pos),
+                              XMFLOAT2(uv.x, uv.y), corners[0].normal, corners[0].tangent });
+                    }
+               }
+               for (unsigned j = 0; j < n; ++j)
+               {
+                    for (unsigned i = 0; i < n; ++i)
+                    {
+                         USHORT a = static_cast<USHORT>(first + j * (n + 1) + i);
+                         USHORT b = a + 1;
+                         USHORT c = static_cast<USHORT>(a + n + 2);
+                         USHORT d = static_cast<USHORT>(a + n + 1);
+                         USHORT cell[6] = { a, c, b, a, d, c };
+                         meshIndices.insert(meshIndices.end(), cell, cell + 6);
+                    }
+               }
+          }
+          level.mesh.indexCount = static_cast<uint32_t>(meshIndices.size()) - level.mesh.startIndex;
+          cubeLods.push_back(level);
+     }
+}
+
 HRESULT Renderer::CreateVertexBuffer()
 {
      D3D11_BUFFER_DESC desc = {};
-     desc.ByteWidth = sizeof(vertices);
+     desc.ByteWidth = static_cast<UINT>(sizeof(Vertex) * meshVertices.size());
      desc.Usage = D3D11_USAGE_IMMUTABLE;
      desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
      desc.CPUAccessFlags = 0;
@@ -425,8 +528,8 @@ HRESULT Renderer::CreateVertexBuffer()
      desc.StructureByteStride = 0;
 
      D3D11_SUBRESOURCE_DATA data;
-     data.pSysMem = &vertices;
-     data.SysMemPitch = sizeof(vertices);
+     data.pSysMem = meshVertices.data();
+     data.SysMemPitch = 0;
      data.SysMemSlicePitch = 0;
 
      return pDevice->CreateBuffer(&desc, &data, &pVertexBuffer);
@@ -435,7 +538,7 @@ HRESULT Renderer::CreateVertexBuffer()
 HRESULT Renderer::CreateIndexBuffer()
 {
      D3D11_BUFFER_DESC desc = {};
-     desc.ByteWidth = sizeof(indices);
+     desc.ByteWidth = static_cast<UINT>(sizeof(USHORT) * meshIndices.size());
      desc.Usage = D3D11_USAGE_IMMUTABLE;
      desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
      desc.CPUAccessFlags = 0;
@@ -443,37 +546,61 @@ HRESULT Renderer::CreateIndexBuffer()
      desc.StructureByteStride = 0;
 
      D3D11_SUBRESOURCE_DATA data;
-     data.pSysMem = &indices;
-     data.SysMemPitch = sizeof(indices);
+     data.pSysMem = meshIndices.data();
+     data.SysMemPitch = 0;
      data.SysMemSlicePitch = 0;
 
      return pDevice->CreateBuffer(&desc, &data, &pIndexBuffer);
 }
 
-HRESULT Renderer::CreateWorldMatrixBuffer()
+// Function to upload materials added since the last upload, the table is read by the pixel shader.
+// The buffer grows at least twice when full and then gets the whole table again
+HRESULT Renderer::UploadMaterials()
 {
-     D3D11_BUFFER_DESC desc = {};
-     desc.ByteWidth = sizeof(WorldMatrixBuffer) * maxInst;
-     desc.Usage = D3D11_USAGE_DEFAULT;
-     desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-     desc.CPUAccessFlags = 0;
-     desc.MiscFlags = 0;
-     desc.StructureByteStride = 0;
+     if (scene.GetMaterials().Size() > materialCapacity)
+     {
+          SAFE_RELEASE(pMaterialView);
+          SAFE_RELEASE(pMaterialBuffer);
+          pMaterialView = nullptr;
+          pMaterialBuffer = nullptr;
+          size_t capacity = std::max<size_t>(scene.GetMaterials().Size(), 2 * materialCapacity);
+          materialCapacity = 0;
+          uploadedMaterials = 0;
+          D3D11_BUFFER_DESC desc = {};
+          desc.ByteWidth = static_cast<UINT>(sizeof(Material) * capacity);
+          desc.Usage = D3D11_USAGE_DEFAULT;
+          desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+          desc.CPUAccessFlags = 0;
+          desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+          desc.StructureByteStride = sizeof(Material);
 
-     return pDevice->CreateBuffer(&desc, NULL, &pWorldMatrixBuffer);
-}
+          HRESULT hr = pDevice->CreateBuffer(&desc, nullptr, &pMaterialBuffer);
+          if (FAILED(hr))
+          {
+               return hr;
+          }
 
-HRESULT Renderer::CreateWorldBufferInstVis()
-{
-     D3D11_BUFFER_DESC desc = {};
-     desc.ByteWidth = sizeof(XMUINT4)*100;
-     desc.Usage = D3D11_USAGE_DEFAULT;
-     desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-     desc.CPUAccessFlags = 0;
-     desc.MiscFlags = 0;
-     desc.StructureByteStride = 0;
+          D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+          viewDesc.Format = DXGI_FORMAT_UNKNOWN;
+          viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+          viewDesc.Buffer.FirstElement = 0;
+          viewDesc.Buffer.NumElements = static_cast<UINT>(capacity);
+          hr = pDevice->CreateShaderResourceView(pMaterialBuffer, &viewDesc, &pMaterialView);
+          if (FAILED(hr))
+          {
+               return hr;
+          }
+          materialCapacity = capacity;
+     }
 
-     return pDevice->CreateBuffer(&desc, NULL, &pWorldBufferInstVis);
+     D3D11_BOX box = {};
+     box.left = static_cast<UINT>(sizeof(Material) * uploadedMaterials);
+     box.right = static_cast<UINT>(sizeof(Material) * scene.GetMaterials().Size());
+     box.bottom = 1;
+     box.back = 1;
+     pDeviceContext->UpdateSubresource(pMaterialBuffer, 0, &box, scene.GetMaterials().GetTable() + uploadedMaterials, 0, 0);
+     uploadedMaterials = scene.GetMaterials().Size();
+     return S_OK;
 }
 
 HRESULT Renderer::CreateSceneMatrixBuffer()
@@ -686,6 +813,7 @@ bool Renderer::Resize(const unsigned width, const unsigned height)
           if (SUCCEEDED(hr)) {
                this->width = width;
                this->height = height;
+               scene.Invalidate();
 
                hr = SetupBackBuffer();
                sky.Resize(width, height);
@@ -730,18 +858,20 @@ void Renderer::Cleanup()
      SAFE_RELEASE(pPixelShader);
      SAFE_RELEASE(pRasterizerState);
      SAFE_RELEASE(pViewMatrixBuffer);
-     SAFE_RELEASE(pWorldMatrixBuffer);
      SAFE_RELEASE(pCubeTextureSampler);
      SAFE_RELEASE(pTextureView);
      SAFE_RELEASE(pCubeNormalsSampler);
      SAFE_RELEASE(pCubeNormalMap);
+     SAFE_RELEASE(pMaterialView);
+     SAFE_RELEASE(pMaterialBuffer);
      SAFE_RELEASE(pDepthBuffer);
      SAFE_RELEASE(pDepthBufferDSV);
      SAFE_RELEASE(pDepthState);
      SAFE_RELEASE(pRenderTargetTexture);
      SAFE_RELEASE(pRenderTargetView);
      SAFE_RELEASE(pShaderResourceViewRenderResult);
-     SAFE_RELEASE(pWorldBufferInstVis);
+     batchContext.Cleanup();
+     instanceBatcher.Reset();
 }
 
 Renderer::~Renderer() {
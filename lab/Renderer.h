@@ -4,7 +4,11 @@
 #include "Sky.h"
 #include "Transparent.h"
 #include "Lights.h"
-#include "Frustum.h"
+#include "D3DBatchContext.h"
+#include "EntityStore.h"
+#include "InstanceBatcher.h"
+#include "LodSelector.h"
+#include "Scene.h"
 #include "PostProc.h"
 
 #include <d3d11.h>
@@ -21,6 +25,28 @@ public:
      bool Update();
      bool Resize(const unsigned width, const unsigned height);
      void Cleanup();
+     // Function to set screen area in pixels below which instances are not drawn
+     void SetMinPixelArea(float pixelArea);
+     const CullingStats& GetCullingStats() const { return scene.GetCullingStats(); }
+
+     // Functions to manage instances, handles stay valid until removal. AddInstance returns null handle
+     // for MaterialRegistry::invalidIndex material
+     InstanceHandle AddInstance(const DirectX::XMMATRIX& world, uint16_t material);
+     bool RemoveInstance(InstanceHandle handle);
+     bool SetInstanceTransform(InstanceHandle handle, const DirectX::XMMATRIX& world);
+     // Function to animate instance from now on, its current rotation and scale are the rest pose. An instance
+     // attached to a scene node moves in the frame of the node, motion center is then relative to the node
+     bool SetInstanceMotion(InstanceHandle handle, const Motion& motion);
+     // Functions to build transform hierarchy, an attached instance follows world transform of its node.
+     // AddSceneNode returns SceneGraph::noParent when parent is neither noParent nor an existing node
+     uint32_t AddSceneNode(uint32_t parent, const DirectX::XMMATRIX& local, InstanceHandle instance = InstanceHandle());
+     bool SetSceneNodeTransform(uint32_t node, const DirectX::XMMATRIX& local);
+     // Function to get index of material, identical materials share one. Returns MaterialRegistry::invalidIndex when full
+     uint16_t AddMaterial(const Material& material);
+     // Functions to build indoor level, see Scene
+     int AddCell(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extent);
+     int AddPortal(int cellA, int cellB, const DirectX::XMFLOAT3 corners[4]);
+     bool AddInstanceToCell(int cell, InstanceHandle handle);
 
      Renderer(const Renderer&) = delete;
      Renderer& operator=(const Renderer&) = delete;
@@ -37,12 +63,6 @@ private:
           DirectX::XMFLOAT4 ambientColor;
      };
 
-     struct WorldMatrixBuffer
-     {
-          DirectX::XMMATRIX worldMatrix;
-          DirectX::XMFLOAT4 shine;
-     };
-
      struct Vertex 
      {
           DirectX::XMFLOAT3 pos;
@@ -82,37 +102,22 @@ private:
           Vertex{{0.5, 0.5, -0.5}, {1, 0}, {0, 0, -1}, {1, 0, 0}},
           Vertex{{-0.5, 0.5, -0.5}, {0, 0}, {0, 0, -1}, {1, 0, 0}}
      };
-     
-     const USHORT indices[36] = {
-        0, 2, 1, 0, 3, 2,
-        4, 6, 5, 4, 7, 6,
-        8, 10, 9, 8, 11, 10,
-        12, 14, 13, 12, 15, 14,
-        16, 18, 17, 16, 19, 18,
-        20, 22, 21, 20, 23, 22
-     };
-
-     const DirectX::XMFLOAT4 AABB[2] = {
-          {-0.5, -0.5, -0.5, 1.0},
-          {0.5,  0.5, 0.5, 1.0}
-     };
 
      static constexpr const DirectX::XMFLOAT4 ambientColor_{ 0.8f, 0.8f, 0.8f, 1.0f };
-     static constexpr const size_t maxInst = 20;
 
      Renderer() = default;
      HRESULT SetupBackBuffer();
      HRESULT CompileShaders();
+     void BuildMeshLods();
      HRESULT CreateVertexBuffer();
      HRESULT CreateIndexBuffer();
-     HRESULT CreateWorldMatrixBuffer();
-     HRESULT CreateWorldBufferInstVis();
      HRESULT CreateSceneMatrixBuffer();
      HRESULT CreateRasterizerState();
      HRESULT CreateTextures();
      HRESULT CreateSamplers();
      HRESULT CreateDepthBuffer();
      HRESULT CreateDepthState();
+     HRESULT UploadMaterials();
      HRESULT InitRenderTargetTexture();
 
      std::shared_ptr<const Camera> pCamera = nullptr;
@@ -130,13 +135,13 @@ private:
      ID3D11Buffer* pVertexBuffer = nullptr;
      ID3D11Buffer* pIndexBuffer = nullptr;
 
-     ID3D11Buffer* pWorldMatrixBuffer = nullptr;
-     ID3D11Buffer* pWorldBufferInstVis = nullptr;
      ID3D11Buffer* pViewMatrixBuffer = nullptr;
      ID3D11RasterizerState* pRasterizerState = nullptr;
 
      ID3D11ShaderResourceView* pTextureView = nullptr;
      ID3D11ShaderResourceView* pCubeNormalMap = nullptr;
+     ID3D11Buffer* pMaterialBuffer = nullptr;
+     ID3D11ShaderResourceView* pMaterialView = nullptr;
 
      ID3D11SamplerState* pCubeTextureSampler = nullptr;
      ID3D11SamplerState* pCubeNormalsSampler = nullptr;
@@ -150,11 +155,21 @@ private:
 
      Sky sky;
      Transparent trans;
+     EntityStore entities;
      Lights lights;
-     std::vector<WorldMatrixBuffer> worldMatricies;
-     Frustum frustum;
+     Scene scene;
+     std::vector<PackedInstance> packedInstances;
+     // Materials already in pMaterialBuffer and its capacity in materials
+     size_t uploadedMaterials = 0;
+     size_t materialCapacity = 0;
+     bool uploadIds = false;
      PostProc postProc;
-     std::vector<XMINT4> ids;
+     // Cube mesh with every LOD level, levels are ranges of the vertex and index buffers
+     std::vector<Vertex> meshVertices;
+     std::vector<USHORT> meshIndices;
+     std::vector<LodLevel> cubeLods;
+     InstanceBatcher instanceBatcher;
+     D3DBatchContext batchContext;
 
      ID3D11Texture2D* pRenderTargetTexture = nullptr;
      ID3D11RenderTargetView* pRenderTargetView = nullptr;
@@ -0,0 +1,647 @@
+#include "Scene.h"
+#include "CubeMesh.h"
+#include "RadixSort.h"
+#include "SpatialOrder.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace DirectX;
+
+void Scene::Init(const XMFLOAT3& localCenter, const XMFLOAT3& localExtent, const std::vector<LodLevel>& lods, size_t idsPerDraw)
+{
+     this->localCenter = localCenter;
+     this->localExtent = localExtent;
+     this->lods = lods;
+     this->idsPerDraw = std::max<size_t>(idsPerDraw, 1);
+     frustum.Init(0.1f);
+     lodSelector.Init(lodHysteresis);
+     occlusionCuller.Init(occlusionWidth, occlusionHeight);
+     contributionCuller.Init(minPixelArea);
+}
+
+void Scene::Build()
+{
+     UpdateSceneGraph();
+     UpdateInstanceBounds();
+     // The static hierarchy refers to dense positions, which the sort changes.
+     ReleaseStaticInstances();
+     SortInstances();
+     BuildStaticTree();
+     movedInstances.clear();
+     culledTransformVersion = instances.transforms.version;
+}
+
+bool Scene::LoadPvs(const char* path)
+{
+     if (!pvsTable.Load(path) || pvsTable.GetInstanceCount() != instances.Size())
+     {
+          pvsTable.Clear();
+          return false;
+     }
+     pvsCell = -1;
+     cullingDirty = true;
+     return true;
+}
+
+void Scene::BakePvs(const PvsBakeSettings& settings, PvsTable& table)
+{
+     XMFLOAT3 sceneMin(0.0f, 0.0f, 0.0f);
+     XMFLOAT3 sceneMax(0.0f, 0.0f, 0.0f);
+     std::vector<uint8_t> solid(instances.Size());
+     const BoundsSoA& bounds = instances.bounds;
+     for (size_t idx = 0; idx < instances.Size(); ++idx)
+     {
+          XMFLOAT3 boxMin(bounds.centerX[idx] - bounds.extentX[idx], bounds.centerY[idx] - bounds.extentY[idx],
+               bounds.centerZ[idx] - bounds.extentZ[idx]);
+          XMFLOAT3 boxMax(bounds.centerX[idx] + bounds.extentX[idx], bounds.centerY[idx] + bounds.extentY[idx],
+               bounds.centerZ[idx] + bounds.extentZ[idx]);
+          if (idx == 0)
+          {
+               sceneMin = boxMin;
+               sceneMax = boxMax;
+          }
+          sceneMin = XMFLOAT3(std::min(sceneMin.x, boxMin.x), std::min(sceneMin.y, boxMin.y), std::min(sceneMin.z, boxMin.z));
+          sceneMax = XMFLOAT3(std::max(sceneMax.x, boxMax.x), std::max(sceneMax.y, boxMax.y), std::max(sceneMax.z, boxMax.z));
+          solid[idx] = instances.animations.flags[idx] == MotionNone;
+     }
+
+     // The eye may stand outside of every instance, one cell around the bounds covers views from close by.
+     sceneMin = XMFLOAT3(sceneMin.x - settings.cellSize.x, sceneMin.y - settings.cellSize.y, sceneMin.z - settings.cellSize.z);
+     sceneMax = XMFLOAT3(sceneMax.x + settings.cellSize.x, sceneMax.y + settings.cellSize.y, sceneMax.z + settings.cellSize.z);
+     PvsBaker baker;
+     baker.Bake(threadPool, bounds, instances.transforms, localCenter, localExtent, solid, sceneMin, sceneMax, settings, table);
+}
+
+void Scene::SetMinPixelArea(float pixelArea)
+{
+     contributionCuller.SetMinPixelArea(pixelArea);
+     cullingDirty = true;
+}
+
+void Scene::SetPlaneCache(bool enabled)
+{
+     instanceTree.SetPlaneCache(enabled);
+     cullingDirty = true;
+}
+
+InstanceHandle Scene::AddInstance(const XMMATRIX& world, uint16_t material)
+{
+     // Failed AddMaterial must not reach the shaders as an index past the material table.
+     if (material == MaterialRegistry::invalidIndex)
+     {
+          return InstanceHandle();
+     }
+
+     InstanceHandle handle = instances.Add(world, material, maxDrawDistance);
+     OnInstancesChanged();
+     return handle;
+}
+
+bool Scene::RemoveInstance(InstanceHandle handle)
+{
+     if (!instances.IsValid(handle))
+     {
+          return false;
+     }
+
+     // Removal moves the last instance, static ones are handed to the dynamic tree before positions change.
+     ReleaseStaticInstances();
+     uint32_t idx = instances.GetIndex(handle);
+     if (instances.proxies[idx] != DynamicAABBTree::nullNode)
+     {
+          instanceTree.DestroyProxy(instances.proxies[idx]);
+     }
+     // The last instance takes the freed position, its proxy has to point there.
+     if (instances.Remove(handle) != InstanceStore::npos && instances.proxies[idx] != DynamicAABBTree::nullNode)
+     {
+          instanceTree.SetUserData(instances.proxies[idx], idx);
+     }
+     OnInstancesChanged();
+     return true;
+}
+
+bool Scene::SetInstanceTransform(InstanceHandle handle, const XMMATRIX& world)
+{
+     if (!instances.IsValid(handle))
+     {
+          return false;
+     }
+
+     instances.transforms.Set(instances.GetIndex(handle), world);
+     worldChanged = true;
+     return true;
+}
+
+bool Scene::SetInstanceMotion(InstanceHandle handle, const Motion& motion)
+{
+     if (!instances.IsValid(handle))
+     {
+          return false;
+     }
+
+     // Rest pose is kept relative to the frame the motion happens in.
+     uint32_t idx = instances.GetIndex(handle);
+     XMMATRIX base = instances.animations.GetBase(idx);
+     instances.animations.Set(idx, motion, XMMatrixMultiply(instances.transforms.Get(idx), XMMatrixInverse(nullptr, base)));
+     animateInstances = animateInstances || motion.flags != MotionNone;
+     return true;
+}
+
+uint32_t Scene::AddSceneNode(uint32_t parent, const XMMATRIX& local, InstanceHandle instance)
+{
+     if (parent != SceneGraph::noParent && parent >= sceneGraph.Size())
+     {
+          return SceneGraph::noParent;
+     }
+
+     nodeInstances.push_back(instance);
+     return sceneGraph.AddNode(parent, local);
+}
+
+bool Scene::SetSceneNodeTransform(uint32_t node, const XMMATRIX& local)
+{
+     if (node >= sceneGraph.Size())
+     {
+          return false;
+     }
+
+     sceneGraph.SetLocal(node, local);
+     return true;
+}
+
+uint16_t Scene::AddMaterial(const Material& material)
+{
+     return materials.Add(material);
+}
+
+int Scene::AddCell(const XMFLOAT3& center, const XMFLOAT3& extent)
+{
+     cullingDirty = true;
+     return portalGraph.AddCell(center, extent);
+}
+
+int Scene::AddPortal(int cellA, int cellB, const XMFLOAT3 corners[4])
+{
+     int cellCount = static_cast<int>(portalGraph.GetCellCount());
+     if (cellA < 0 || cellA >= cellCount || cellB < 0 || cellB >= cellCount || cellA == cellB)
+     {
+          return -1;
+     }
+
+     cullingDirty = true;
+     return portalGraph.AddPortal(cellA, cellB, corners);
+}
+
+bool Scene::AddInstanceToCell(int cell, InstanceHandle handle)
+{
+     if (cell < 0 || cell >= static_cast<int>(portalGraph.GetCellCount()) || !instances.IsValid(handle))
+     {
+          return false;
+     }
+
+     cellInstances.emplace_back(cell, handle);
+     portalCellsDirty = true;
+     cullingDirty = true;
+     return true;
+}
+
+// Function to propagate changed scene node transforms to world transforms of attached instances,
+// animated ones move in the frame of their node
+void Scene::UpdateSceneGraph()
+{
+     updatedNodes.clear();
+     cullingStats.sceneNodesUpdated = sceneGraph.Update(threadPool, updatedNodes);
+     for (uint32_t node : updatedNodes)
+     {
+          // Removed instances leave stale handles behind.
+          if (instances.IsValid(nodeInstances[node]))
+          {
+               uint32_t idx = instances.GetIndex(nodeInstances[node]);
+               XMMATRIX world = sceneGraph.GetWorld(node);
+               instances.transforms.Set(idx, world);
+               instances.animations.SetBase(idx, world);
+               worldChanged = true;
+          }
+     }
+}
+
+// Function to evaluate procedural motions into instance transforms, chunks run in parallel
+void Scene::AnimateInstances(float time)
+{
+     animatedCounts.assign(threadPool.GetThreadCount(), 0);
+     size_t chunkCount = (instances.Size() + VisibilityPass::chunkSize - 1) / VisibilityPass::chunkSize;
+     threadPool.ParallelFor(chunkCount, [&](size_t chunk, unsigned thread)
+          {
+               size_t begin = chunk * VisibilityPass::chunkSize;
+               size_t end = std::min<size_t>(begin + VisibilityPass::chunkSize, instances.Size());
+               animatedCounts[thread] += AnimateTransforms(instances.animations, time, begin, end, instances.transforms);
+          });
+
+     size_t animated = std::accumulate(animatedCounts.begin(), animatedCounts.end(), size_t(0));
+     cullingStats.animatedInstances = animated;
+     // Nothing to do in later frames until a motion is set again.
+     animateInstances = animated > 0;
+     if (animated > 0)
+     {
+          ++instances.transforms.version;
+          worldChanged = true;
+     }
+}
+
+// Function to invalidate state that depends on dense instance positions
+void Scene::OnInstancesChanged()
+{
+     cullingDirty = true;
+     worldChanged = true;
+     // Baked sets and portal cells are keyed by dense position.
+     pvsTable.Clear();
+     pvsCell = -1;
+     portalCellsDirty = true;
+}
+
+// Function to size per instance culling arrays to the instance count
+void Scene::ResizeInstanceArrays()
+{
+     if (instanceVisibility.size() == instances.Size() && ids.size() == instances.Size() + 3)
+     {
+          return;
+     }
+     instanceVisibility.resize(instances.Size());
+     instanceDrawMask.Resize(instances.Size());
+     // Compaction writes up to three ids past the visible count.
+     ids.assign(instances.Size() + 3, 0);
+}
+
+// Function to register current dense positions of cell instances in the portal graph, removed ones are dropped
+void Scene::UpdatePortalCells()
+{
+     portalGraph.ClearInstances();
+     size_t kept = 0;
+     for (const std::pair<int, InstanceHandle>& member : cellInstances)
+     {
+          if (instances.IsValid(member.second))
+          {
+               portalGraph.AddInstance(member.first, instances.GetIndex(member.second));
+               cellInstances[kept++] = member;
+          }
+     }
+     cellInstances.resize(kept);
+     portalCellsDirty = false;
+}
+
+// Function to store instances in Morton order of their bound centers, so instances close in space
+// are close in memory and visible ids form longer runs. Handles stay valid
+void Scene::SortInstances()
+{
+     std::vector<uint32_t> order;
+     ComputeMortonOrder(instances.bounds, order);
+     instances.Reorder(order);
+     for (uint32_t idx = 0; idx < instances.Size(); ++idx)
+     {
+          if (instances.proxies[idx] != DynamicAABBTree::nullNode)
+          {
+               instanceTree.SetUserData(instances.proxies[idx], idx);
+          }
+     }
+     portalCellsDirty = true;
+     cullingDirty = true;
+     worldChanged = true;
+}
+
+// Function to refresh world bounds and tree proxies of instances whose transform changed
+void Scene::UpdateInstanceBounds()
+{
+     movedInstances.clear();
+     UpdateWorldBounds(instances.transforms, localCenter, localExtent, instances.bounds, movedInstances);
+     for (uint32_t idx : movedInstances)
+     {
+          XMFLOAT3 center(instances.bounds.centerX[idx], instances.bounds.centerY[idx], instances.bounds.centerZ[idx]);
+          XMFLOAT3 extent(instances.bounds.extentX[idx], instances.bounds.extentY[idx], instances.bounds.extentZ[idx]);
+          int32_t& proxy = instances.proxies[idx];
+          if (proxy == DynamicAABBTree::nullNode)
+          {
+               proxy = instanceTree.CreateProxy(center, extent, idx);
+          }
+          else
+          {
+               instanceTree.MoveProxy(proxy, center, extent);
+          }
+     }
+}
+
+// Function to move instances without motion or scene node from the dynamic tree to the static hierarchy
+void Scene::BuildStaticTree()
+{
+     std::vector<uint8_t> attached(instances.Size(), 0);
+     for (InstanceHandle handle : nodeInstances)
+     {
+          if (instances.IsValid(handle))
+          {
+               attached[instances.GetIndex(handle)] = 1;
+          }
+     }
+
+     staticInstances.clear();
+     for (uint32_t idx = 0; idx < instances.Size(); ++idx)
+     {
+          if (instances.animations.flags[idx] == MotionNone && !attached[idx] && instances.proxies[idx] != DynamicAABBTree::nullNode)
+          {
+               instanceTree.DestroyProxy(instances.proxies[idx]);
+               instances.proxies[idx] = DynamicAABBTree::nullNode;
+               staticInstances.push_back(idx);
+          }
+     }
+     staticTree.Build(instances.bounds, staticInstances.data(), staticInstances.size(), threadPool.GetThreadCount());
+}
+
+// Function to give static instances proxies in the dynamic tree and drop the static hierarchy
+void Scene::ReleaseStaticInstances()
+{
+     if (staticInstances.empty())
+     {
+          return;
+     }
+
+     for (uint32_t idx : staticInstances)
+     {
+          if (instances.proxies[idx] == DynamicAABBTree::nullNode)
+          {
+               XMFLOAT3 center(instances.bounds.centerX[idx], instances.bounds.centerY[idx], instances.bounds.centerZ[idx]);
+               XMFLOAT3 extent(instances.bounds.extentX[idx], instances.bounds.extentY[idx], instances.bounds.extentZ[idx]);
+               instances.proxies[idx] = instanceTree.CreateProxy(center, extent, idx);
+          }
+     }
+     staticInstances.clear();
+     staticTree.Clear();
+}
+
+// Function to run the full visibility pass and rebuild the draw mask
+void Scene::CullInstances(const XMMATRIX& view, const XMMATRIX& proj, const XMMATRIX& viewProj, const XMFLOAT3& pov,
+     unsigned viewportHeight)
+{
+     frustum.ConstructFrustum(view, proj);
+     std::fill(instanceVisibility.begin(), instanceVisibility.end(), 0);
+     if (portalCellsDirty)
+     {
+          UpdatePortalCells();
+     }
+     // Indoor levels register instances in portal cells, the tree covers everything outside of them.
+     portalCulled = portalGraph.GetCellCount() > 0
+          && portalGraph.Cull(frustum, pov, instances.bounds, instanceVisibility.data()) > 0;
+     if (!portalCulled)
+     {
+          instanceTree.Query(threadPool, frustum, instances.bounds, instanceVisibility.data());
+          // Static instances that moved since Build are in the dynamic tree now, their static boxes are stale.
+          staticVisible.clear();
+          staticTree.Cull(frustum, staticVisible);
+          for (uint32_t idx : staticVisible)
+          {
+               if (instances.proxies[idx] == DynamicAABBTree::nullNode)
+               {
+                    instanceVisibility[idx] = 1;
+               }
+          }
+     }
+
+     // Baked sets of the camera cell remove static instances hidden from anywhere in the cell,
+     // animated ones were not where the baker saw them.
+     int cell = pvsTable.FindCell(pov);
+     if (cell >= 0 && cell != pvsCell)
+     {
+          pvsCell = pvsTable.GetVisibleSet(cell, pvsVisible) ? cell : -1;
+     }
+     pvsCulled = cell >= 0 && cell == pvsCell;
+     if (pvsCulled)
+     {
+          for (size_t idx = 0; idx < pvsVisible.Size(); ++idx)
+          {
+               instanceVisibility[idx] &= static_cast<uint8_t>(pvsVisible.Test(idx) || instances.animations.flags[idx] != MotionNone);
+          }
+     }
+     contributionCuller.Setup(pov, proj, viewportHeight);
+     visibilityPass.Gather(threadPool, instanceVisibility.size(),
+          [this](size_t begin, size_t end, std::vector<uint32_t>& output)
+          {
+               contributionCuller.Cull(instances.bounds, instances.maxDistances.data(), begin, end, instanceVisibility.data());
+               for (size_t idx = begin; idx < end; ++idx)
+               {
+                    if (instanceVisibility[idx])
+                    {
+                         output.push_back(static_cast<uint32_t>(idx));
+                    }
+               }
+          }, visibleInstances);
+     cullingStats.inFrustum = visibleInstances.size();
+
+     // Nearest visible instances occlude the rest.
+     occluderCount = std::partial_sort_copy(visibleInstances.begin(), visibleInstances.end(), occluders, occluders + maxOccluders,
+          [this, &pov](uint32_t a, uint32_t b) { return InstanceDistanceSq(a, pov) < InstanceDistanceSq(b, pov); }) - occluders;
+     occlusionCuller.Clear(viewProj);
+     for (size_t i = 0; i < occluderCount; ++i)
+     {
+          occlusionCuller.RenderOccluder(cubePositions, sizeof(XMFLOAT3), sizeof(cubePositions) / sizeof(cubePositions[0]),
+               cubeIndices, sizeof(cubeIndices) / sizeof(cubeIndices[0]), instances.transforms.Get(occluders[i]));
+     }
+     occlusionCuller.BuildHierarchy();
+
+     // Every task owns whole words of the bitset, so bits are set without synchronization.
+     threadPool.ParallelFor(instanceDrawMask.GetWordCount(), [this](size_t word, unsigned)
+          {
+               uint32_t bits = 0;
+               size_t end = std::min<size_t>(word * 32 + 32, instanceVisibility.size());
+               for (size_t idx = word * 32; idx < end; ++idx)
+               {
+                    if (instanceVisibility[idx] && IsInstanceUnoccluded(idx))
+                    {
+                         bits |= 1u << (idx & 31);
+                    }
+               }
+               instanceDrawMask.words[word] = bits;
+          });
+}
+
+// Function to re-test moved instances against the last culled view,
+// returns false when a full pass is needed because the occluder set may change
+bool Scene::UpdateMovedVisibility(const XMFLOAT3& pov)
+{
+     if (movedInstances.empty())
+     {
+          return true;
+     }
+     if (portalCulled || pvsCulled || occluderCount < maxOccluders)
+     {
+          return false;
+     }
+
+     float occluderDistanceSq = 0.0f;
+     for (size_t i = 0; i < occluderCount; ++i)
+     {
+          occluderDistanceSq = std::max<float>(occluderDistanceSq, InstanceDistanceSq(occluders[i], pov));
+     }
+
+     // Moved boxes go through the same batch test the tree uses for its leaves.
+     movedVisibility.resize(movedInstances.size());
+     frustum.CheckAABBBatch(instances.bounds, movedInstances.data(), movedInstances.size(), movedVisibility.data());
+     for (size_t i = 0; i < movedInstances.size(); ++i)
+     {
+          uint32_t idx = movedInstances[i];
+          if (std::find(occluders, occluders + occluderCount, idx) != occluders + occluderCount)
+          {
+               return false;
+          }
+
+          cullingStats.inFrustum -= instanceVisibility[idx];
+          instanceVisibility[idx] = movedVisibility[i];
+          contributionCuller.Cull(instances.bounds, instances.maxDistances.data(), idx, idx + 1, instanceVisibility.data());
+          cullingStats.inFrustum += instanceVisibility[idx];
+          if (instanceVisibility[idx] && InstanceDistanceSq(idx, pov) <= occluderDistanceSq)
+          {
+               return false;
+          }
+     }
+
+     for (uint32_t idx : movedInstances)
+     {
+          uint32_t bit = 1u << (idx & 31);
+          if (instanceVisibility[idx] && IsInstanceUnoccluded(idx))
+          {
+               instanceDrawMask.words[idx >> 5] |= bit;
+          }
+          else
+          {
+               instanceDrawMask.words[idx >> 5] &= ~bit;
+          }
+     }
+     return true;
+}
+
+float Scene::InstanceDistanceSq(uint32_t idx, const XMFLOAT3& pov) const
+{
+     float dx = instances.bounds.centerX[idx] - pov.x;
+     float dy = instances.bounds.centerY[idx] - pov.y;
+     float dz = instances.bounds.centerZ[idx] - pov.z;
+     return dx * dx + dy * dy + dz * dz;
+}
+
+bool Scene::IsInstanceUnoccluded(size_t idx) const
+{
+     XMFLOAT3 center(instances.bounds.centerX[idx], instances.bounds.centerY[idx], instances.bounds.centerZ[idx]);
+     XMFLOAT3 extent(instances.bounds.extentX[idx], instances.bounds.extentY[idx], instances.bounds.extentZ[idx]);
+     return occlusionCuller.TestAABB(center, extent);
+}
+
+// Function to sort visible ids into lodIds by 48 bit keys: LOD level (mesh) in bits 40-47, material
+// in bits 24-39 and view depth quantized to 24 bits below. Draws of a level stay contiguous, instances
+// sharing a material (texture slice and shading) go together and front to back for early depth rejection
+void Scene::SortVisibleInstances(const XMMATRIX& view)
+{
+     XMFLOAT4X4 v;
+     XMStoreFloat4x4(&v, view);
+     const float depthScale = static_cast<float>(0xFFFFFF) / maxDrawDistance;
+
+     sortKeys.resize(idCount);
+     lodIds.assign(ids.begin(), ids.begin() + idCount);
+     size_t chunkCount = (idCount + VisibilityPass::chunkSize - 1) / VisibilityPass::chunkSize;
+     threadPool.ParallelFor(chunkCount, [&](size_t chunk, unsigned)
+          {
+               size_t begin = chunk * VisibilityPass::chunkSize;
+               size_t end = std::min<size_t>(begin + VisibilityPass::chunkSize, idCount);
+               for (size_t i = begin; i < end; ++i)
+               {
+                    uint32_t idx = lodIds[i];
+                    float depth = instances.bounds.centerX[idx] * v._13 + instances.bounds.centerY[idx] * v._23
+                         + instances.bounds.centerZ[idx] * v._33 + v._43;
+                    float quantized = std::min<float>(std::max<float>(depth * depthScale, 0.0f), static_cast<float>(0xFFFFFF));
+                    sortKeys[i] = static_cast<uint64_t>(instances.lods[idx]) << 40
+                         | static_cast<uint64_t>(instances.materials[idx]) << 24
+                         | static_cast<uint64_t>(quantized);
+               }
+          });
+     RadixSort(sortKeys, lodIds, sortKeyScratch, sortScratch);
+
+     // Level l takes [lodOffsets[l], lodOffsets[l + 1]) of the sorted ids.
+     size_t i = 0;
+     for (size_t level = 0; level <= LodSelector::maxLevels; ++level)
+     {
+          while (i < idCount && (sortKeys[i] >> 40) < level)
+          {
+               ++i;
+          }
+          lodOffsets[level] = i;
+     }
+}
+
+bool Scene::Update(float time, const XMMATRIX& view, const XMMATRIX& proj, const XMFLOAT3& pov, uint64_t cameraVersion,
+     unsigned viewportHeight)
+{
+     UpdateSceneGraph();
+     cullingStats.animatedInstances = 0;
+     if (animateInstances)
+     {
+          AnimateInstances(time);
+     }
+     ResizeInstanceArrays();
+
+     movedInstances.clear();
+     if (instances.transforms.version != culledTransformVersion)
+     {
+          UpdateInstanceBounds();
+          culledTransformVersion = instances.transforms.version;
+     }
+
+     // Previous visible ids stay valid while neither the view nor any instance changed.
+     // Moved instances alone are re-tested unless they can change the occluder set.
+     frustum.ResetStats();
+     cullingStats.fullPass = false;
+     bool idsChanged = !movedInstances.empty();
+     if (cullingDirty || cameraVersion != culledCameraVersion || !UpdateMovedVisibility(pov))
+     {
+          CullInstances(view, proj, XMMatrixMultiply(view, proj), pov, viewportHeight);
+          culledCameraVersion = cameraVersion;
+          cullingDirty = false;
+          idsChanged = true;
+          cullingStats.fullPass = true;
+     }
+
+     if (idsChanged)
+     {
+          idCount = CompactBitset(instanceDrawMask, ids.data());
+          lodSelector.Setup(pov, proj, viewportHeight);
+          lodSelector.Select(threadPool, lods, instances.bounds, ids.data(), idCount, instances.lods.data());
+          SortVisibleInstances(view);
+     }
+     cullingStats.frustum = frustum.GetStats();
+     cullingStats.instances = instanceVisibility.size();
+     cullingStats.drawn = idCount;
+     cullingStats.drawCalls = 0;
+     cullingStats.triangles = 0;
+     for (size_t level = 0; level < lods.size(); ++level)
+     {
+          size_t count = GetLodIdCount(level);
+          cullingStats.drawCalls += (count + idsPerDraw - 1) / idsPerDraw;
+          cullingStats.triangles += count * lods[level].mesh.indexCount / 3;
+     }
+     cullingStats.trianglesWithoutLod = lods.empty() ? 0 : idCount * lods[0].mesh.indexCount / 3;
+     cullingStats.movedInstances = movedInstances.size();
+     return idsChanged;
+}
+
+bool Scene::PackInstances(std::vector<PackedInstance>& packed)
+{
+     if (!worldChanged)
+     {
+          return false;
+     }
+
+     packed.resize(instances.Size());
+     size_t chunkCount = (instances.Size() + VisibilityPass::chunkSize - 1) / VisibilityPass::chunkSize;
+     threadPool.ParallelFor(chunkCount, [&](size_t chunk, unsigned)
+          {
+               size_t begin = chunk * VisibilityPass::chunkSize;
+               size_t end = std::min<size_t>(begin + VisibilityPass::chunkSize, instances.Size());
+               PackTransforms(instances.transforms, instances.materials.data(), begin, end, packed.data() + begin);
+          });
+     worldChanged = false;
+     return true;
+}
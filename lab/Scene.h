@@ -0,0 +1,186 @@
+#pragma once
+
+#include "Animation.h"
+#include "BVH.h"
+#include "Bitset.h"
+#include "ContributionCuller.h"
+#include "DynamicAABBTree.h"
+#include "Frustum.h"
+#include "InstanceStore.h"
+#include "LodSelector.h"
+#include "MaterialRegistry.h"
+#include "OcclusionCuller.h"
+#include "PortalGraph.h"
+#include "PvsBaker.h"
+#include "PvsTable.h"
+#include "SceneGraph.h"
+#include "ThreadPool.h"
+#include "Transforms.h"
+#include "VisibilityPass.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+// Visibility counters of the last Scene::Update
+struct CullingStats
+{
+     FrustumStats frustum;
+     size_t instances = 0;
+     // Instances left after frustum, portal, PVS, size and distance culling
+     size_t inFrustum = 0;
+     size_t drawn = 0;
+     size_t drawCalls = 0;
+     size_t triangles = 0;
+     // Triangles the drawn instances would take with the most detailed LOD
+     size_t trianglesWithoutLod = 0;
+     size_t movedInstances = 0;
+     size_t sceneNodesUpdated = 0;
+     size_t animatedInstances = 0;
+     bool fullPass = false;
+};
+
+// Instances of one mesh with everything that decides which of them are drawn: transform hierarchy,
+// procedural motion, spatial tree, portal cells, baked visible sets, culling, LOD selection and draw order.
+// Nothing here touches the device, the renderer uploads what Update produces.
+class Scene
+{
+public:
+     static constexpr unsigned occlusionWidth = 320;
+     static constexpr unsigned occlusionHeight = 192;
+     static constexpr size_t maxOccluders = 8;
+     static constexpr float minPixelArea = 4.0f;
+     static constexpr float maxDrawDistance = 100.0f;
+     static constexpr float lodHysteresis = 0.1f;
+
+     // Function to start scene, threadCount 0 means one thread per hardware thread
+     explicit Scene(unsigned threadCount = 0) : threadPool(threadCount) {}
+
+     // Function to set mesh box and LOD chain shared by all instances, idsPerDraw is only used to count draw calls
+     void Init(const DirectX::XMFLOAT3& localCenter, const DirectX::XMFLOAT3& localExtent, const std::vector<LodLevel>& lods,
+          size_t idsPerDraw);
+     // Function to compute bounds of instances added so far and store them in Morton order, call once after setup.
+     // Instances without motion or scene node go to a static BVH, moving and later added ones to the dynamic tree
+     void Build();
+     // Function to load baked visible sets, they are dropped when made for a different instance count
+     bool LoadPvs(const char* path);
+     // Function to bake visible sets of the built scene for grid one cell larger than instance bounds. Instances
+     // without motion are solid occluders, animated ones are drawn from every cell whatever their baked bit
+     void BakePvs(const PvsBakeSettings& settings, PvsTable& table);
+     // Function to set screen area in pixels below which instances are not drawn
+     void SetMinPixelArea(float pixelArea);
+     // Function to turn caching of the rejecting frustum plane per tree node on or off, on by default
+     void SetPlaneCache(bool enabled);
+
+     // Functions to manage instances, handles stay valid until removal. AddInstance returns null handle
+     // for MaterialRegistry::invalidIndex material
+     InstanceHandle AddInstance(const DirectX::XMMATRIX& world, uint16_t material);
+     bool RemoveInstance(InstanceHandle handle);
+     bool SetInstanceTransform(InstanceHandle handle, const DirectX::XMMATRIX& world);
+     // Function to animate instance from now on, its current rotation and scale are the rest pose. An instance
+     // attached to a scene node moves in the frame of the node, motion center is then relative to the node
+     bool SetInstanceMotion(InstanceHandle handle, const Motion& motion);
+     // Functions to build transform hierarchy, an attached instance follows world transform of its node.
+     // AddSceneNode returns SceneGraph::noParent when parent is neither noParent nor an existing node
+     uint32_t AddSceneNode(uint32_t parent, const DirectX::XMMATRIX& local, InstanceHandle instance = InstanceHandle());
+     bool SetSceneNodeTransform(uint32_t node, const DirectX::XMMATRIX& local);
+     // Function to get index of material, identical materials share one. Returns MaterialRegistry::invalidIndex when full
+     uint16_t AddMaterial(const Material& material);
+     // Functions to build indoor level: while the eye is inside a cell only instances of cells seen through
+     // portals are drawn. An instance crossing cells is added to each of them, returns -1 or false on bad cells
+     int AddCell(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extent);
+     int AddPortal(int cellA, int cellB, const DirectX::XMFLOAT3 corners[4]);
+     bool AddInstanceToCell(int cell, InstanceHandle handle);
+
+     // Function to advance motions to time and update visibility for the view. The last result is kept while
+     // neither cameraVersion nor any instance changed, moved instances alone are re-tested when they cannot
+     // change the occluder set. Returns true when the visible ids changed
+     bool Update(float time, const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& proj, const DirectX::XMFLOAT3& pov,
+          uint64_t cameraVersion, unsigned viewportHeight);
+     // Function to force a full visibility pass on the next Update
+     void Invalidate() { cullingDirty = true; }
+     // Function to pack transforms changed since the last call, returns false when nothing changed
+     bool PackInstances(std::vector<PackedInstance>& packed);
+
+     const InstanceStore& GetInstances() const { return instances; }
+     const MaterialRegistry& GetMaterials() const { return materials; }
+     const Frustum& GetFrustum() const { return frustum; }
+     const CullingStats& GetCullingStats() const { return cullingStats; }
+     // Function to get bit per dense instance position, set for instances drawn after the last Update
+     const Bitset& GetDrawMask() const { return instanceDrawMask; }
+     const std::vector<LodLevel>& GetLods() const { return lods; }
+     // Functions to get visible ids drawn with LOD level, sorted by material and front to back
+     const uint32_t* GetLodIds(size_t level) const { return lodIds.data() + lodOffsets[level]; }
+     size_t GetLodIdCount(size_t level) const { return lodOffsets[level + 1] - lodOffsets[level]; }
+private:
+     void OnInstancesChanged();
+     void ResizeInstanceArrays();
+     void UpdatePortalCells();
+     void SortInstances();
+     void UpdateInstanceBounds();
+     void BuildStaticTree();
+     void ReleaseStaticInstances();
+     void UpdateSceneGraph();
+     void AnimateInstances(float time);
+     void SortVisibleInstances(const DirectX::XMMATRIX& view);
+     void CullInstances(const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& proj, const DirectX::XMMATRIX& viewProj,
+          const DirectX::XMFLOAT3& pov, unsigned viewportHeight);
+     bool UpdateMovedVisibility(const DirectX::XMFLOAT3& pov);
+     float InstanceDistanceSq(uint32_t idx, const DirectX::XMFLOAT3& pov) const;
+     bool IsInstanceUnoccluded(size_t idx) const;
+
+     ThreadPool threadPool;
+     VisibilityPass visibilityPass;
+     Frustum frustum;
+     InstanceStore instances;
+     SceneGraph sceneGraph;
+     // Instance attached to every scene node, indexed by node id
+     std::vector<InstanceHandle> nodeInstances;
+     std::vector<uint32_t> updatedNodes;
+     bool animateInstances = false;
+     std::vector<size_t> animatedCounts;
+     MaterialRegistry materials;
+     bool worldChanged = false;
+     DirectX::XMFLOAT3 localCenter = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+     DirectX::XMFLOAT3 localExtent = DirectX::XMFLOAT3(0.5f, 0.5f, 0.5f);
+     std::vector<uint32_t> movedInstances;
+     DynamicAABBTree instanceTree;
+     // Hierarchy over instances that had no motion at Build. They have no proxy in instanceTree until they move,
+     // so its results count only for instances still without one
+     BVH staticTree;
+     std::vector<uint32_t> staticInstances;
+     std::vector<uint32_t> staticVisible;
+     PortalGraph portalGraph;
+     // Cell membership by handle, the graph gets dense positions again whenever they change
+     std::vector<std::pair<int, InstanceHandle>> cellInstances;
+     bool portalCellsDirty = false;
+     bool portalCulled = false;
+     PvsTable pvsTable;
+     Bitset pvsVisible;
+     int pvsCell = -1;
+     bool pvsCulled = false;
+     std::vector<uint8_t> instanceVisibility;
+     std::vector<uint32_t> visibleInstances;
+     std::vector<uint8_t> movedVisibility;
+     Bitset instanceDrawMask;
+     ContributionCuller contributionCuller;
+     OcclusionCuller occlusionCuller;
+     uint32_t occluders[maxOccluders] = {};
+     size_t occluderCount = 0;
+     uint64_t culledCameraVersion = 0;
+     uint64_t culledTransformVersion = 0;
+     bool cullingDirty = true;
+     CullingStats cullingStats;
+     std::vector<uint32_t> ids;
+     size_t idCount = 0;
+     size_t idsPerDraw = 1;
+     std::vector<LodLevel> lods;
+     LodSelector lodSelector;
+     // Visible ids sorted by LOD level, material and depth, with their sort keys
+     std::vector<uint32_t> lodIds;
+     std::vector<uint64_t> sortKeys;
+     std::vector<uint64_t> sortKeyScratch;
+     std::vector<uint32_t> sortScratch;
+     size_t lodOffsets[LodSelector::maxLevels + 1] = {};
+};
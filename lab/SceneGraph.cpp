@@ -0,0 +1,252 @@
+#include "SceneGraph.h"
+#include "SpatialOrder.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace DirectX;
+
+uint32_t SceneGraph::AddNode(uint32_t parent, FXMMATRIX localMatrix)
+{
+     // The node goes to the end until the next Update puts it to its level.
+     uint32_t id = static_cast<uint32_t>(parentIds.size());
+     uint32_t pos = static_cast<uint32_t>(nodeIds.size());
+     parentIds.push_back(parent);
+     positions.push_back(pos);
+     nodeIds.push_back(id);
+     parents.push_back(parent == noParent ? noParent : positions[parent]);
+     local.Resize(pos + 1);
+     local.Set(pos, localMatrix);
+     layoutDirty = true;
+     return id;
+}
+
+void SceneGraph::SetLocal(uint32_t node, FXMMATRIX localMatrix)
+{
+     local.Set(positions[node], localMatrix);
+}
+
+void SceneGraph::Clear()
+{
+     parentIds.clear();
+     positions.clear();
+     nodeIds.clear();
+     parents.clear();
+     local.Resize(0);
+     world.Resize(0);
+     levels.clear();
+     layoutDirty = false;
+}
+
+// Function to sort nodes breadth first, children of a node stay next to each other
+void SceneGraph::Rebuild()
+{
+     const size_t count = nodeIds.size();
+
+     std::vector<uint32_t> childStart(count + 1, 0);
+     for (uint32_t parent : parents)
+     {
+          if (parent != noParent)
+          {
+               ++childStart[parent + 1];
+          }
+     }
+     for (size_t pos = 0; pos < count; ++pos)
+     {
+          childStart[pos + 1] += childStart[pos];
+     }
+     std::vector<uint32_t> children(childStart[count]);
+     std::vector<uint32_t> childFill(childStart.begin(), childStart.end() - 1);
+     for (uint32_t pos = 0; pos < count; ++pos)
+     {
+          if (parents[pos] != noParent)
+          {
+               children[childFill[parents[pos]]++] = pos;
+          }
+     }
+
+     std::vector<uint32_t> order;
+     order.reserve(count);
+     for (uint32_t pos = 0; pos < count; ++pos)
+     {
+          if (parents[pos] == noParent)
+          {
+               order.push_back(pos);
+          }
+     }
+     levels.assign(1, 0);
+     for (size_t begin = 0; begin < order.size();)
+     {
+          size_t end = order.size();
+          levels.push_back(end);
+          for (size_t idx = begin; idx < end; ++idx)
+          {
+               order.insert(order.end(), children.begin() + childStart[order[idx]], children.begin() + childStart[order[idx] + 1]);
+          }
+          begin = end;
+     }
+
+     ApplyOrder(nodeIds, order);
+     for (auto& row : local.m)
+     {
+          for (auto& column : row)
+          {
+               ApplyOrder(column, order);
+          }
+     }
+     for (uint32_t pos = 0; pos < count; ++pos)
+     {
+          positions[nodeIds[pos]] = pos;
+     }
+     for (uint32_t pos = 0; pos < count; ++pos)
+     {
+          uint32_t parent = parentIds[nodeIds[pos]];
+          parents[pos] = parent == noParent ? noParent : positions[parent];
+     }
+
+     // Every world matrix moved, all of them are recomputed.
+     std::fill(local.dirty.begin(), local.dirty.end(), 1);
+     world.Resize(count);
+     layoutDirty = false;
+}
+
+// Function to update world matrices in [begin, end) of one level below the roots, parents are already up to date
+void SceneGraph::UpdateRange(size_t begin, size_t end)
+{
+     uint8_t* dirty = local.dirty.data();
+     size_t pos = begin;
+     for (; pos + 4 <= end; pos += 4)
+     {
+          uint32_t flags = 0;
+          for (size_t lane = 0; lane < 4; ++lane)
+          {
+               dirty[pos + lane] |= dirty[parents[pos + lane]];
+               flags |= dirty[pos + lane];
+          }
+          if (!flags)
+          {
+               continue;
+          }
+
+          // Parent rows are gathered into lanes, then four affine products run side by side.
+          XMVECTOR parent[4][3];
+          for (int k = 0; k < 4; k++)
+          {
+               for (int c = 0; c < 3; c++)
+               {
+                    const float* column = world.m[k][c].data();
+                    parent[k][c] = XMVectorSet(column[parents[pos]], column[parents[pos + 1]],
+                         column[parents[pos + 2]], column[parents[pos + 3]]);
+               }
+          }
+          for (int r = 0; r < 4; r++)
+          {
+               XMVECTOR l0 = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(local.m[r][0].data() + pos));
+               XMVECTOR l1 = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(local.m[r][1].data() + pos));
+               XMVECTOR l2 = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(local.m[r][2].data() + pos));
+               for (int c = 0; c < 3; c++)
+               {
+                    XMVECTOR value = r == 3 ? parent[3][c] : XMVectorZero();
+                    value = XMVectorMultiplyAdd(l0, parent[0][c], value);
+                    value = XMVectorMultiplyAdd(l1, parent[1][c], value);
+                    value = XMVectorMultiplyAdd(l2, parent[2][c], value);
+                    XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(world.m[r][c].data() + pos), value);
+               }
+          }
+     }
+
+     for (; pos < end; ++pos)
+     {
+          dirty[pos] |= dirty[parents[pos]];
+          if (!dirty[pos])
+          {
+               continue;
+          }
+          uint32_t parent = parents[pos];
+          for (int r = 0; r < 4; r++)
+          {
+               for (int c = 0; c < 3; c++)
+               {
+                    float value = r == 3 ? world.m[3][c][parent] : 0.0f;
+                    for (int k = 0; k < 3; k++)
+                    {
+                         value += local.m[r][k][pos] * world.m[k][c][parent];
+                    }
+                    world.m[r][c][pos] = value;
+               }
+          }
+     }
+}
+
+size_t SceneGraph::Update(ThreadPool& pool, std::vector<uint32_t>& updated)
+{
+     if (layoutDirty)
+     {
+          Rebuild();
+     }
+     if (levels.size() < 2)
+     {
+          return 0;
+     }
+
+     // Roots copy their local transform.
+     for (size_t pos = 0; pos < levels[1]; ++pos)
+     {
+          if (local.dirty[pos])
+          {
+               for (int r = 0; r < 4; r++)
+               {
+                    for (int c = 0; c < 3; c++)
+                    {
+                         world.m[r][c][pos] = local.m[r][c][pos];
+                    }
+               }
+          }
+     }
+
+     for (size_t level = 1; level + 1 < levels.size(); ++level)
+     {
+          size_t begin = levels[level];
+          size_t end = levels[level + 1];
+          if (end - begin < splitWidth)
+          {
+               UpdateRange(begin, end);
+               continue;
+          }
+          pool.ParallelFor((end - begin + splitChunk - 1) / splitChunk, [&](size_t chunk, unsigned)
+               {
+                    size_t chunkBegin = begin + chunk * splitChunk;
+                    UpdateRange(chunkBegin, std::min(chunkBegin + splitChunk, end));
+               });
+     }
+
+     // Groups of eight clean nodes are skipped with one load.
+     const size_t count = nodeIds.size();
+     const size_t first = updated.size();
+     uint8_t* dirty = local.dirty.data();
+     for (size_t pos = 0; pos < count; pos += 8)
+     {
+          uint64_t flags = 0;
+          if (pos + 8 <= count)
+          {
+               memcpy(&flags, dirty + pos, sizeof(flags));
+               if (!flags)
+               {
+                    continue;
+               }
+          }
+          for (size_t lane = pos; lane < std::min(pos + 8, count); ++lane)
+          {
+               if (dirty[lane])
+               {
+                    dirty[lane] = 0;
+                    updated.push_back(nodeIds[lane]);
+               }
+          }
+     }
+     if (updated.size() != first)
+     {
+          ++world.version;
+     }
+     return updated.size() - first;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include "Transforms.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+// Transform hierarchy stored in breadth first order, so every level is a contiguous range placed after
+// its parents. World matrices are recomputed only for nodes whose local transform or any ancestor changed.
+// Node ids given by AddNode stay valid, positions change when nodes are added
+class SceneGraph
+{
+public:
+     static constexpr uint32_t noParent = 0xFFFFFFFF;
+     // Levels at least this wide are updated in parallel chunks
+     static constexpr size_t parallelWidth = 8192;
+     static constexpr size_t chunkSize = 2048;
+
+     // Function to add node under existing parent or as a root, returns node id
+     uint32_t AddNode(uint32_t parent, DirectX::FXMMATRIX local);
+     void SetLocal(uint32_t node, DirectX::FXMMATRIX local);
+     DirectX::XMMATRIX GetLocal(uint32_t node) const { return local.Get(positions[node]); }
+     // Function to get world matrix as of the last Update
+     DirectX::XMMATRIX GetWorld(uint32_t node) const { return world.Get(positions[node]); }
+     void Clear();
+     // Function to change the level width updated in parallel and the chunk size, which must not be 0. Defaults are the constants above
+     void SetParallelSplit(size_t width, size_t chunk) { splitWidth = width; splitChunk = chunk; }
+
+     // Function to recompute world matrices of changed nodes and their descendants, ids of updated nodes are
+     // appended to updated. Returns the number of updated matrices
+     size_t Update(ThreadPool& pool, std::vector<uint32_t>& updated);
+
+     size_t Size() const { return nodeIds.size(); }
+     size_t GetLevelCount() const { return levels.empty() ? 0 : levels.size() - 1; }
+private:
+     void Rebuild();
+     void UpdateRange(size_t begin, size_t end);
+
+     // Indexed by node id
+     std::vector<uint32_t> parentIds;
+     std::vector<uint32_t> positions;
+     // Indexed by position, local dirty flags mark changed nodes until Update
+     std::vector<uint32_t> nodeIds;
+     std::vector<uint32_t> parents;
+     TransformsSoA local;
+     TransformsSoA world;
+     // Start positions of levels and the node count at the end
+     std::vector<size_t> levels;
+     bool layoutDirty = false;
+     size_t splitWidth = parallelWidth;
+     size_t splitChunk = chunkSize;
+};
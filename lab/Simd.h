@@ -0,0 +1,41 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Function to gather sign bits of the four lanes of a comparison result into bits 0..3
+inline uint32_t XMVectorMoveMask(DirectX::FXMVECTOR v)
+{
+#if defined(_XM_SSE_INTRINSICS_)
+     return static_cast<uint32_t>(_mm_movemask_ps(v));
+#else
+     uint32_t lanes[4];
+     DirectX::XMStoreInt4(lanes, v);
+     return (lanes[0] >> 31) | ((lanes[1] >> 31) << 1) | ((lanes[2] >> 31) << 2) | ((lanes[3] >> 31) << 3);
+#endif
+}
+
+// Function to get index of the lowest set bit, value must not be zero
+inline unsigned BitScanForward32(uint32_t value)
+{
+#if defined(_MSC_VER)
+     unsigned long idx;
+     _BitScanForward(&idx, value);
+     return static_cast<unsigned>(idx);
+#else
+     return static_cast<unsigned>(__builtin_ctz(value));
+#endif
+}
+
+// Function to count set bits
+inline unsigned BitCount32(uint32_t value)
+{
+#if defined(_MSC_VER)
+     return __popcnt(value);
+#else
+     return static_cast<unsigned>(__builtin_popcount(value));
+#endif
+}
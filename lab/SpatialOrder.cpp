@@ -0,0 +1,61 @@
+#include "SpatialOrder.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+     // Function to spread low 10 bits so that two zero bits follow each of them
+     uint32_t ExpandBits(uint32_t value)
+     {
+          value &= 0x3FF;
+          value = (value | (value << 16)) & 0x030000FF;
+          value = (value | (value << 8)) & 0x0300F00F;
+          value = (value | (value << 4)) & 0x030C30C3;
+          value = (value | (value << 2)) & 0x09249249;
+          return value;
+     }
+}
+
+uint32_t MortonCode3(uint32_t x, uint32_t y, uint32_t z)
+{
+     return (ExpandBits(x) << 2) | (ExpandBits(y) << 1) | ExpandBits(z);
+}
+
+void ComputeMortonOrder(const BoundsSoA& bounds, std::vector<uint32_t>& order)
+{
+     size_t count = bounds.Size();
+     float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+     float maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
+     for (size_t idx = 0; idx < count; ++idx)
+     {
+          minX = std::min(minX, bounds.centerX[idx]);
+          minY = std::min(minY, bounds.centerY[idx]);
+          minZ = std::min(minZ, bounds.centerZ[idx]);
+          maxX = std::max(maxX, bounds.centerX[idx]);
+          maxY = std::max(maxY, bounds.centerY[idx]);
+          maxZ = std::max(maxZ, bounds.centerZ[idx]);
+     }
+
+     // Centers are quantized to 1024 steps per axis of their own bounding box.
+     auto scale = [](float min, float max) { return max > min ? 1023.0f / (max - min) : 0.0f; };
+     float scaleX = scale(minX, maxX), scaleY = scale(minY, maxY), scaleZ = scale(minZ, maxZ);
+
+     std::vector<uint64_t> keys(count);
+     for (size_t idx = 0; idx < count; ++idx)
+     {
+          uint32_t code = MortonCode3(
+               static_cast<uint32_t>((bounds.centerX[idx] - minX) * scaleX),
+               static_cast<uint32_t>((bounds.centerY[idx] - minY) * scaleY),
+               static_cast<uint32_t>((bounds.centerZ[idx] - minZ) * scaleZ));
+          // Index in the low half keeps equal codes in their original order.
+          keys[idx] = (static_cast<uint64_t>(code) << 32) | idx;
+     }
+     std::sort(keys.begin(), keys.end());
+
+     order.resize(count);
+     for (size_t idx = 0; idx < count; ++idx)
+     {
+          order[idx] = static_cast<uint32_t>(keys[idx]);
+     }
+}
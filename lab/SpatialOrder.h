@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Bounds.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Function to interleave low 10 bits of three coordinates into a 30 bit Morton code
+uint32_t MortonCode3(uint32_t x, uint32_t y, uint32_t z);
+
+// Function to fill order with box indices sorted by Morton code of their centers inside the bounds of all boxes,
+// boxes with equal codes keep their relative order
+void ComputeMortonOrder(const BoundsSoA& bounds, std::vector<uint32_t>& order);
+
+// Function to rearrange values so that values[i] becomes the old values[order[i]]
+template <typename T>
+void ApplyOrder(std::vector<T>& values, const std::vector<uint32_t>& order)
+{
+     std::vector<T> ordered;
+     ordered.reserve(order.size());
+     for (uint32_t idx : order)
+     {
+          ordered.push_back(std::move(values[idx]));
+     }
+     values.swap(ordered);
+}
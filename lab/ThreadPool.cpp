@@ -0,0 +1,157 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+     if (threadCount == 0)
+     {
+          threadCount = std::max(1u, std::thread::hardware_concurrency());
+     }
+
+     for (unsigned i = 0; i < threadCount; ++i)
+     {
+          queues.push_back(std::make_unique<Queue>());
+     }
+     for (unsigned i = 1; i < threadCount; ++i)
+     {
+          workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+     }
+}
+
+ThreadPool::~ThreadPool()
+{
+     {
+          std::lock_guard<std::mutex> lock(jobMutex);
+          stop = true;
+     }
+     jobStarted.notify_all();
+     for (auto& worker : workers)
+     {
+          worker.join();
+     }
+}
+
+void ThreadPool::ParallelFor(size_t itemCount, const Task& task)
+{
+     if (workers.empty() || itemCount <= 1)
+     {
+          for (size_t item = 0; item < itemCount; ++item)
+          {
+               task(item, 0);
+          }
+          return;
+     }
+
+     // Give every thread an equal contiguous range to start with.
+     size_t threadCount = queues.size();
+     for (size_t i = 0; i < threadCount; ++i)
+     {
+          std::lock_guard<std::mutex> lock(queues[i]->mutex);
+          queues[i]->begin = itemCount * i / threadCount;
+          queues[i]->end = itemCount * (i + 1) / threadCount;
+     }
+
+     {
+          std::lock_guard<std::mutex> lock(jobMutex);
+          job = &task;
+          busyWorkers = static_cast<unsigned>(workers.size());
+          ++jobGeneration;
+     }
+     jobStarted.notify_all();
+
+     RunItems(0);
+
+     std::unique_lock<std::mutex> lock(jobMutex);
+     jobFinished.wait(lock, [this]() { return busyWorkers == 0; });
+     job = nullptr;
+}
+
+void ThreadPool::WorkerLoop(unsigned thread)
+{
+     uint64_t seenGeneration = 0;
+     while (true)
+     {
+          {
+               std::unique_lock<std::mutex> lock(jobMutex);
+               jobStarted.wait(lock, [&]() { return stop || jobGeneration != seenGeneration; });
+               if (stop)
+               {
+                    return;
+               }
+               seenGeneration = jobGeneration;
+          }
+
+          RunItems(thread);
+
+          std::lock_guard<std::mutex> lock(jobMutex);
+          if (--busyWorkers == 0)
+          {
+               jobFinished.notify_one();
+          }
+     }
+}
+
+void ThreadPool::RunItems(unsigned thread)
+{
+     size_t item;
+     while (Pop(thread, item) || Steal(thread, item))
+     {
+          (*job)(item, thread);
+     }
+}
+
+bool ThreadPool::Pop(unsigned thread, size_t& item)
+{
+     Queue& queue = *queues[thread];
+     std::lock_guard<std::mutex> lock(queue.mutex);
+     if (queue.begin == queue.end)
+     {
+          return false;
+     }
+     item = queue.begin++;
+     return true;
+}
+
+bool ThreadPool::Steal(unsigned thread, size_t& item)
+{
+     // Items are never added during a loop, so once every range is empty the thread is done.
+     while (true)
+     {
+          unsigned victim = thread;
+          size_t victimSize = 0;
+          for (unsigned i = 0; i < queues.size(); ++i)
+          {
+               std::lock_guard<std::mutex> lock(queues[i]->mutex);
+               size_t size = queues[i]->end - queues[i]->begin;
+               if (i != thread && size > victimSize)
+               {
+                    victim = i;
+                    victimSize = size;
+               }
+          }
+          if (victimSize == 0)
+          {
+               return false;
+          }
+
+          size_t begin, end;
+          {
+               std::lock_guard<std::mutex> lock(queues[victim]->mutex);
+               size_t size = queues[victim]->end - queues[victim]->begin;
+               if (size == 0)
+               {
+                    continue;
+               }
+               end = queues[victim]->end;
+               begin = end - (size + 1) / 2;
+               queues[victim]->end = begin;
+          }
+
+          item = begin;
+          std::lock_guard<std::mutex> lock(queues[thread]->mutex);
+          queues[thread]->begin = begin + 1;
+          queues[thread]->end = end;
+          return true;
+     }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+// Pool of worker threads running parallel loops. Every thread owns a range of loop items,
+// threads that run out of items steal the upper half of the largest remaining range.
+class ThreadPool
+{
+public:
+     using Task = std::function<void(size_t item, unsigned thread)>;
+
+     // Function to start pool, 0 means one thread per hardware thread. The calling thread counts as one of them
+     explicit ThreadPool(unsigned threadCount = 0);
+     ~ThreadPool();
+
+     ThreadPool(const ThreadPool&) = delete;
+     ThreadPool& operator=(const ThreadPool&) = delete;
+
+     unsigned GetThreadCount() const { return static_cast<unsigned>(queues.size()); }
+
+     // Function to call task for every item in [0, itemCount) and wait for all of them, the caller runs as thread 0
+     void ParallelFor(size_t itemCount, const Task& task);
+private:
+     struct Queue
+     {
+          std::mutex mutex;
+          size_t begin = 0;
+          size_t end = 0;
+     };
+
+     void WorkerLoop(unsigned thread);
+     void RunItems(unsigned thread);
+     bool Pop(unsigned thread, size_t& item);
+     bool Steal(unsigned thread, size_t& item);
+
+     std::vector<std::unique_ptr<Queue>> queues;
+     std::vector<std::thread> workers;
+
+     std::mutex jobMutex;
+     std::condition_variable jobStarted;
+     std::condition_variable jobFinished;
+     const Task* job = nullptr;
+     uint64_t jobGeneration = 0;
+     unsigned busyWorkers = 0;
+     bool stop = false;
+};
@@ -0,0 +1,236 @@
+#include "Transforms.h"
+
+#include <DirectXPackedVector.h>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+void UpdateWorldBounds(TransformsSoA& transforms, const XMFLOAT3& localCenter, const XMFLOAT3& localExtent,
+     BoundsSoA& bounds, std::vector<uint32_t>& updated)
+{
+     const size_t count = transforms.Size();
+     bounds.Resize(count);
+
+     const XMVECTOR lcx = XMVectorReplicate(localCenter.x);
+     const XMVECTOR lcy = XMVectorReplicate(localCenter.y);
+     const XMVECTOR lcz = XMVectorReplicate(localCenter.z);
+     const XMVECTOR lex = XMVectorReplicate(localExtent.x);
+     const XMVECTOR ley = XMVectorReplicate(localExtent.y);
+     const XMVECTOR lez = XMVectorReplicate(localExtent.z);
+
+     float* centers[3] = { bounds.centerX.data(), bounds.centerY.data(), bounds.centerZ.data() };
+     float* extents[3] = { bounds.extentX.data(), bounds.extentY.data(), bounds.extentZ.data() };
+
+     size_t idx = 0;
+     for (; idx + 4 <= count; idx += 4)
+     {
+          // Whole groups of clean transforms are skipped, clean lanes of a dirty group are recomputed to the same value.
+          uint32_t flags;
+          memcpy(&flags, transforms.dirty.data() + idx, sizeof(flags));
+          if (!flags)
+          {
+               continue;
+          }
+
+          for (int c = 0; c < 3; c++)
+          {
+               XMVECTOR m0 = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(transforms.m[0][c].data() + idx));
+               XMVECTOR m1 = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(transforms.m[1][c].data() + idx));
+               XMVECTOR m2 = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(transforms.m[2][c].data() + idx));
+               XMVECTOR m3 = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(transforms.m[3][c].data() + idx));
+
+               XMVECTOR center = XMVectorMultiplyAdd(lcx, m0, m3);
+               center = XMVectorMultiplyAdd(lcy, m1, center);
+               center = XMVectorMultiplyAdd(lcz, m2, center);
+
+               XMVECTOR extent = XMVectorMultiply(lex, XMVectorAbs(m0));
+               extent = XMVectorMultiplyAdd(ley, XMVectorAbs(m1), extent);
+               extent = XMVectorMultiplyAdd(lez, XMVectorAbs(m2), extent);
+
+               XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(centers[c] + idx), center);
+               XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(extents[c] + idx), extent);
+          }
+
+          for (size_t lane = idx; lane < idx + 4; ++lane)
+          {
+               if (transforms.dirty[lane])
+               {
+                    transforms.dirty[lane] = 0;
+                    updated.push_back(static_cast<uint32_t>(lane));
+               }
+          }
+     }
+
+     for (; idx < count; ++idx)
+     {
+          if (!transforms.dirty[idx])
+          {
+               continue;
+          }
+
+          for (int c = 0; c < 3; c++)
+          {
+               centers[c][idx] = localCenter.x * transforms.m[0][c][idx] + localCenter.y * transforms.m[1][c][idx]
+                    + localCenter.z * transforms.m[2][c][idx] + transforms.m[3][c][idx];
+               extents[c][idx] = localExtent.x * fabsf(transforms.m[0][c][idx]) + localExtent.y * fabsf(transforms.m[1][c][idx])
+                    + localExtent.z * fabsf(transforms.m[2][c][idx]);
+          }
+          transforms.dirty[idx] = 0;
+          updated.push_back(static_cast<uint32_t>(idx));
+     }
+}
+
+// Function to pack four transforms given as m[r][c] lanes, count of them are written
+static void PackGroup(const XMVECTOR m[4][3], const uint16_t* materials, size_t count, PackedInstance* output)
+{
+     // Scale is the length of basis rows, a negative determinant flips the z row.
+     XMVECTOR scale[3];
+     XMVECTOR row[3][3];
+     for (int r = 0; r < 3; r++)
+     {
+          XMVECTOR lengthSq = XMVectorMultiply(m[r][0], m[r][0]);
+          lengthSq = XMVectorMultiplyAdd(m[r][1], m[r][1], lengthSq);
+          lengthSq = XMVectorMultiplyAdd(m[r][2], m[r][2], lengthSq);
+          scale[r] = XMVectorSqrt(lengthSq);
+          XMVECTOR invScale = XMVectorReciprocal(XMVectorMax(scale[r], XMVectorReplicate(1e-30f)));
+          for (int c = 0; c < 3; c++)
+          {
+               row[r][c] = XMVectorMultiply(m[r][c], invScale);
+          }
+     }
+     XMVECTOR det = XMVectorMultiply(row[2][0], XMVectorNegativeMultiplySubtract(row[0][2], row[1][1], XMVectorMultiply(row[0][1], row[1][2])));
+     det = XMVectorMultiplyAdd(row[2][1], XMVectorNegativeMultiplySubtract(row[0][0], row[1][2], XMVectorMultiply(row[0][2], row[1][0])), det);
+     det = XMVectorMultiplyAdd(row[2][2], XMVectorNegativeMultiplySubtract(row[0][1], row[1][0], XMVectorMultiply(row[0][0], row[1][1])), det);
+     XMVECTOR mirrored = XMVectorLess(det, XMVectorZero());
+     scale[2] = XMVectorSelect(scale[2], XMVectorNegate(scale[2]), mirrored);
+     for (int c = 0; c < 3; c++)
+     {
+          row[2][c] = XMVectorSelect(row[2][c], XMVectorNegate(row[2][c]), mirrored);
+     }
+
+     // Shepperd's method: the largest component comes from the diagonal, the others from
+     // off diagonal sums and differences divided by it, so it is positive and never small.
+     const XMVECTOR one = XMVectorReplicate(1.0f);
+     XMVECTOR diag[4] = {
+          XMVectorAdd(one, XMVectorSubtract(XMVectorSubtract(row[0][0], row[1][1]), row[2][2])),
+          XMVectorAdd(one, XMVectorSubtract(XMVectorSubtract(row[1][1], row[0][0]), row[2][2])),
+          XMVectorAdd(one, XMVectorSubtract(XMVectorSubtract(row[2][2], row[0][0]), row[1][1])),
+          XMVectorAdd(one, XMVectorAdd(XMVectorAdd(row[0][0], row[1][1]), row[2][2]))
+     };
+     XMVECTOR wx = XMVectorSubtract(row[1][2], row[2][1]);
+     XMVECTOR wy = XMVectorSubtract(row[2][0], row[0][2]);
+     XMVECTOR wz = XMVectorSubtract(row[0][1], row[1][0]);
+     XMVECTOR xy = XMVectorAdd(row[0][1], row[1][0]);
+     XMVECTOR xz = XMVectorAdd(row[0][2], row[2][0]);
+     XMVECTOR yz = XMVectorAdd(row[1][2], row[2][1]);
+
+     XMVECTOR isX = XMVectorAndInt(XMVectorGreaterOrEqual(diag[0], diag[1]),
+          XMVectorAndInt(XMVectorGreaterOrEqual(diag[0], diag[2]), XMVectorGreaterOrEqual(diag[0], diag[3])));
+     XMVECTOR isY = XMVectorAndCInt(XMVectorAndInt(XMVectorGreaterOrEqual(diag[1], diag[2]),
+          XMVectorGreaterOrEqual(diag[1], diag[3])), isX);
+     XMVECTOR isZ = XMVectorAndCInt(XMVectorAndCInt(XMVectorGreaterOrEqual(diag[2], diag[3]), isX), isY);
+     XMVECTOR isW = XMVectorAndCInt(XMVectorAndCInt(XMVectorAndCInt(XMVectorTrueInt(), isX), isY), isZ);
+
+     XMVECTOR largest = XMVectorSelect(XMVectorSelect(XMVectorSelect(diag[3], diag[2], isZ), diag[1], isY), diag[0], isX);
+     XMVECTOR invScale = XMVectorReciprocal(XMVectorScale(XMVectorSqrt(XMVectorMax(largest, XMVectorReplicate(1e-30f))), 2.0f));
+
+     // Remaining components in x, y, z, w order with the largest one left out.
+     XMVECTOR small[3] = {
+          XMVectorSelect(XMVectorSelect(xy, xz, isZ), wx, isW),
+          XMVectorSelect(XMVectorSelect(yz, xz, isX), wy, isW),
+          XMVectorSelect(XMVectorSelect(XMVectorSelect(wz, wy, isY), wx, isX), wz, isW)
+     };
+     // Position, scale and the quantized components go to one float array and are converted per lane, the
+     // quantized values are truncated there the way XMStoreUInt4 would.
+     float values[9][4];
+     const XMVECTOR range = XMVectorReplicate(0.70710678f);
+     for (int i = 0; i < 3; i++)
+     {
+          XMVECTOR value = XMVectorClamp(XMVectorMultiply(small[i], invScale), XMVectorNegate(range), range);
+          value = XMVectorMultiplyAdd(value, XMVectorReplicate(1023.0f * 0.5f / 0.70710678f), XMVectorReplicate(1023.0f * 0.5f + 0.5f));
+          XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(values[6 + i]), value);
+     }
+     uint32_t dropped[4];
+     XMVECTOR droppedIdx = XMVectorSelect(XMVectorSelect(XMVectorSelect(XMVectorReplicateInt(3), XMVectorReplicateInt(2), isZ),
+          XMVectorReplicateInt(1), isY), XMVectorReplicateInt(0), isX);
+     XMStoreInt4(dropped, droppedIdx);
+
+     for (int c = 0; c < 3; c++)
+     {
+          XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(values[c]), m[3][c]);
+          XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(values[3 + c]), scale[c]);
+     }
+     for (size_t lane = 0; lane < count; ++lane)
+     {
+          PackedInstance& packed = output[lane];
+          packed.position = XMFLOAT3(values[0][lane], values[1][lane], values[2][lane]);
+          packed.rotation = (dropped[lane] << 30) | (static_cast<uint32_t>(values[6][lane]) << 20)
+               | (static_cast<uint32_t>(values[7][lane]) << 10) | static_cast<uint32_t>(values[8][lane]);
+          packed.material = materials[lane];
+     }
+     for (int c = 0; c < 3; c++)
+     {
+          PackedVector::XMConvertFloatToHalfStream(&output[0].scale[c], sizeof(PackedInstance), values[3 + c], sizeof(float), count);
+     }
+}
+
+void PackTransforms(const TransformsSoA& transforms, const uint16_t* materials, size_t begin, size_t end,
+     PackedInstance* output)
+{
+     XMVECTOR m[4][3];
+     size_t idx = begin;
+     for (; idx + 4 <= end; idx += 4)
+     {
+          for (int r = 0; r < 4; r++)
+          {
+               for (int c = 0; c < 3; c++)
+               {
+                    m[r][c] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(transforms.m[r][c].data() + idx));
+               }
+          }
+          PackGroup(m, materials + idx, 4, output + (idx - begin));
+     }
+
+     if (idx < end)
+     {
+          // Unused lanes get identity transforms.
+          for (int r = 0; r < 4; r++)
+          {
+               for (int c = 0; c < 3; c++)
+               {
+                    float lanes[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                    for (size_t lane = 0; lane < 4; ++lane)
+                    {
+                         lanes[lane] = idx + lane < end ? transforms.m[r][c][idx + lane] : (r == c ? 1.0f : 0.0f);
+                    }
+                    m[r][c] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(lanes));
+               }
+          }
+          PackGroup(m, materials + idx, end - idx, output + (idx - begin));
+     }
+}
+
+XMMATRIX UnpackTransform(const PackedInstance& packed)
+{
+     float small[3];
+     for (int i = 0; i < 3; i++)
+     {
+          uint32_t value = (packed.rotation >> (20 - 10 * i)) & 1023;
+          small[i] = (value / 1023.0f * 2.0f - 1.0f) * 0.70710678f;
+     }
+     float largest = sqrtf(std::fmax(0.0f, 1.0f - small[0] * small[0] - small[1] * small[1] - small[2] * small[2]));
+
+     uint32_t dropped = packed.rotation >> 30;
+     float q[4];
+     for (uint32_t i = 0, j = 0; i < 4; i++)
+     {
+          q[i] = i == dropped ? largest : small[j++];
+     }
+
+     XMMATRIX scale = XMMatrixScaling(PackedVector::XMConvertHalfToFloat(packed.scale[0]),
+          PackedVector::XMConvertHalfToFloat(packed.scale[1]), PackedVector::XMConvertHalfToFloat(packed.scale[2]));
+     XMMATRIX rotation = XMMatrixRotationQuaternion(XMVectorSet(q[0], q[1], q[2], q[3]));
+     XMMATRIX translation = XMMatrixTranslation(packed.position.x, packed.position.y, packed.position.z);
+     return XMMatrixMultiply(XMMatrixMultiply(scale, rotation), translation);
+}
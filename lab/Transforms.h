@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Bounds.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+// Affine world transforms stored as structure of arrays. m[r][c] holds element (r, c) of every
+// matrix in row vector convention, row 3 is the translation. Changed transforms are flagged dirty.
+struct TransformsSoA
+{
+     std::vector<float> m[4][3];
+     std::vector<uint8_t> dirty;
+     // Incremented by every Set
+     uint64_t version = 0;
+
+     size_t Size() const { return dirty.size(); }
+
+     void Resize(size_t count)
+     {
+          for (auto& row : m)
+          {
+               for (auto& column : row)
+               {
+                    column.resize(count);
+               }
+          }
+          dirty.resize(count, 1);
+     }
+
+     void Set(size_t idx, DirectX::FXMMATRIX matrix)
+     {
+          DirectX::XMFLOAT4X3 value;
+          DirectX::XMStoreFloat4x3(&value, matrix);
+          for (int r = 0; r < 4; r++)
+          {
+               for (int c = 0; c < 3; c++)
+               {
+                    m[r][c][idx] = value.m[r][c];
+               }
+          }
+          dirty[idx] = 1;
+          ++version;
+     }
+
+     // Function to copy transform and its dirty flag between slots, version is not changed
+     void Copy(size_t from, size_t to)
+     {
+          for (auto& row : m)
+          {
+               for (auto& column : row)
+               {
+                    column[to] = column[from];
+               }
+          }
+          dirty[to] = dirty[from];
+     }
+
+     DirectX::XMMATRIX Get(size_t idx) const
+     {
+          DirectX::XMFLOAT4X3 value;
+          for (int r = 0; r < 4; r++)
+          {
+               for (int c = 0; c < 3; c++)
+               {
+                    value.m[r][c] = m[r][c][idx];
+               }
+          }
+          return DirectX::XMLoadFloat4x3(&value);
+     }
+};
+
+// Function to recompute world bounds of dirty transforms from a local center/extent box.
+// Extents use the absolute rotation-scale part, so rotated and scaled boxes stay conservative.
+// Dirty flags are cleared and indices of updated bounds are appended to updated
+void UpdateWorldBounds(TransformsSoA& transforms, const DirectX::XMFLOAT3& localCenter, const DirectX::XMFLOAT3& localExtent,
+     BoundsSoA& bounds, std::vector<uint32_t>& updated);
+
+// Compact instance transform, matches Instance in the instance shaders. Rotation holds the three smallest
+// quaternion components with 10 bits each and the index of the dropped one in the top 2 bits, the dropped
+// component is positive. Scale is stored as half floats
+struct PackedInstance
+{
+     DirectX::XMFLOAT3 position;
+     uint32_t rotation;
+     uint16_t scale[3];
+     uint16_t material;
+};
+
+// Function to pack transforms of [begin, end) with their materials to output[0, end - begin).
+// Transforms must not have shear, a mirroring transform is kept as a negative z scale
+void PackTransforms(const TransformsSoA& transforms, const uint16_t* materials, size_t begin, size_t end,
+     PackedInstance* output);
+// Function to rebuild world matrix of a packed instance the same way the vertex shader does
+DirectX::XMMATRIX UnpackTransform(const PackedInstance& packed);
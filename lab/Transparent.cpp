@@ -5,13 +5,15 @@
 #include <d3dcompiler.h>
 #include <dxgi.h>
 
+#include <algorithm>
+
 struct TransparentWorldBuffer
 {
      DirectX::XMMATRIX worldMatrix;
      DirectX::XMFLOAT4 color;
 };
 
-bool Transparent::Init(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext, int width, int height)
+bool Transparent::Init(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext, int width, int height, EntityStore& entities)
 {
      this->pDevice = pDevice;
      this->pDeviceContext = pDeviceContext;
@@ -39,15 +41,41 @@ bool Transparent::Init(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContex
      if (!SUCCEEDED(result))
           return false;
      
-     result = CreateWorldBuffers();
+     result = CreateWorldBuffer();
      if (!SUCCEEDED(result))
           return false;
 
+     CreateEntities(entities);
      return true;
 }
 
-void Transparent::Render()
+void Transparent::Render(const EntityStore& entities, const Frustum& frustum, const DirectX::XMFLOAT3& cameraPos)
 {
+     const uint32_t mask = TransformComponent::bit | BoundsComponent::bit | MeshComponent::bit | TransparencyComponent::bit;
+     drawItems.clear();
+     entities.ForEachChunk(mask, [&](const EntityChunk& chunk)
+          {
+               const TransformComponent* transforms = chunk.Get<TransformComponent>();
+               const BoundsComponent* bounds = chunk.Get<BoundsComponent>();
+               const MeshComponent* meshes = chunk.Get<MeshComponent>();
+               const TransparencyComponent* transparencies = chunk.Get<TransparencyComponent>();
+               for (size_t idx = 0; idx < chunk.count; ++idx)
+               {
+                    if (frustum.CheckAABB(bounds[idx].center, bounds[idx].extent) == FrustumTest::Outside)
+                    {
+                         continue;
+                    }
+                    float dx = bounds[idx].center.x - cameraPos.x;
+                    float dy = bounds[idx].center.y - cameraPos.y;
+                    float dz = bounds[idx].center.z - cameraPos.z;
+                    drawItems.push_back({ dx * dx + dy * dy + dz * dz, transforms + idx, meshes + idx, transparencies + idx });
+               }
+          });
+     std::sort(drawItems.begin(), drawItems.end(), [](const DrawItem& a, const DrawItem& b)
+          {
+               return a.distanceSq > b.distanceSq;
+          });
+
      pDeviceContext->IASetIndexBuffer(pIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
      ID3D11Buffer* vertexBuffers[] = { pVertexBuffer };
      UINT stride = sizeof(DirectX::XMFLOAT3);
@@ -67,11 +95,20 @@ void Transparent::Render()
 
      pDeviceContext->VSSetConstantBuffers(0, 1, &pWorldBuffer);
      pDeviceContext->PSSetConstantBuffers(0, 1, &pWorldBuffer);
-     pDeviceContext->DrawIndexed(6, 0, 0);
-
-     pDeviceContext->VSSetConstantBuffers(0, 1, &pWorldBuffer2);
-     pDeviceContext->PSSetConstantBuffers(0, 1, &pWorldBuffer2);
-     pDeviceContext->DrawIndexed(6, 0, 0);
+     for (const DrawItem& item : drawItems)
+     {
+          D3D11_MAPPED_SUBRESOURCE subresource;
+          if (FAILED(pDeviceContext->Map(pWorldBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subresource)))
+          {
+               return;
+          }
+          TransparentWorldBuffer& worldBuffer = *reinterpret_cast<TransparentWorldBuffer*>(subresource.pData);
+          worldBuffer.worldMatrix = DirectX::XMLoadFloat4x3(&item.transform->world);
+          worldBuffer.color = item.transparency->color;
+          pDeviceContext->Unmap(pWorldBuffer, 0);
+
+          pDeviceContext->DrawIndexed(item.mesh->indexCount, item.mesh->startIndex, 0);
+     }
 }
 
 void Transparent::Cleanup()
@@ -85,7 +122,6 @@ void Transparent::Cleanup()
      SAFE_RELEASE(pDepthState);
      SAFE_RELEASE(pBlendState);
      SAFE_RELEASE(pWorldBuffer);
-     SAFE_RELEASE(pWorldBuffer2);
 }
 
 Transparent::~Transparent()
@@ -211,31 +247,31 @@ HRESULT Transparent::CreateDepthState()
      return pDevice->CreateDepthStencilState(&desc, &pDepthState);
 }
 
-HRESULT Transparent::CreateWorldBuffers()
+HRESULT Transparent::CreateWorldBuffer()
 {
      D3D11_BUFFER_DESC desc = {};
      desc.ByteWidth = sizeof(TransparentWorldBuffer);
-     desc.Usage = D3D11_USAGE_DEFAULT;
+     desc.Usage = D3D11_USAGE_DYNAMIC;
      desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-     desc.CPUAccessFlags = 0;
+     desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
      desc.MiscFlags = 0;
      desc.StructureByteStride = 0;
 
+     return pDevice->CreateBuffer(&desc, NULL, &pWorldBuffer);
+}
 
-
-     if (SUCCEEDED(pDevice->CreateBuffer(&desc, NULL, &pWorldBuffer))
-          && SUCCEEDED(pDevice->CreateBuffer(&desc, NULL, &pWorldBuffer2)))
+// Function to create the two colored quads
+void Transparent::CreateEntities(EntityStore& entities)
+{
+     const uint32_t mask = TransformComponent::bit | BoundsComponent::bit | MeshComponent::bit | TransparencyComponent::bit;
+     const float depths[2] = { -0.1f, 0.1f };
+     const DirectX::XMFLOAT4 colors[2] = { { 1.0f, 1.0f, 0.0f, 0.5f }, { 0.0f, 1.0f, 1.0f, 0.5f } };
+     for (int i = 0; i < 2; i++)
      {
-          TransparentWorldBuffer transparentWorldBuffer;
-          transparentWorldBuffer.worldMatrix = DirectX::XMMatrixTranslation(0.0f, 0.0f, -0.1f);
-          transparentWorldBuffer.color = DirectX::XMFLOAT4(1.0f, 1.0f, 0.0f, 0.5f);
-          pDeviceContext->UpdateSubresource(pWorldBuffer, 0, NULL, &transparentWorldBuffer, 0, 0);
-
-          transparentWorldBuffer.worldMatrix = DirectX::XMMatrixTranslation(0.0f, 0.0f, 0.1f);
-          transparentWorldBuffer.color = DirectX::XMFLOAT4(0.0f, 1.0f, 1.0f, 0.5f);
-          pDeviceContext->UpdateSubresource(pWorldBuffer2, 0, NULL, &transparentWorldBuffer, 0, 0);
-          return S_OK;
+          Entity entity = entities.Create(mask);
+          DirectX::XMStoreFloat4x3(&entities.Get<TransformComponent>(entity)->world, DirectX::XMMatrixTranslation(0.0f, 0.0f, depths[i]));
+          *entities.Get<BoundsComponent>(entity) = { DirectX::XMFLOAT3(0.0f, 0.0f, depths[i]), DirectX::XMFLOAT3(1.0f, 1.0f, 0.0f) };
+          *entities.Get<MeshComponent>(entity) = { 0, 6 };
+          entities.Get<TransparencyComponent>(entity)->color = colors[i];
      }
-
-     return S_FALSE;
 }
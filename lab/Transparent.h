@@ -1,13 +1,19 @@
 #pragma once
 
+#include "EntityStore.h"
+#include "Frustum.h"
+
 #include <d3d11.h>
 #include <directxmath.h>
+#include <vector>
 
 class Transparent
 {
 public:
-     bool Init(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext, int width, int height);
-     void Render();
+     // Function to init resources and create transparent entities
+     bool Init(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext, int width, int height, EntityStore& entities);
+     // Function to draw transparent entities in frustum back to front
+     void Render(const EntityStore& entities, const Frustum& frustum, const DirectX::XMFLOAT3& cameraPos);
      void Cleanup();
      ~Transparent();
 private:
@@ -15,6 +21,14 @@ private:
           float x, y, z;
      };
 
+     struct DrawItem
+     {
+          float distanceSq;
+          const TransformComponent* transform;
+          const MeshComponent* mesh;
+          const TransparencyComponent* transparency;
+     };
+
      const Vertex vertices[4] =
      {
           {-1.0, -1.0, 0},
@@ -33,7 +47,8 @@ private:
      HRESULT CreateRasterizerState();
      HRESULT CreateBlendState();
      HRESULT CreateDepthState();
-     HRESULT CreateWorldBuffers();
+     HRESULT CreateWorldBuffer();
+     void CreateEntities(EntityStore& entities);
 
      ID3D11Device* pDevice = nullptr;
      ID3D11DeviceContext* pDeviceContext = nullptr;
@@ -50,7 +65,8 @@ private:
      ID3D11DepthStencilState* pDepthState = nullptr;
      ID3D11BlendState* pBlendState = nullptr;
 
-     ID3D11Buffer* pWorldBuffer;
-     ID3D11Buffer* pWorldBuffer2;
+     ID3D11Buffer* pWorldBuffer = nullptr;
+
+     std::vector<DrawItem> drawItems;
 };
 
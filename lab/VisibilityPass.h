@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+// Chunked parallel selection of instance ids. Every chunk writes to its own output array,
+// the arrays are then concatenated in chunk order, so the result does not depend on scheduling.
+class VisibilityPass
+{
+public:
+     static constexpr size_t chunkSize = 4096;
+
+     // Function to call select(begin, end, output) for chunks of [0, count) and gather outputs into result
+     template <typename Select>
+     void Gather(ThreadPool& pool, size_t count, Select&& select, std::vector<uint32_t>& result)
+     {
+          size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+          if (chunkOutputs.size() < chunkCount)
+          {
+               chunkOutputs.resize(chunkCount);
+          }
+
+          pool.ParallelFor(chunkCount, [&](size_t chunk, unsigned)
+               {
+                    std::vector<uint32_t>& output = chunkOutputs[chunk];
+                    output.clear();
+                    size_t begin = chunk * chunkSize;
+                    size_t end = begin + chunkSize < count ? begin + chunkSize : count;
+                    select(begin, end, output);
+               });
+
+          chunkOffsets.resize(chunkCount + 1);
+          chunkOffsets[0] = 0;
+          for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+          {
+               chunkOffsets[chunk + 1] = chunkOffsets[chunk] + chunkOutputs[chunk].size();
+          }
+
+          // Chunks copy into disjoint ranges of the result, no synchronization is needed.
+          result.resize(chunkOffsets[chunkCount]);
+          pool.ParallelFor(chunkCount, [&](size_t chunk, unsigned)
+               {
+                    const std::vector<uint32_t>& output = chunkOutputs[chunk];
+                    std::copy(output.begin(), output.end(), result.begin() + chunkOffsets[chunk]);
+               });
+     }
+private:
+     std::vector<std::vector<uint32_t>> chunkOutputs;
+     std::vector<size_t> chunkOffsets;
+};
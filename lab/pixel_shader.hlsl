@@ -5,17 +5,28 @@ Texture2D cubeNormalTexture : register (t1);
 SamplerState cubeSampler : register(s0);
 SamplerState cubeNormalSampler : register (s1);
 
-struct WorldBuffer
+// Packed instance transform, see PackedInstance in Transforms.h
+struct Instance
 {
-     float4x4 world;
-     float4 shine;
+     float3 position;
+     uint rotation;
+     uint2 scaleMaterial;
 };
 
-cbuffer WorldBufferInst : register (b0)
+StructuredBuffer<Instance> instances : register (t2);
+// Unique materials, see Material in MaterialRegistry.h
+struct Material
 {
-     WorldBuffer worldBuffer[20];
+     float specularPower;
+     uint textureSlice;
+     uint flags;
+     uint padding;
 };
 
+static const uint materialUnlit = 1;
+
+StructuredBuffer<Material> materials : register (t3);
+
 struct VSOutput
 {
      float4 position : SV_Position;
@@ -29,9 +40,10 @@ struct VSOutput
 float4 main(VSOutput input) : SV_Target0
 {
      unsigned int idx = input.instanceId;
-     float3 color = cubeTexture.Sample(cubeSampler, float3(input.texCoord, worldBuffer[idx].shine.z)).xyz;
+     Material material = materials[instances[idx].scaleMaterial.y >> 16];
+     float3 color = cubeTexture.Sample(cubeSampler, float3(input.texCoord, material.textureSlice)).xyz;
      float3 finalColor = ambientColor.xyz * color;
-     if (idx % 2 == 1)
+     if (material.flags & materialUnlit)
      {
           return float4(finalColor, 1.0);
      }
@@ -48,5 +60,5 @@ float4 main(VSOutput input) : SV_Target0
           norm = input.normal;
      }
 
-     return float4(CalculateColor(color, norm, input.worldPos.xyz, worldBuffer[idx].shine.x, false), 1.0);
+     return float4(CalculateColor(color, norm, input.worldPos.xyz, material.specularPower, false), 1.0);
 }
\ No newline at end of file
@@ -1,19 +1,19 @@
 #include "scene_buffer.hlsli"
 
-struct WorldBuffer
+// Packed instance transform, see PackedInstance in Transforms.h
+struct Instance
 {
-     float4x4 world;
-     float4 shine;
+     float3 position;
+     uint rotation;
+     uint2 scaleMaterial;
 };
 
-cbuffer WorldBufferInst : register (b0)
-{
-     WorldBuffer worldBuffer[20];
-};
+StructuredBuffer<Instance> instances : register (t2);
 
+// Visible instance ids of the current draw packed four per element
 cbuffer WorldBufferInstVis : register (b2)
 {
-     uint4 ids[100];
+     uint4 ids[4096];
 }
 
 struct VSInput
@@ -35,17 +35,48 @@ struct VSOutput
      nointerpolation uint instanceId : INST_ID;
 };
 
+// Function to rebuild quaternion from the three smallest components, the dropped one is positive
+float4 DecodeRotation(uint rotation)
+{
+     float3 small = (float3(uint3(rotation >> 20, rotation >> 10, rotation) & 1023) / 1023.0 * 2.0 - 1.0) * 0.70710678;
+     float largest = sqrt(max(0.0, 1.0 - dot(small, small)));
+     uint dropped = rotation >> 30;
+     if (dropped == 0)
+     {
+          return float4(largest, small);
+     }
+     if (dropped == 1)
+     {
+          return float4(small.x, largest, small.yz);
+     }
+     if (dropped == 2)
+     {
+          return float4(small.xy, largest, small.z);
+     }
+     return float4(small, largest);
+}
+
+float3 Rotate(float4 q, float3 v)
+{
+     return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
 VSOutput main(VSInput input)
 {
      VSOutput output;
 
-     unsigned int idx = ids[input.instanceId].x;
+     unsigned int idx = ids[input.instanceId / 4][input.instanceId % 4];
+
+     Instance instance = instances[idx];
+     float4 rotation = DecodeRotation(instance.rotation);
+     float3 scale = f16tof32(uint3(instance.scaleMaterial.x, instance.scaleMaterial.x >> 16, instance.scaleMaterial.y));
 
-     output.worldPos = mul(worldBuffer[idx].world, float4(input.position, 1.0f));
+     output.worldPos = float4(Rotate(rotation, input.position * scale) + instance.position, 1.0f);
      output.position = mul(viewProj, output.worldPos);
      output.texCoord = input.texCoord;
-     output.normal = mul(worldBuffer[idx].world, float4(input.normal, 1.0f)).xyz;
-     output.tangent = mul(worldBuffer[idx].world, float4(input.tangent, 1.0f)).xyz;
+     // Normals use the cofactor of the scale, so non uniform scale keeps them perpendicular.
+     output.normal = normalize(Rotate(rotation, input.normal * scale.yzx * scale.zxy));
+     output.tangent = Rotate(rotation, input.tangent * scale);
      output.instanceId = idx; 
 
      return output;
@@ -0,0 +1,90 @@
+#include "BVH.h"
+#include "TestCheck.h"
+#include "TestFrustum.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+     // Culling through the hierarchy has to give the per box answer, both for single threaded and parallel builds
+     void TestCullMatchesBoxes()
+     {
+          const size_t count = 30000;
+          std::mt19937 rng(3);
+          std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+          std::uniform_real_distribution<float> size(0.05f, 2.0f);
+          BoundsSoA bounds;
+          bounds.Resize(count);
+          for (size_t i = 0; i < count; ++i)
+          {
+               bounds.Set(i, XMFLOAT3(coordinate(rng), coordinate(rng), coordinate(rng)), XMFLOAT3(size(rng), size(rng), size(rng)));
+          }
+          // Every third box is left out, results must be ids of the boxes given to Build.
+          std::vector<uint32_t> ids;
+          for (uint32_t i = 0; i < count; i += 3)
+          {
+               ids.push_back(i);
+          }
+
+          for (unsigned threads : { 1u, 4u })
+          {
+               BVH bvh;
+               bvh.Build(bounds, ids.data(), ids.size(), threads);
+               CHECK(bvh.GetNodeCount() > 0);
+               for (int frame = 0; frame < 20; frame++)
+               {
+                    Frustum frustum = RandomFrustum(rng);
+                    std::vector<uint32_t> visible;
+                    bvh.Cull(frustum, visible);
+                    std::sort(visible.begin(), visible.end());
+                    CHECK(std::adjacent_find(visible.begin(), visible.end()) == visible.end());
+                    for (uint32_t id : ids)
+                    {
+                         XMFLOAT3 center(bounds.centerX[id], bounds.centerY[id], bounds.centerZ[id]);
+                         XMFLOAT3 extent(bounds.extentX[id], bounds.extentY[id], bounds.extentZ[id]);
+                         if (OnFrustumBoundary(frustum, center, extent))
+                         {
+                              continue;
+                         }
+                         bool expected = frustum.CheckAABB(center, extent) != FrustumTest::Outside;
+                         CHECK(std::binary_search(visible.begin(), visible.end(), id) == expected);
+                    }
+                    for (uint32_t id : visible)
+                    {
+                         CHECK(id % 3 == 0);
+                    }
+               }
+          }
+     }
+
+     // Empty and cleared hierarchies return nothing
+     void TestEmpty()
+     {
+          BoundsSoA bounds;
+          BVH bvh;
+          bvh.Build(bounds, nullptr, 0);
+          std::mt19937 rng(4);
+          std::vector<uint32_t> visible;
+          bvh.Cull(RandomFrustum(rng), visible);
+          CHECK(visible.empty());
+
+          bounds.Resize(1);
+          bounds.Set(0, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(100.0f, 100.0f, 100.0f));
+          uint32_t id = 0;
+          bvh.Build(bounds, &id, 1);
+          bvh.Cull(RandomFrustum(rng), visible);
+          CHECK(visible.size() == 1);
+          bvh.Clear();
+          visible.clear();
+          bvh.Cull(RandomFrustum(rng), visible);
+          CHECK(visible.empty());
+     }
+}
+
+int main()
+{
+     TestCullMatchesBoxes();
+     TestEmpty();
+     return TestResult("BVHTests");
+}
@@ -0,0 +1,127 @@
+#include "DynamicAABBTree.h"
+#include "TestCheck.h"
+#include "TestFrustum.h"
+
+#include <vector>
+
+namespace
+{
+     void RandomBox(std::mt19937& rng, BoundsSoA& bounds, size_t idx)
+     {
+          std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+          std::uniform_real_distribution<float> size(0.05f, 2.0f);
+          bounds.Set(idx, XMFLOAT3(coordinate(rng), coordinate(rng), coordinate(rng)), XMFLOAT3(size(rng), size(rng), size(rng)));
+     }
+
+     XMFLOAT3 Center(const BoundsSoA& bounds, size_t idx)
+     {
+          return XMFLOAT3(bounds.centerX[idx], bounds.centerY[idx], bounds.centerZ[idx]);
+     }
+
+     XMFLOAT3 Extent(const BoundsSoA& bounds, size_t idx)
+     {
+          return XMFLOAT3(bounds.extentX[idx], bounds.extentY[idx], bounds.extentZ[idx]);
+     }
+
+     // Tree query has to give the per instance answer for tight boxes, even with fat boxes much larger than them
+     void TestQueryMatchesTightBoxes()
+     {
+          const size_t count = 20000;
+          std::mt19937 rng(5);
+          ThreadPool pool(4);
+          DynamicAABBTree tree(1.5f);
+          BoundsSoA bounds;
+          bounds.Resize(count);
+          std::vector<int32_t> proxies(count);
+          for (size_t i = 0; i < count; ++i)
+          {
+               RandomBox(rng, bounds, i);
+               proxies[i] = tree.CreateProxy(Center(bounds, i), Extent(bounds, i), static_cast<uint32_t>(i));
+          }
+
+          std::vector<uint8_t> visible(count);
+          size_t fatOnly = 0;
+          for (int frame = 0; frame < 30; frame++)
+          {
+               // Small moves stay inside the fat boxes, large ones reinsert leaves.
+               std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+               std::uniform_int_distribution<size_t> pick(0, count - 1);
+               for (int move = 0; move < 2000; move++)
+               {
+                    size_t idx = pick(rng);
+                    if (move % 4 == 0)
+                    {
+                         RandomBox(rng, bounds, idx);
+                    }
+                    else
+                    {
+                         bounds.centerX[idx] += step(rng);
+                         bounds.centerY[idx] += step(rng);
+                    }
+                    tree.MoveProxy(proxies[idx], Center(bounds, idx), Extent(bounds, idx));
+               }
+
+               Frustum frustum = RandomFrustum(rng);
+               std::fill(visible.begin(), visible.end(), 0);
+               tree.Query(pool, frustum, bounds, visible.data());
+               for (size_t i = 0; i < count; ++i)
+               {
+                    XMFLOAT3 center = Center(bounds, i);
+                    XMFLOAT3 extent = Extent(bounds, i);
+                    if (OnFrustumBoundary(frustum, center, extent))
+                    {
+                         continue;
+                    }
+                    bool expected = frustum.CheckAABB(center, extent) != FrustumTest::Outside;
+                    CHECK(visible[i] == (expected ? 1 : 0));
+
+                    XMFLOAT3 fatExtent(extent.x + 1.5f, extent.y + 1.5f, extent.z + 1.5f);
+                    if (!expected && frustum.CheckAABB(center, fatExtent) != FrustumTest::Outside)
+                    {
+                         ++fatOnly;
+                    }
+               }
+          }
+          CHECK(tree.GetProxyCount() == count);
+          // Boxes visible only through their fat margin exist, so the test tells tight from fat culling.
+          CHECK(fatOnly > 0);
+     }
+
+     void TestDestroyedProxiesAreNotReported()
+     {
+          const size_t count = 1000;
+          std::mt19937 rng(6);
+          ThreadPool pool(2);
+          DynamicAABBTree tree;
+          BoundsSoA bounds;
+          bounds.Resize(count);
+          std::vector<int32_t> proxies(count);
+          for (size_t i = 0; i < count; ++i)
+          {
+               bounds.Set(i, XMFLOAT3(0.0f, 0.0f, 5.0f + 0.01f * i), XMFLOAT3(0.1f, 0.1f, 0.1f));
+               proxies[i] = tree.CreateProxy(Center(bounds, i), Extent(bounds, i), static_cast<uint32_t>(i));
+          }
+          for (size_t i = 0; i < count; i += 2)
+          {
+               tree.DestroyProxy(proxies[i]);
+          }
+
+          XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+          Frustum frustum;
+          frustum.Init(0.1f);
+          frustum.ConstructFrustum(view, XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f));
+          std::vector<uint8_t> visible(count);
+          tree.Query(pool, frustum, bounds, visible.data());
+          for (size_t i = 0; i < count; ++i)
+          {
+               CHECK(visible[i] == (i % 2 ? 1 : 0));
+          }
+     }
+}
+
+int main()
+{
+     TestQueryMatchesTightBoxes();
+     TestDestroyedProxiesAreNotReported();
+     return TestResult("DynamicAABBTreeTests");
+}
@@ -0,0 +1,145 @@
+#include "EntityStore.h"
+#include "TestCheck.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+     const uint32_t opaqueMask = TransformComponent::bit | BoundsComponent::bit | MeshComponent::bit | MaterialComponent::bit;
+     const uint32_t transparentMask = opaqueMask | TransparencyComponent::bit;
+
+     // Handles of destroyed entities stop resolving, also after their record is reused
+     void TestCreateDestroy()
+     {
+          EntityStore store;
+          Entity a = store.Create(opaqueMask);
+          Entity b = store.Create(opaqueMask);
+          CHECK(store.Size() == 2);
+          CHECK(store.IsValid(a) && store.IsValid(b));
+          CHECK(store.GetMask(a) == opaqueMask);
+          CHECK(store.Get<TransparencyComponent>(a) == nullptr);
+          CHECK(store.Get<MaterialComponent>(a)->material == 0);
+
+          store.Get<MaterialComponent>(b)->material = 7;
+          CHECK(store.Destroy(a));
+          CHECK(!store.Destroy(a));
+          CHECK(!store.IsValid(a));
+          CHECK(store.Get<MaterialComponent>(a) == nullptr);
+          CHECK(store.Get<MaterialComponent>(b)->material == 7);
+
+          Entity c = store.Create(transparentMask);
+          CHECK(c.index == a.index && c.generation != a.generation);
+          CHECK(!store.IsValid(a) && store.IsValid(c));
+          CHECK(store.Size() == 2);
+
+          store.Clear();
+          CHECK(store.Size() == 0);
+          CHECK(!store.IsValid(b) && !store.IsValid(c));
+          CHECK(store.Get<MaterialComponent>(b) == nullptr);
+          Entity d = store.Create(opaqueMask);
+          CHECK(store.IsValid(d) && store.Size() == 1);
+     }
+
+     // Chunks of an archetype stay packed through random destroys, iteration visits every live entity once
+     void TestChunkIteration()
+     {
+          std::mt19937 rng(21);
+          EntityStore store;
+          std::vector<Entity> live;
+          for (uint32_t i = 0; i < 5000; i++)
+          {
+               Entity entity = store.Create(i % 4 ? opaqueMask : transparentMask);
+               store.Get<MaterialComponent>(entity)->material = static_cast<uint16_t>(i);
+               live.push_back(entity);
+          }
+          for (int i = 0; i < 2000; i++)
+          {
+               size_t pick = std::uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+               CHECK(store.Destroy(live[pick]));
+               live[pick] = live.back();
+               live.pop_back();
+          }
+
+          std::vector<int> seen(5000, 0);
+          size_t chunks = 0;
+          size_t empty = 0;
+          store.ForEachChunk(opaqueMask, [&](const EntityChunk& chunk)
+               {
+                    ++chunks;
+                    empty += chunk.count == 0;
+                    const MaterialComponent* materials = chunk.Get<MaterialComponent>();
+                    for (size_t row = 0; row < chunk.count; ++row)
+                    {
+                         ++seen[materials[row].material];
+                    }
+               });
+          CHECK(chunks > 2);
+          CHECK(empty == 0);
+          size_t total = 0;
+          for (const Entity& entity : live)
+          {
+               uint16_t material = store.Get<MaterialComponent>(entity)->material;
+               CHECK(seen[material] == 1);
+               total += seen[material];
+          }
+          CHECK(total == live.size() && total == store.Size());
+
+          // Only archetypes with every component of the mask are visited.
+          size_t transparent = 0;
+          store.ForEachChunk(transparentMask, [&](const EntityChunk& chunk)
+               {
+                    CHECK(chunk.Get<TransparencyComponent>() != nullptr);
+                    transparent += chunk.count;
+               });
+          size_t expected = 0;
+          for (const Entity& entity : live)
+          {
+               expected += store.GetMask(entity) == transparentMask;
+          }
+          CHECK(transparent == expected);
+     }
+
+     // Moving to another archetype keeps shared components, new ones start zeroed and the old row is refilled
+     void TestArchetypeMoves()
+     {
+          EntityStore store;
+          Entity first = store.Create(opaqueMask);
+          Entity moved = store.Create(opaqueMask);
+          Entity last = store.Create(opaqueMask);
+          store.Get<MaterialComponent>(first)->material = 1;
+          store.Get<MaterialComponent>(moved)->material = 2;
+          store.Get<MaterialComponent>(last)->material = 3;
+          store.Get<BoundsComponent>(moved)->center = DirectX::XMFLOAT3(1.0f, 2.0f, 3.0f);
+
+          CHECK(store.SetComponents(moved, transparentMask));
+          CHECK(store.GetMask(moved) == transparentMask);
+          CHECK(store.Get<MaterialComponent>(moved)->material == 2);
+          CHECK(store.Get<BoundsComponent>(moved)->center.z == 3.0f);
+          CHECK(store.Get<TransparencyComponent>(moved)->color.w == 0.0f);
+          CHECK(store.Get<MaterialComponent>(first)->material == 1);
+          CHECK(store.Get<MaterialComponent>(last)->material == 3);
+
+          store.Get<TransparencyComponent>(moved)->color = DirectX::XMFLOAT4(1.0f, 0.0f, 0.0f, 0.5f);
+          CHECK(store.SetComponents(moved, MaterialComponent::bit));
+          CHECK(store.Get<BoundsComponent>(moved) == nullptr);
+          CHECK(store.Get<TransparencyComponent>(moved) == nullptr);
+          CHECK(store.Get<MaterialComponent>(moved)->material == 2);
+          CHECK(store.SetComponents(moved, MaterialComponent::bit));
+
+          size_t opaque = 0;
+          store.ForEachChunk(opaqueMask, [&](const EntityChunk& chunk) { opaque += chunk.count; });
+          CHECK(opaque == 2);
+          CHECK(store.Destroy(moved));
+          CHECK(!store.SetComponents(moved, opaqueMask));
+          CHECK(store.Size() == 2);
+     }
+}
+
+int main()
+{
+     TestCreateDestroy();
+     TestChunkIteration();
+     TestArchetypeMoves();
+     return TestResult("EntityStoreTests");
+}
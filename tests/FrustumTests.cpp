@@ -0,0 +1,179 @@
+#include "Frustum.h"
+#include "TestCheck.h"
+#include "TestFrustum.h"
+
+#include <vector>
+
+namespace
+{
+     bool AllCornersInside(const Frustum& frustum, const XMFLOAT3& center, const XMFLOAT3& extent)
+     {
+          for (int i = 0; i < 6; i++)
+          {
+               XMFLOAT4 plane = frustum.GetPlane(i);
+               for (int corner = 0; corner < 8; corner++)
+               {
+                    float x = center.x + ((corner & 1) ? extent.x : -extent.x);
+                    float y = center.y + ((corner & 2) ? extent.y : -extent.y);
+                    float z = center.z + ((corner & 4) ? extent.z : -extent.z);
+                    if (plane.x * x + plane.y * y + plane.z * z + plane.w < -1e-4f)
+                    {
+                         return false;
+                    }
+               }
+          }
+          return true;
+     }
+
+     // Tri-state test has to agree with the corner test it replaced on every box that is not on a plane
+     void TestMatchesCornerTest()
+     {
+          std::mt19937 rng(2);
+          std::uniform_real_distribution<float> coordinate(-60.0f, 60.0f);
+          std::uniform_real_distribution<float> size(0.01f, 5.0f);
+          size_t compared = 0;
+          size_t inside = 0;
+          for (int view = 0; view < 50; view++)
+          {
+               Frustum frustum = RandomFrustum(rng);
+               for (int box = 0; box < 20000; box++)
+               {
+                    XMFLOAT3 center(coordinate(rng), coordinate(rng), coordinate(rng));
+                    XMFLOAT3 extent(size(rng), size(rng), size(rng));
+                    FrustumTest result = frustum.CheckAABB(center, extent);
+                    if (result == FrustumTest::Inside)
+                    {
+                         CHECK(AllCornersInside(frustum, center, extent));
+                         ++inside;
+                    }
+                    if (OnFrustumBoundary(frustum, center, extent))
+                    {
+                         continue;
+                    }
+                    bool corners = frustum.CheckRectangle(center.x + extent.x, center.y + extent.y, center.z + extent.z,
+                         center.x - extent.x, center.y - extent.y, center.z - extent.z);
+                    CHECK(corners == (result != FrustumTest::Outside));
+                    ++compared;
+               }
+          }
+          CHECK(compared > 900000);
+          CHECK(inside > 0);
+     }
+
+     // Children tested with the plane mask left by their parent get the same answer as with all planes
+     void TestPlaneMaskInheritance()
+     {
+          std::mt19937 rng(3);
+          std::uniform_real_distribution<float> coordinate(-40.0f, 40.0f);
+          std::uniform_real_distribution<float> size(0.5f, 10.0f);
+          std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+          for (int view = 0; view < 20; view++)
+          {
+               Frustum frustum = RandomFrustum(rng);
+               for (int box = 0; box < 5000; box++)
+               {
+                    XMFLOAT3 center(coordinate(rng), coordinate(rng), coordinate(rng));
+                    XMFLOAT3 extent(size(rng), size(rng), size(rng));
+                    uint32_t planeMask = Frustum::allPlanesMask;
+                    FrustumTest parent = frustum.CheckAABB(center, extent, planeMask);
+                    if (parent == FrustumTest::Outside)
+                    {
+                         continue;
+                    }
+                    CHECK((parent == FrustumTest::Inside) == (planeMask == 0));
+
+                    // Child box anywhere inside the parent.
+                    XMFLOAT3 childExtent(extent.x * unit(rng), extent.y * unit(rng), extent.z * unit(rng));
+                    XMFLOAT3 childCenter(
+                         center.x + (extent.x - childExtent.x) * (2.0f * unit(rng) - 1.0f),
+                         center.y + (extent.y - childExtent.y) * (2.0f * unit(rng) - 1.0f),
+                         center.z + (extent.z - childExtent.z) * (2.0f * unit(rng) - 1.0f));
+                    if (OnFrustumBoundary(frustum, childCenter, childExtent))
+                    {
+                         continue;
+                    }
+                    uint32_t childMask = planeMask;
+                    FrustumTest inherited = frustum.CheckAABB(childCenter, childExtent, childMask);
+                    FrustumTest full = frustum.CheckAABB(childCenter, childExtent);
+                    CHECK((inherited == FrustumTest::Outside) == (full == FrustumTest::Outside));
+               }
+          }
+     }
+
+     // Starting from a cached plane changes the order of tests but not the answer
+     void TestLastPlaneCache()
+     {
+          std::mt19937 rng(4);
+          std::uniform_real_distribution<float> coordinate(-60.0f, 60.0f);
+          std::uniform_real_distribution<float> size(0.01f, 5.0f);
+          Frustum frustum = RandomFrustum(rng);
+          for (int box = 0; box < 20000; box++)
+          {
+               XMFLOAT3 center(coordinate(rng), coordinate(rng), coordinate(rng));
+               XMFLOAT3 extent(size(rng), size(rng), size(rng));
+               uint8_t lastPlane = static_cast<uint8_t>(box % 6);
+               uint32_t planeMask = Frustum::allPlanesMask;
+               FrustumTest cached = frustum.CheckAABB(center, extent, planeMask, lastPlane);
+               CHECK(cached == frustum.CheckAABB(center, extent));
+               CHECK(lastPlane < 6);
+          }
+     }
+
+     // Vector batch test over gathered ids agrees with the scalar test, including the scalar tail. Cached planes kept
+     // over frames give the same answer and name a plane the box is outside of
+     void TestGatheredBatch()
+     {
+          std::mt19937 rng(7);
+          std::uniform_real_distribution<float> coordinate(-60.0f, 60.0f);
+          std::uniform_real_distribution<float> size(0.01f, 5.0f);
+          const size_t count = 5000;
+          BoundsSoA bounds;
+          bounds.Resize(count);
+          for (size_t i = 0; i < count; ++i)
+          {
+               bounds.Set(i, XMFLOAT3(coordinate(rng), coordinate(rng), coordinate(rng)), XMFLOAT3(size(rng), size(rng), size(rng)));
+          }
+          std::vector<uint32_t> ids;
+          std::uniform_int_distribution<uint32_t> pick(0, count - 1);
+          for (size_t i = 0; i < 1237; ++i)
+          {
+               ids.push_back(pick(rng));
+          }
+
+          std::vector<uint8_t> lastPlanes(ids.size(), 0);
+          for (int view = 0; view < 20; view++)
+          {
+               Frustum frustum = RandomFrustum(rng);
+               std::vector<uint8_t> visible(ids.size(), 2);
+               frustum.CheckAABBBatch(bounds, ids.data(), ids.size(), visible.data());
+               std::vector<uint8_t> cached(ids.size(), 2);
+               frustum.CheckAABBBatch(bounds, ids.data(), ids.size(), cached.data(), lastPlanes.data());
+               CHECK(cached == visible);
+               for (size_t i = 0; i < ids.size(); ++i)
+               {
+                    XMFLOAT3 center(bounds.centerX[ids[i]], bounds.centerY[ids[i]], bounds.centerZ[ids[i]]);
+                    XMFLOAT3 extent(bounds.extentX[ids[i]], bounds.extentY[ids[i]], bounds.extentZ[ids[i]]);
+                    CHECK(visible[i] <= 1);
+                    if (!OnFrustumBoundary(frustum, center, extent))
+                    {
+                         CHECK(visible[i] == (frustum.CheckAABB(center, extent) != FrustumTest::Outside ? 1 : 0));
+                    }
+                    if (!visible[i])
+                    {
+                         XMFLOAT4 plane = frustum.GetPlane(lastPlanes[i]);
+                         CHECK(plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w
+                              + fabsf(plane.x) * extent.x + fabsf(plane.y) * extent.y + fabsf(plane.z) * extent.z < 0.0f);
+                    }
+               }
+          }
+     }
+}
+
+int main()
+{
+     TestMatchesCornerTest();
+     TestPlaneMaskInheritance();
+     TestLastPlaneCache();
+     TestGatheredBatch();
+     return TestResult("FrustumTests");
+}
@@ -0,0 +1,178 @@
+#include "InstanceBatcher.h"
+#include "RecordingBatchContext.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+     const BatchMesh cubeMesh = { 0, 36, 0 };
+     const BatchMesh lowMesh = { 36, 12, 24 };
+
+     // Function to check that draws since the last ClearCalls read ids in order, each from its own page
+     bool DrawsReadIds(const RecordingBatchContext& context, const std::vector<uint32_t>& ids, size_t pageSize)
+     {
+          size_t first = 0;
+          for (const RecordingBatchContext::Draw& draw : context.draws)
+          {
+               if (draw.instanceCount > pageSize || draw.page.size() != draw.instanceCount
+                    || !std::equal(draw.page.begin(), draw.page.end(), ids.begin() + first))
+               {
+                    return false;
+               }
+               first += draw.instanceCount;
+          }
+          return first == ids.size();
+     }
+
+     void TestPageSize()
+     {
+          CHECK(InstanceBatcher().GetPageSize() == InstanceBatcher::maxPageSize);
+          CHECK(InstanceBatcher(10).GetPageSize() == 8);
+          CHECK(InstanceBatcher(0).GetPageSize() == 4);
+          CHECK(InstanceBatcher(InstanceBatcher::maxPageSize * 3).GetPageSize() == InstanceBatcher::maxPageSize);
+          CHECK(InstanceBatcher(8).GetDrawCount(17) == 3);
+     }
+
+     // Any count splits into full pages and a remainder, millions of ids included
+     void TestPageSplitting()
+     {
+          for (size_t count : { size_t(1), size_t(8), size_t(21), size_t(3000000) })
+          {
+               size_t pageSize = count > 100 ? InstanceBatcher::maxPageSize : 8;
+               InstanceBatcher batcher(pageSize);
+               RecordingBatchContext context;
+               std::vector<uint32_t> ids(count);
+               std::iota(ids.begin(), ids.end(), 7u);
+
+               CHECK(batcher.Draw(context, cubeMesh, ids.data(), ids.size(), true));
+               CHECK(context.draws.size() == batcher.GetDrawCount(count));
+               CHECK(context.idUploads.size() == context.draws.size());
+               CHECK(DrawsReadIds(context, ids, pageSize));
+               for (size_t i = 0; i + 1 < context.draws.size(); ++i)
+               {
+                    CHECK(context.draws[i].instanceCount == pageSize);
+               }
+          }
+
+          InstanceBatcher batcher;
+          RecordingBatchContext context;
+          CHECK(batcher.Draw(context, cubeMesh, nullptr, 0, true));
+          CHECK(context.draws.empty() && context.idUploads.empty());
+     }
+
+     // Instance buffer grows at least twice, keeps its size for smaller uploads and is recreated for a new stride
+     void TestInstanceBufferGrowth()
+     {
+          InstanceBatcher batcher;
+          RecordingBatchContext context;
+          std::vector<uint8_t> data(64 * 1000);
+          CHECK(batcher.UploadInstances(context, data.data(), 100, 16));
+          CHECK(context.bufferCreates.size() == 1 && context.bufferCreates[0] == 100 * 16);
+          CHECK(batcher.UploadInstances(context, data.data(), 150, 16));
+          CHECK(context.bufferCreates.size() == 2 && batcher.GetCapacity() == 200);
+          CHECK(batcher.UploadInstances(context, data.data(), 120, 16));
+          CHECK(context.bufferCreates.size() == 2);
+          CHECK(context.instanceUploads.back() == 120 * 16);
+          CHECK(batcher.UploadInstances(context, data.data(), 120, 32));
+          CHECK(context.bufferCreates.size() == 3 && context.bufferCreates.back() == 120 * 32);
+          CHECK(batcher.UploadInstances(context, data.data(), 1000, 32));
+          CHECK(batcher.GetCapacity() == 1000);
+
+          context.failCreate = true;
+          CHECK(!batcher.UploadInstances(context, data.data(), 2000, 32));
+          CHECK(batcher.GetCapacity() == 0);
+     }
+
+     // A single page stays resident while the same ids are drawn, changed ids and split lists upload again
+     void TestResidentIds()
+     {
+          InstanceBatcher batcher(8);
+          RecordingBatchContext context;
+          std::vector<uint32_t> ids = { 3, 1, 4, 1, 5 };
+          CHECK(batcher.Draw(context, cubeMesh, ids.data(), ids.size(), true));
+          CHECK(context.idUploads.size() == 1);
+
+          context.ClearCalls();
+          CHECK(batcher.Draw(context, cubeMesh, ids.data(), ids.size(), false));
+          CHECK(context.idUploads.empty());
+          CHECK(DrawsReadIds(context, ids, 8));
+
+          context.ClearCalls();
+          ids[0] = 9;
+          CHECK(batcher.Draw(context, cubeMesh, ids.data(), ids.size(), true));
+          CHECK(context.idUploads.size() == 1);
+          CHECK(DrawsReadIds(context, ids, 8));
+
+          // Fewer ids from the same list are a different page.
+          context.ClearCalls();
+          CHECK(batcher.Draw(context, cubeMesh, ids.data(), 3, false));
+          CHECK(context.idUploads.size() == 1);
+
+          std::vector<uint32_t> many(20);
+          std::iota(many.begin(), many.end(), 0u);
+          CHECK(batcher.Draw(context, cubeMesh, many.data(), many.size(), true));
+          context.ClearCalls();
+          CHECK(batcher.Draw(context, cubeMesh, many.data(), many.size(), false));
+          CHECK(context.idUploads.size() == 3);
+          CHECK(DrawsReadIds(context, many, 8));
+
+          // Reset forgets the page, e.g. after the device is recreated.
+          CHECK(batcher.Draw(context, cubeMesh, ids.data(), ids.size(), true));
+          batcher.Reset();
+          context.ClearCalls();
+          CHECK(batcher.Draw(context, cubeMesh, ids.data(), ids.size(), false));
+          CHECK(context.idUploads.size() == 1);
+     }
+
+     // Function to draw every LOD level like Renderer::Render does, one Draw per level with the shared page
+     void DrawLevels(InstanceBatcher& batcher, RecordingBatchContext& context, const std::vector<std::vector<uint32_t>>& levels,
+          bool idsChanged)
+     {
+          for (size_t level = 0; level < levels.size(); ++level)
+          {
+               CHECK(batcher.Draw(context, level == 0 ? cubeMesh : lowMesh, levels[level].data(), levels[level].size(), idsChanged));
+          }
+     }
+
+     // Levels share one id page, so it can stay resident only when a single level has ids. With more levels
+     // every frame uploads again, but each draw still reads its own ids
+     void TestLodLevelsSharePage()
+     {
+          InstanceBatcher batcher(16);
+          RecordingBatchContext context;
+          std::vector<std::vector<uint32_t>> single = { {}, { 2, 7, 9 }, {} };
+          DrawLevels(batcher, context, single, true);
+          CHECK(context.idUploads.size() == 1);
+          context.ClearCalls();
+          DrawLevels(batcher, context, single, false);
+          CHECK(context.idUploads.empty());
+          CHECK(context.draws.size() == 1);
+          CHECK(context.draws[0].page == single[1]);
+          CHECK(context.draws[0].mesh.startIndex == lowMesh.startIndex);
+
+          std::vector<std::vector<uint32_t>> two = { { 1, 4 }, { 2, 7, 9 }, {} };
+          DrawLevels(batcher, context, two, true);
+          for (int frame = 0; frame < 2; ++frame)
+          {
+               context.ClearCalls();
+               DrawLevels(batcher, context, two, false);
+               CHECK(context.idUploads.size() == 2);
+               CHECK(context.draws.size() == 2);
+               CHECK(context.draws[0].page == two[0]);
+               CHECK(context.draws[1].page == two[1]);
+          }
+     }
+}
+
+int main()
+{
+     TestPageSize();
+     TestPageSplitting();
+     TestInstanceBufferGrowth();
+     TestResidentIds();
+     TestLodLevelsSharePage();
+     return TestResult("InstanceBatcherTests");
+}
@@ -0,0 +1,82 @@
+#include "MultiFrustum.h"
+#include "TestCheck.h"
+#include "TestFrustum.h"
+
+#include <vector>
+
+namespace
+{
+     // One pass over all views has to match testing every view on its own
+     void TestMatchesSeparateViews(size_t viewCount, size_t boxCount, unsigned seed)
+     {
+          std::mt19937 rng(seed);
+          std::uniform_real_distribution<float> coordinate(-60.0f, 60.0f);
+          std::uniform_real_distribution<float> size(0.01f, 5.0f);
+          BoundsSoA bounds;
+          bounds.Resize(boxCount);
+          for (size_t i = 0; i < boxCount; ++i)
+          {
+               bounds.Set(i, XMFLOAT3(coordinate(rng), coordinate(rng), coordinate(rng)), XMFLOAT3(size(rng), size(rng), size(rng)));
+          }
+
+          MultiFrustum multi;
+          std::vector<Frustum> frusta;
+          for (size_t v = 0; v < viewCount; ++v)
+          {
+               frusta.push_back(RandomFrustum(rng));
+               CHECK(multi.AddView(frusta.back()) == static_cast<int>(v));
+          }
+          CHECK(multi.GetViewCount() == viewCount);
+
+          std::vector<uint32_t> masks(boxCount);
+          std::vector<std::vector<uint32_t>> visible(viewCount);
+          multi.Cull(bounds, masks.data(), visible.data());
+
+          for (size_t v = 0; v < viewCount; ++v)
+          {
+               size_t listed = 0;
+               for (size_t i = 0; i < boxCount; ++i)
+               {
+                    XMFLOAT3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+                    XMFLOAT3 extent(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+                    bool inView = (masks[i] >> v) & 1;
+                    listed += inView ? 1 : 0;
+                    if (!OnFrustumBoundary(frusta[v], center, extent))
+                    {
+                         CHECK(inView == (frusta[v].CheckAABB(center, extent) != FrustumTest::Outside));
+                    }
+               }
+               // Lists hold exactly the ids with the view bit set, in increasing order.
+               CHECK(visible[v].size() == listed);
+               for (size_t k = 0; k < visible[v].size(); ++k)
+               {
+                    CHECK((masks[visible[v][k]] >> v) & 1);
+                    CHECK(k == 0 || visible[v][k - 1] < visible[v][k]);
+               }
+          }
+     }
+
+     void TestViewLimit()
+     {
+          MultiFrustum multi;
+          Frustum frustum;
+          frustum.Init(0.1f);
+          frustum.ConstructFrustum(XMMatrixIdentity(), XMMatrixPerspectiveFovLH(XM_PI / 3, 1.0f, 100.0f, 0.1f));
+          for (size_t v = 0; v < MultiFrustum::maxViews; ++v)
+          {
+               CHECK(multi.AddView(frustum) >= 0);
+          }
+          CHECK(multi.AddView(frustum) == -1);
+          multi.Clear();
+          CHECK(multi.AddView(frustum) == 0);
+     }
+}
+
+int main()
+{
+     TestMatchesSeparateViews(6, 10000, 8);
+     TestMatchesSeparateViews(32, 2003, 9);
+     TestMatchesSeparateViews(1, 3, 10);
+     TestViewLimit();
+     return TestResult("MultiFrustumTests");
+}
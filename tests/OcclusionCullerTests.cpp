@@ -0,0 +1,95 @@
+#include "CubeMesh.h"
+#include "OcclusionCuller.h"
+#include "TestCheck.h"
+
+using namespace DirectX;
+
+namespace
+{
+     // Camera at the origin looking along +z with the renderer projection and buffer size
+     XMMATRIX ViewProj()
+     {
+          XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+          return XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XM_PI / 3, 320.0f / 192.0f, 100.0f, 0.1f));
+     }
+
+     void RenderBox(OcclusionCuller& culler, const XMFLOAT3& center, const XMFLOAT3& size)
+     {
+          XMMATRIX world = XMMatrixMultiply(XMMatrixScaling(size.x, size.y, size.z), XMMatrixTranslation(center.x, center.y, center.z));
+          culler.RenderOccluder(cubePositions, sizeof(XMFLOAT3), 24, cubeIndices, 36, world);
+     }
+
+     // Wall 10 units ahead: boxes fully behind it are hidden, anything in front, beside, straddling its edge
+     // or cutting through it stays visible
+     void TestWall()
+     {
+          OcclusionCuller culler;
+          culler.Init(320, 192);
+          culler.Clear(ViewProj());
+          RenderBox(culler, XMFLOAT3(0.0f, 0.0f, 10.0f), XMFLOAT3(8.0f, 6.0f, 0.5f));
+          culler.BuildHierarchy();
+
+          CHECK(!culler.TestAABB(XMFLOAT3(0.0f, 0.0f, 20.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+          CHECK(!culler.TestAABB(XMFLOAT3(1.5f, -1.0f, 15.0f), XMFLOAT3(0.5f, 0.5f, 0.5f)));
+          CHECK(!culler.TestAABB(XMFLOAT3(0.0f, 0.0f, 60.0f), XMFLOAT3(10.0f, 10.0f, 5.0f)));
+
+          CHECK(culler.TestAABB(XMFLOAT3(0.0f, 0.0f, 5.0f), XMFLOAT3(0.5f, 0.5f, 0.5f)));
+          CHECK(culler.TestAABB(XMFLOAT3(12.0f, 0.0f, 20.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+          CHECK(culler.TestAABB(XMFLOAT3(8.5f, 0.0f, 20.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+          CHECK(culler.TestAABB(XMFLOAT3(0.0f, 0.0f, 10.0f), XMFLOAT3(1.0f, 1.0f, 2.0f)));
+          CHECK(culler.TestAABB(XMFLOAT3(0.0f, 0.0f, 30.0f), XMFLOAT3(20.0f, 1.0f, 1.0f)));
+          // Boxes reaching behind the camera are never culled.
+          CHECK(culler.TestAABB(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+     }
+
+     // Two cubes side by side leave a gap, a box seen through the gap is visible, one behind either cube is not
+     void TestGapBetweenOccluders()
+     {
+          OcclusionCuller culler;
+          culler.Init(320, 192);
+          culler.Clear(ViewProj());
+          RenderBox(culler, XMFLOAT3(-2.0f, 0.0f, 8.0f), XMFLOAT3(3.0f, 3.0f, 3.0f));
+          RenderBox(culler, XMFLOAT3(2.0f, 0.0f, 8.0f), XMFLOAT3(3.0f, 3.0f, 3.0f));
+          culler.BuildHierarchy();
+
+          CHECK(culler.TestAABB(XMFLOAT3(0.0f, 0.0f, 20.0f), XMFLOAT3(0.3f, 0.3f, 0.3f)));
+          CHECK(!culler.TestAABB(XMFLOAT3(-4.0f, 0.0f, 20.0f), XMFLOAT3(0.5f, 0.5f, 0.5f)));
+          CHECK(!culler.TestAABB(XMFLOAT3(4.0f, 0.0f, 20.0f), XMFLOAT3(0.5f, 0.5f, 0.5f)));
+     }
+
+     // Faces turned away from the camera are not rasterized, so a cube seen from inside hides nothing
+     void TestBackFaces()
+     {
+          OcclusionCuller culler;
+          culler.Init(320, 192);
+          culler.Clear(ViewProj());
+          RenderBox(culler, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(4.0f, 4.0f, 4.0f));
+          culler.BuildHierarchy();
+
+          CHECK(culler.TestAABB(XMFLOAT3(0.0f, 0.0f, 20.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+     }
+
+     // Clearing drops the occluders of the previous view
+     void TestClear()
+     {
+          OcclusionCuller culler;
+          culler.Init(320, 192);
+          culler.Clear(ViewProj());
+          RenderBox(culler, XMFLOAT3(0.0f, 0.0f, 10.0f), XMFLOAT3(8.0f, 6.0f, 0.5f));
+          culler.BuildHierarchy();
+          CHECK(!culler.TestAABB(XMFLOAT3(0.0f, 0.0f, 20.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+
+          culler.Clear(ViewProj());
+          culler.BuildHierarchy();
+          CHECK(culler.TestAABB(XMFLOAT3(0.0f, 0.0f, 20.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+     }
+}
+
+int main()
+{
+     TestWall();
+     TestGapBetweenOccluders();
+     TestBackFaces();
+     TestClear();
+     return TestResult("OcclusionCullerTests");
+}
@@ -0,0 +1,137 @@
+#include "DemoScene.h"
+#include "TestCheck.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+     void InitScene(Scene& scene)
+     {
+          scene.Init(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f), BuildCubeLodChain(), InstanceBatcher::maxPageSize);
+     }
+
+     void UpdateView(Scene& scene, const XMFLOAT3& eye, const XMFLOAT3& target, uint64_t cameraVersion)
+     {
+          XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&target), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+          XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f);
+          scene.Update(0.0f, view, proj, eye, cameraVersion, 720);
+     }
+
+     bool IsDrawn(const Scene& scene, InstanceHandle handle)
+     {
+          return scene.GetDrawMask().Test(scene.GetInstances().GetIndex(handle));
+     }
+
+     // Two cells joined by a narrow door and no walls, so nothing but the portal can hide the cube in the far corner
+     void TestPortalNarrowsFrustum()
+     {
+          Scene scene(2);
+          InitScene(scene);
+          int near = scene.AddCell(XMFLOAT3(0.0f, 2.0f, 5.0f), XMFLOAT3(5.0f, 2.0f, 5.0f));
+          int far = scene.AddCell(XMFLOAT3(0.0f, 2.0f, 15.0f), XMFLOAT3(5.0f, 2.0f, 5.0f));
+          XMFLOAT3 door[4] = {
+               XMFLOAT3(-1.0f, 0.0f, 10.0f), XMFLOAT3(-1.0f, 3.0f, 10.0f), XMFLOAT3(1.0f, 3.0f, 10.0f), XMFLOAT3(1.0f, 0.0f, 10.0f)
+          };
+          CHECK(scene.AddPortal(near, far, door) == 0);
+
+          InstanceHandle side = scene.AddInstance(XMMatrixTranslation(-3.0f, 0.5f, 6.0f), 0);
+          InstanceHandle behindDoor = scene.AddInstance(XMMatrixTranslation(0.0f, 0.5f, 15.0f), 0);
+          InstanceHandle corner = scene.AddInstance(XMMatrixTranslation(3.5f, 0.5f, 18.5f), 0);
+          CHECK(scene.AddInstanceToCell(near, side));
+          CHECK(scene.AddInstanceToCell(far, behindDoor));
+          CHECK(scene.AddInstanceToCell(far, corner));
+          scene.Build();
+
+          UpdateView(scene, XMFLOAT3(0.0f, 1.5f, 2.0f), XMFLOAT3(0.0f, 1.5f, 30.0f), 1);
+          CHECK(IsDrawn(scene, side));
+          CHECK(IsDrawn(scene, behindDoor));
+          CHECK(!IsDrawn(scene, corner));
+
+          // Outside of every cell the tree culls by the view frustum alone.
+          UpdateView(scene, XMFLOAT3(0.0f, 1.5f, -3.0f), XMFLOAT3(0.0f, 1.5f, 30.0f), 2);
+          CHECK(IsDrawn(scene, side));
+          CHECK(IsDrawn(scene, behindDoor));
+          CHECK(IsDrawn(scene, corner));
+     }
+
+     // Door half out of the view, the part of the far cell seen through it but beside the view stays hidden
+     void TestPortalPartlyInView()
+     {
+          Scene scene(2);
+          InitScene(scene);
+          int near = scene.AddCell(XMFLOAT3(0.0f, 2.0f, 5.0f), XMFLOAT3(5.0f, 2.0f, 5.0f));
+          int far = scene.AddCell(XMFLOAT3(0.0f, 2.0f, 15.0f), XMFLOAT3(5.0f, 2.0f, 5.0f));
+          XMFLOAT3 door[4] = {
+               XMFLOAT3(-1.0f, 0.0f, 10.0f), XMFLOAT3(-1.0f, 3.0f, 10.0f), XMFLOAT3(1.0f, 3.0f, 10.0f), XMFLOAT3(1.0f, 0.0f, 10.0f)
+          };
+          CHECK(scene.AddPortal(near, far, door) == 0);
+
+          InstanceHandle inView = scene.AddInstance(XMMatrixTranslation(1.2f, 0.5f, 15.0f), 0);
+          InstanceHandle besideView = scene.AddInstance(XMMatrixTranslation(-1.5f, 0.5f, 18.0f), 0);
+          CHECK(scene.AddInstanceToCell(far, inView));
+          CHECK(scene.AddInstanceToCell(far, besideView));
+          scene.Build();
+
+          // Looking 50 degrees right puts the left edge of the view across the door.
+          XMFLOAT3 eye(0.0f, 1.5f, 2.0f);
+          float yaw = 50.0f * XM_PI / 180.0f;
+          UpdateView(scene, eye, XMFLOAT3(eye.x + sinf(yaw), eye.y, eye.z + cosf(yaw)), 1);
+          CHECK(IsDrawn(scene, inView));
+          CHECK(!IsDrawn(scene, besideView));
+     }
+
+     // Aligned doorways of the demo level let the eye see through two rooms but not into their corners
+     void TestPortalLevel()
+     {
+          Scene scene(2);
+          InitScene(scene);
+          std::vector<PortalRoom> rooms = BuildPortalLevel(scene, XMFLOAT3(0.0f, 0.0f, 0.0f), 3, 0);
+          CHECK(rooms.size() == 3);
+          scene.Build();
+
+          UpdateView(scene, XMFLOAT3(0.0f, 1.5f, 2.0f), XMFLOAT3(0.0f, 1.5f, 30.0f), 1);
+          CHECK(IsDrawn(scene, rooms[0].center));
+          CHECK(IsDrawn(scene, rooms[0].corner));
+          CHECK(IsDrawn(scene, rooms[1].center));
+          CHECK(!IsDrawn(scene, rooms[1].corner));
+          CHECK(IsDrawn(scene, rooms[2].center));
+          CHECK(!IsDrawn(scene, rooms[2].corner));
+
+          // Removal moves the last instance to the freed position, cells have to follow it.
+          CHECK(scene.RemoveInstance(rooms[0].corner));
+          UpdateView(scene, XMFLOAT3(0.0f, 1.5f, 2.0f), XMFLOAT3(0.0f, 1.5f, 30.0f), 1);
+          CHECK(IsDrawn(scene, rooms[1].center));
+          CHECK(IsDrawn(scene, rooms[2].center));
+          CHECK(!IsDrawn(scene, rooms[2].corner));
+
+          // Looking back from the last room shows the first one through both doors.
+          UpdateView(scene, XMFLOAT3(0.0f, 1.5f, 28.0f), XMFLOAT3(0.0f, 1.5f, 0.0f), 2);
+          CHECK(IsDrawn(scene, rooms[0].center));
+          CHECK(!IsDrawn(scene, rooms[1].corner));
+     }
+
+     void TestRejectsBadCells()
+     {
+          Scene scene(1);
+          InitScene(scene);
+          int cell = scene.AddCell(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+          XMFLOAT3 corners[4] = {};
+          CHECK(scene.AddPortal(cell, cell, corners) == -1);
+          CHECK(scene.AddPortal(cell, 5, corners) == -1);
+          CHECK(!scene.AddInstanceToCell(cell, InstanceHandle()));
+          InstanceHandle handle = scene.AddInstance(XMMatrixIdentity(), 0);
+          CHECK(!scene.AddInstanceToCell(-1, handle));
+          CHECK(scene.AddInstanceToCell(cell, handle));
+     }
+}
+
+int main()
+{
+     TestPortalNarrowsFrustum();
+     TestPortalPartlyInView();
+     TestPortalLevel();
+     TestRejectsBadCells();
+     return TestResult("PortalGraphTests");
+}
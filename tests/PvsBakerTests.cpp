@@ -0,0 +1,182 @@
+#include "DemoScene.h"
+#include "TestCheck.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+     struct WallScene
+     {
+          InstanceHandle wall;
+          InstanceHandle front;
+          InstanceHandle hidden;
+          InstanceHandle animated;
+     };
+
+     // Wide wall at z = 10 with one cube in front of it, one static and one spinning cube behind it
+     WallScene BuildWallScene(Scene& scene)
+     {
+          scene.Init(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f), BuildCubeLodChain(), InstanceBatcher::maxPageSize);
+          WallScene result;
+          result.wall = scene.AddInstance(XMMatrixMultiply(XMMatrixScaling(60.0f, 30.0f, 1.0f), XMMatrixTranslation(0.0f, 2.0f, 10.0f)), 0);
+          result.front = scene.AddInstance(XMMatrixTranslation(0.0f, 0.0f, 5.0f), 0);
+          result.hidden = scene.AddInstance(XMMatrixTranslation(-2.0f, 0.0f, 14.0f), 0);
+          result.animated = scene.AddInstance(XMMatrixTranslation(2.0f, 0.0f, 14.0f), 0);
+          Motion motion;
+          motion.flags = MotionSpin;
+          motion.center = XMFLOAT3(2.0f, 0.0f, 14.0f);
+          motion.spinSpeed = 1.0f;
+          scene.SetInstanceMotion(result.animated, motion);
+          scene.Build();
+          return result;
+     }
+
+     size_t UpdateInFrustum(Scene& scene, const XMFLOAT3& eye)
+     {
+          XMFLOAT3 target(eye.x, eye.y, eye.z + 10.0f);
+          XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&target), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+          XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f);
+          scene.Update(0.0f, view, proj, eye, 1, 720);
+          return scene.GetCullingStats().inFrustum;
+     }
+
+     // Baked set of a cell in front of the wall holds what can be seen from there, the saved file is used by Update
+     void TestBakeThenLookup()
+     {
+          Scene scene(4);
+          WallScene content = BuildWallScene(scene);
+          PvsBakeSettings settings;
+          settings.resolution = 64;
+          PvsTable table;
+          scene.BakePvs(settings, table);
+          CHECK(table.GetInstanceCount() == scene.GetInstances().Size());
+
+          XMFLOAT3 eye(0.0f, 0.0f, 1.0f);
+          int cell = table.FindCell(eye);
+          CHECK(cell >= 0);
+          Bitset visible;
+          table.GetVisibleSet(cell, visible);
+          CHECK(visible.Test(scene.GetInstances().GetIndex(content.wall)));
+          CHECK(visible.Test(scene.GetInstances().GetIndex(content.front)));
+          CHECK(!visible.Test(scene.GetInstances().GetIndex(content.hidden)));
+          CHECK(!visible.Test(scene.GetInstances().GetIndex(content.animated)));
+
+          // Cell behind the wall sees the cubes there.
+          int behind = table.FindCell(XMFLOAT3(0.0f, 0.0f, 13.0f));
+          CHECK(behind >= 0);
+          table.GetVisibleSet(behind, visible);
+          CHECK(visible.Test(scene.GetInstances().GetIndex(content.hidden)));
+
+          const char* path = "PvsBakerTests.pvs";
+          CHECK(table.Save(path));
+
+          // Everything in front of the camera passes the frustum, the baked set removes the hidden static cube only.
+          Scene baked(4);
+          BuildWallScene(baked);
+          CHECK(baked.LoadPvs(path));
+          CHECK(UpdateInFrustum(baked, eye) == 3);
+          Scene plain(4);
+          BuildWallScene(plain);
+          CHECK(UpdateInFrustum(plain, eye) == 4);
+
+          // Sets made for another scene are dropped.
+          Scene other(4);
+          BuildWallScene(other);
+          other.AddInstance(XMMatrixIdentity(), 0);
+          other.Build();
+          CHECK(!other.LoadPvs(path));
+          std::remove(path);
+     }
+
+     // Thin bar turned 45 degrees in front of a cube: the world box of the bar would hide the cube, the bar itself does not
+     void TestRotatedOccluder()
+     {
+          Scene scene(4);
+          scene.Init(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f), BuildCubeLodChain(), InstanceBatcher::maxPageSize);
+          XMMATRIX bar = XMMatrixMultiply(XMMatrixScaling(20.0f, 1.0f, 0.2f), XMMatrixRotationZ(XM_PIDIV4));
+          scene.AddInstance(XMMatrixMultiply(bar, XMMatrixTranslation(0.0f, 0.0f, 10.0f)), 0);
+          InstanceHandle cube = scene.AddInstance(XMMatrixTranslation(5.0f, -5.0f, 14.0f), 0);
+          // Cube off to the side stretches the grid over the camera.
+          scene.AddInstance(XMMatrixTranslation(-20.0f, 0.0f, -2.0f), 0);
+          scene.Build();
+
+          PvsBakeSettings settings;
+          settings.resolution = 64;
+          PvsTable table;
+          scene.BakePvs(settings, table);
+          Bitset visible;
+          CHECK(table.GetVisibleSet(table.FindCell(XMFLOAT3(0.0f, 0.0f, 1.0f)), visible));
+          CHECK(visible.Test(scene.GetInstances().GetIndex(cube)));
+     }
+
+     std::vector<char> ReadFile(const char* path)
+     {
+          std::ifstream file(path, std::ios::binary);
+          return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+     }
+
+     void WriteFile(const char* path, const std::vector<char>& bytes)
+     {
+          std::ofstream file(path, std::ios::binary);
+          file.write(bytes.data(), bytes.size());
+     }
+
+     // Damaged files are rejected instead of decoded past the data, runs longer than the table are cut
+     void TestLoadRejectsBadData()
+     {
+          Bitset set;
+          set.Resize(10);
+          set.Set(3);
+          std::vector<Bitset> cellSets(4, set);
+          PvsTable table;
+          table.Build(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f), XMUINT3(4, 1, 1), 10, cellSets);
+          const char* path = "PvsTableTests.pvs";
+          CHECK(table.Save(path));
+          std::vector<char> saved = ReadFile(path);
+          const size_t offsetsStart = 12 * sizeof(uint32_t);
+          const size_t dataStart = offsetsStart + 5 * sizeof(uint32_t);
+          PvsTable loaded;
+          CHECK(loaded.Load(path));
+          CHECK(loaded.GetCellCount() == 4);
+          CHECK(!loaded.GetVisibleSet(4, set) && !loaded.GetVisibleSet(-1, set));
+
+          std::vector<char> bytes(saved.begin(), saved.end() - 1);
+          WriteFile(path, bytes);
+          CHECK(!loaded.Load(path) && loaded.IsEmpty());
+
+          // Second cell starting where the first one does.
+          bytes = saved;
+          bytes[offsetsStart + sizeof(uint32_t)] = 0;
+          WriteFile(path, bytes);
+          CHECK(!loaded.Load(path));
+
+          // Last run without its final byte.
+          bytes = saved;
+          bytes.back() |= static_cast<char>(0x80);
+          WriteFile(path, bytes);
+          CHECK(!loaded.Load(path));
+
+          // Set run of the first cell covering far more than 10 instances.
+          bytes = saved;
+          bytes[dataStart + 1] = 0x7F;
+          WriteFile(path, bytes);
+          CHECK(loaded.Load(path));
+          Bitset visible;
+          CHECK(loaded.GetVisibleSet(0, visible));
+          CHECK(visible.Size() == 10 && visible.Test(3) && visible.Test(9) && !visible.Test(2));
+          std::remove(path);
+     }
+}
+
+int main()
+{
+     TestBakeThenLookup();
+     TestRotatedOccluder();
+     TestLoadRejectsBadData();
+     return TestResult("PvsBakerTests");
+}
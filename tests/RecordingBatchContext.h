@@ -0,0 +1,66 @@
+#pragma once
+
+#include "InstanceBatcher.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Batch context that records every call instead of talking to a device. The id page keeps what was
+// uploaded last, so every draw knows which ids it would read
+class RecordingBatchContext : public BatchContext
+{
+public:
+     struct Draw
+     {
+          BatchMesh mesh;
+          size_t instanceCount;
+          std::vector<uint32_t> page;
+     };
+
+     bool CreateInstanceBuffer(size_t capacity, size_t stride) override
+     {
+          bufferCreates.push_back(capacity * stride);
+          if (failCreate)
+          {
+               return false;
+          }
+          bufferSize = capacity * stride;
+          return true;
+     }
+
+     bool UploadInstances(const void*, size_t size) override
+     {
+          instanceUploads.push_back(size);
+          return size <= bufferSize;
+     }
+
+     bool UploadIds(const uint32_t* ids, size_t count) override
+     {
+          idUploads.push_back(count);
+          page.assign(ids, ids + count);
+          return true;
+     }
+
+     void DrawIndexedInstanced(const BatchMesh& mesh, size_t instanceCount) override
+     {
+          draws.push_back(Draw{ mesh, instanceCount, page });
+     }
+
+     // Function to forget recorded calls, device state stays
+     void ClearCalls()
+     {
+          bufferCreates.clear();
+          instanceUploads.clear();
+          idUploads.clear();
+          draws.clear();
+     }
+
+     bool failCreate = false;
+     size_t bufferSize = 0;
+     std::vector<uint32_t> page;
+     // Bytes of every created buffer and of every instance upload, ids of every page upload
+     std::vector<size_t> bufferCreates;
+     std::vector<size_t> instanceUploads;
+     std::vector<size_t> idUploads;
+     std::vector<Draw> draws;
+};
@@ -0,0 +1,327 @@
+#include "DemoScene.h"
+#include "TestCheck.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+     // Camera used by the scene tests, in front of the field looking along +z
+     struct TestView
+     {
+          XMMATRIX view;
+          XMMATRIX proj;
+          XMFLOAT3 pov;
+     };
+
+     TestView MakeView(const XMFLOAT3& eye, const XMFLOAT3& target)
+     {
+          TestView result;
+          result.pov = eye;
+          result.view = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&target), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+          result.proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f);
+          return result;
+     }
+
+     XMMATRIX FieldTransform(std::mt19937& rng)
+     {
+          std::uniform_real_distribution<float> x(-40.0f, 40.0f);
+          std::uniform_real_distribution<float> y(-4.0f, 4.0f);
+          std::uniform_real_distribution<float> z(6.0f, 90.0f);
+          std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+          return XMMatrixMultiply(XMMatrixRotationY(angle(rng)), XMMatrixTranslation(x(rng), y(rng), z(rng)));
+     }
+
+     void InitScene(Scene& scene)
+     {
+          scene.Init(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f), BuildCubeLodChain(), InstanceBatcher::maxPageSize);
+     }
+
+     // Moving random subsets of instances and re-testing only them has to give the draw mask of a full pass.
+     // Most frames move far instances, which keeps the partial path, some move instances next to the camera
+     // or the occluders themselves, which has to fall back to a full pass
+     void TestPartialMatchesFullPass()
+     {
+          std::mt19937 rng(11);
+          Scene scene(4);
+          InitScene(scene);
+
+          // Wide boxes right in front of the camera are the nearest visible instances and occlude the field.
+          std::vector<InstanceHandle> walls;
+          for (int i = 0; i < 10; i++)
+          {
+               XMMATRIX world = XMMatrixMultiply(XMMatrixScaling(1.5f, 2.0f, 0.5f), XMMatrixTranslation(-6.0f + 1.4f * i, 1.0f, 2.0f));
+               walls.push_back(scene.AddInstance(world, 0));
+          }
+          std::vector<InstanceHandle> field;
+          for (int i = 0; i < 5000; i++)
+          {
+               field.push_back(scene.AddInstance(FieldTransform(rng), static_cast<uint16_t>(i % 3)));
+          }
+          scene.Build();
+
+          TestView view = MakeView(XMFLOAT3(0.0f, 1.5f, -6.0f), XMFLOAT3(0.0f, 0.0f, 40.0f));
+          scene.Update(0.0f, view.view, view.proj, view.pov, 1, 720);
+          CHECK(scene.GetCullingStats().fullPass);
+
+          size_t partialFrames = 0;
+          size_t fullFrames = 0;
+          size_t changedBits = 0;
+          std::uniform_int_distribution<size_t> subsetSize(1, 64);
+          std::uniform_int_distribution<size_t> pickField(0, field.size() - 1);
+          std::uniform_int_distribution<size_t> pickWall(0, walls.size() - 1);
+          std::uniform_real_distribution<float> nearX(-3.0f, 3.0f);
+          for (int frame = 1; frame <= 300; frame++)
+          {
+               size_t count = subsetSize(rng);
+               for (size_t i = 0; i < count; ++i)
+               {
+                    CHECK(scene.SetInstanceTransform(field[pickField(rng)], FieldTransform(rng)));
+               }
+               if (frame % 25 == 0)
+               {
+                    scene.SetInstanceTransform(field[pickField(rng)], XMMatrixTranslation(nearX(rng), 1.0f, 0.0f));
+               }
+               if (frame % 40 == 0)
+               {
+                    XMMATRIX world = XMMatrixMultiply(XMMatrixScaling(1.5f, 2.0f, 0.5f), XMMatrixTranslation(nearX(rng), 1.0f, 2.5f));
+                    scene.SetInstanceTransform(walls[pickWall(rng)], world);
+               }
+
+               Bitset before = scene.GetDrawMask();
+               CHECK(scene.Update(0.0f, view.view, view.proj, view.pov, 1, 720));
+               Bitset updated = scene.GetDrawMask();
+               size_t inFrustum = scene.GetCullingStats().inFrustum;
+               bool full = scene.GetCullingStats().fullPass;
+               (full ? fullFrames : partialFrames)++;
+               for (size_t idx = 0; idx < scene.GetInstances().Size(); ++idx)
+               {
+                    changedBits += updated.Test(idx) != before.Test(idx);
+               }
+
+               scene.Invalidate();
+               scene.Update(0.0f, view.view, view.proj, view.pov, 1, 720);
+               CHECK(scene.GetCullingStats().fullPass);
+               CHECK(scene.GetDrawMask().words == updated.words);
+               CHECK(scene.GetCullingStats().inFrustum == inFrustum);
+          }
+
+          // Both paths ran and the moves changed what is drawn.
+          CHECK(partialFrames > 200);
+          CHECK(fullFrames >= 10);
+          CHECK(changedBits > 0);
+     }
+
+     // Without moves or camera changes the previous result is kept, a new camera version culls again
+     void TestUnchangedFrameKeepsResult()
+     {
+          std::mt19937 rng(12);
+          Scene scene(2);
+          InitScene(scene);
+          for (int i = 0; i < 500; i++)
+          {
+               scene.AddInstance(FieldTransform(rng), 0);
+          }
+          scene.Build();
+
+          TestView view = MakeView(XMFLOAT3(0.0f, 1.5f, -6.0f), XMFLOAT3(0.0f, 0.0f, 40.0f));
+          CHECK(scene.Update(0.0f, view.view, view.proj, view.pov, 1, 720));
+          size_t drawn = scene.GetCullingStats().drawn;
+          CHECK(drawn > 0);
+          CHECK(!scene.Update(0.0f, view.view, view.proj, view.pov, 1, 720));
+          CHECK(!scene.GetCullingStats().fullPass);
+          CHECK(scene.GetCullingStats().drawn == drawn);
+
+          TestView turned = MakeView(XMFLOAT3(0.0f, 1.5f, -6.0f), XMFLOAT3(0.0f, 0.0f, -40.0f));
+          CHECK(scene.Update(0.0f, turned.view, turned.proj, turned.pov, 2, 720));
+          CHECK(scene.GetCullingStats().fullPass);
+          CHECK(scene.GetCullingStats().drawn == 0);
+     }
+
+     // Ids of every LOD level together are the set bits of the draw mask
+     void TestLodIdsMatchDrawMask()
+     {
+          std::mt19937 rng(13);
+          Scene scene(2);
+          InitScene(scene);
+          for (int i = 0; i < 2000; i++)
+          {
+               scene.AddInstance(FieldTransform(rng), static_cast<uint16_t>(i % 5));
+          }
+          scene.Build();
+
+          TestView view = MakeView(XMFLOAT3(0.0f, 1.5f, -6.0f), XMFLOAT3(0.0f, 0.0f, 40.0f));
+          scene.Update(0.0f, view.view, view.proj, view.pov, 1, 720);
+          std::vector<uint8_t> listed(scene.GetInstances().Size(), 0);
+          size_t total = 0;
+          for (size_t level = 0; level < scene.GetLods().size(); ++level)
+          {
+               const uint32_t* ids = scene.GetLodIds(level);
+               for (size_t i = 0; i < scene.GetLodIdCount(level); ++i)
+               {
+                    CHECK(scene.GetInstances().lods[ids[i]] == level);
+                    ++listed[ids[i]];
+                    ++total;
+               }
+          }
+          CHECK(total == scene.GetCullingStats().drawn);
+          for (size_t idx = 0; idx < listed.size(); ++idx)
+          {
+               CHECK(listed[idx] == (scene.GetDrawMask().Test(idx) ? 1 : 0));
+          }
+     }
+
+     // Nodes follow their parents, ids that are not nodes are rejected without adding anything
+     void TestSceneNodes()
+     {
+          Scene scene(1);
+          InitScene(scene);
+          InstanceHandle child = scene.AddInstance(XMMatrixIdentity(), 0);
+          uint32_t root = scene.AddSceneNode(SceneGraph::noParent, XMMatrixTranslation(1.0f, 0.0f, 0.0f));
+          uint32_t node = scene.AddSceneNode(root, XMMatrixTranslation(0.0f, 2.0f, 0.0f), child);
+          CHECK(root == 0 && node == 1);
+          CHECK(scene.AddSceneNode(2, XMMatrixIdentity()) == SceneGraph::noParent);
+          CHECK(scene.AddSceneNode(0xFFFFFFF0u, XMMatrixIdentity(), child) == SceneGraph::noParent);
+          CHECK(!scene.SetSceneNodeTransform(2, XMMatrixIdentity()));
+          CHECK(scene.AddSceneNode(node, XMMatrixIdentity()) == 2);
+          scene.Build();
+
+          TestView view = MakeView(XMFLOAT3(0.0f, 0.0f, -10.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+          CHECK(scene.SetSceneNodeTransform(root, XMMatrixTranslation(3.0f, 0.0f, 0.0f)));
+          scene.Update(0.0f, view.view, view.proj, view.pov, 1, 720);
+          uint32_t idx = scene.GetInstances().GetIndex(child);
+          CHECK(scene.GetInstances().bounds.centerX[idx] == 3.0f);
+          CHECK(scene.GetInstances().bounds.centerY[idx] == 2.0f);
+     }
+
+     // Animated instances attached to scene nodes have to follow their nodes, both lane and tail paths.
+     void TestAnimatedSceneNodes()
+     {
+          Scene scene(1);
+          InitScene(scene);
+          Motion motion;
+          motion.flags = MotionSpin;
+          motion.spinSpeed = 1.0f;
+          InstanceHandle free = scene.AddInstance(XMMatrixTranslation(0.0f, 0.0f, 5.0f), 0);
+          motion.center = XMFLOAT3(0.0f, 0.0f, 5.0f);
+          CHECK(scene.SetInstanceMotion(free, motion));
+          motion.center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+          static constexpr int childCount = 6;
+          uint32_t root = scene.AddSceneNode(SceneGraph::noParent, XMMatrixIdentity());
+          InstanceHandle children[childCount];
+          for (int i = 0; i < childCount; i++)
+          {
+               XMMATRIX local = XMMatrixTranslation(2.0f * i, 0.0f, 0.0f);
+               children[i] = scene.AddInstance(local, 0);
+               scene.AddSceneNode(root, local, children[i]);
+               CHECK(scene.SetInstanceMotion(children[i], motion));
+          }
+          scene.Build();
+
+          TestView view = MakeView(XMFLOAT3(0.0f, 0.0f, -10.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+          XMMATRIX rootWorld = XMMatrixMultiply(XMMatrixRotationY(XM_PIDIV2), XMMatrixTranslation(0.0f, 1.0f, 10.0f));
+          CHECK(scene.SetSceneNodeTransform(root, rootWorld));
+          scene.Update(1.0f, view.view, view.proj, view.pov, 1, 720);
+          const InstanceStore& instances = scene.GetInstances();
+          for (int i = 0; i < childCount; i++)
+          {
+               XMFLOAT3 expected;
+               XMStoreFloat3(&expected, XMVector3Transform(XMVectorSet(2.0f * i, 0.0f, 0.0f, 1.0f), rootWorld));
+               uint32_t idx = instances.GetIndex(children[i]);
+               CHECK(fabsf(instances.bounds.centerX[idx] - expected.x) < 1e-4f);
+               CHECK(fabsf(instances.bounds.centerY[idx] - expected.y) < 1e-4f);
+               CHECK(fabsf(instances.bounds.centerZ[idx] - expected.z) < 1e-4f);
+          }
+          uint32_t idx = instances.GetIndex(free);
+          CHECK(fabsf(instances.bounds.centerX[idx]) < 1e-4f && fabsf(instances.bounds.centerZ[idx] - 5.0f) < 1e-4f);
+     }
+
+     // Instances in the static hierarchy that move later are culled with their new boxes, removing an instance
+     // shifts dense positions and must not change which of the remaining ones are drawn
+     void TestStaticInstances()
+     {
+          std::mt19937 rng(14);
+          Scene scene(2);
+          InitScene(scene);
+          std::vector<InstanceHandle> field;
+          for (int i = 0; i < 3000; i++)
+          {
+               field.push_back(scene.AddInstance(FieldTransform(rng), 0));
+          }
+          InstanceHandle behind = scene.AddInstance(XMMatrixTranslation(0.0f, 0.0f, -30.0f), 0);
+          InstanceHandle moved = scene.AddInstance(XMMatrixTranslation(0.0f, 1.0f, 20.0f), 0);
+          scene.Build();
+
+          TestView view = MakeView(XMFLOAT3(0.0f, 1.5f, -6.0f), XMFLOAT3(0.0f, 0.0f, 40.0f));
+          scene.Update(0.0f, view.view, view.proj, view.pov, 1, 720);
+          const InstanceStore& instances = scene.GetInstances();
+          CHECK(scene.GetDrawMask().Test(instances.GetIndex(moved)));
+          CHECK(!scene.GetDrawMask().Test(instances.GetIndex(behind)));
+
+          CHECK(scene.SetInstanceTransform(moved, XMMatrixTranslation(0.0f, 1.0f, -20.0f)));
+          scene.Update(0.0f, view.view, view.proj, view.pov, 2, 720);
+          CHECK(!scene.GetDrawMask().Test(instances.GetIndex(moved)));
+          CHECK(scene.SetInstanceTransform(moved, XMMatrixTranslation(0.0f, 1.0f, 20.0f)));
+          scene.Update(0.0f, view.view, view.proj, view.pov, 3, 720);
+          CHECK(scene.GetDrawMask().Test(instances.GetIndex(moved)));
+
+          std::vector<InstanceHandle> drawn;
+          for (InstanceHandle handle : field)
+          {
+               if (scene.GetDrawMask().Test(instances.GetIndex(handle)))
+               {
+                    drawn.push_back(handle);
+               }
+          }
+          CHECK(!drawn.empty());
+          CHECK(scene.RemoveInstance(behind));
+          scene.Update(0.0f, view.view, view.proj, view.pov, 4, 720);
+          size_t drawnAfter = 0;
+          for (InstanceHandle handle : field)
+          {
+               drawnAfter += scene.GetDrawMask().Test(instances.GetIndex(handle));
+          }
+          CHECK(drawnAfter == drawn.size());
+          for (InstanceHandle handle : drawn)
+          {
+               CHECK(scene.GetDrawMask().Test(instances.GetIndex(handle)));
+          }
+     }
+
+     // Instances must not get the index of a failed AddMaterial, it is past the end of the material table.
+     void TestFullMaterialTable()
+     {
+          Scene scene(1);
+          InitScene(scene);
+          Material material;
+          bool sequential = true;
+          for (uint32_t i = 0; i < MaterialRegistry::invalidIndex; ++i)
+          {
+               material.specularPower = static_cast<float>(i);
+               sequential = sequential && scene.AddMaterial(material) == i;
+          }
+          CHECK(sequential);
+          material.specularPower = -1.0f;
+          uint16_t full = scene.AddMaterial(material);
+          CHECK(full == MaterialRegistry::invalidIndex);
+          CHECK(scene.AddInstance(XMMatrixIdentity(), full).IsNull());
+          CHECK(scene.GetInstances().Size() == 0);
+          CHECK(!scene.AddInstance(XMMatrixIdentity(), MaterialRegistry::invalidIndex - 1).IsNull());
+     }
+}
+
+int main()
+{
+     TestPartialMatchesFullPass();
+     TestUnchangedFrameKeepsResult();
+     TestLodIdsMatchDrawMask();
+     TestSceneNodes();
+     TestAnimatedSceneNodes();
+     TestStaticInstances();
+     TestFullMaterialTable();
+     return TestResult("SceneTests");
+}
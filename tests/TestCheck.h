@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for headless tests. A failed check prints its location and makes the test fail
+inline int& TestFailures()
+{
+     static int failures = 0;
+     return failures;
+}
+
+#define CHECK(condition) \
+     do \
+     { \
+          if (!(condition)) \
+          { \
+               std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+               ++TestFailures(); \
+          } \
+     } while (0)
+
+// Function to report result of a test executable, returns its exit code
+inline int TestResult(const char* name)
+{
+     std::printf("%s: %s\n", name, TestFailures() ? "FAILED" : "passed");
+     return TestFailures() ? 1 : 0;
+}
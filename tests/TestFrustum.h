@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Frustum.h"
+
+#include <cmath>
+#include <random>
+
+// Function to build the frustum of a random camera with the renderer projection
+inline Frustum RandomFrustum(std::mt19937& rng, float range = 20.0f)
+{
+     std::uniform_real_distribution<float> coordinate(-range, range);
+     XMVECTOR eye = XMVectorSet(coordinate(rng), coordinate(rng), coordinate(rng), 1.0f);
+     XMVECTOR target = XMVectorSet(coordinate(rng), coordinate(rng), coordinate(rng), 1.0f);
+     XMMATRIX view = XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f);
+     Frustum frustum;
+     frustum.Init(0.1f);
+     frustum.ConstructFrustum(view, proj);
+     return frustum;
+}
+
+// Function to get the smallest signed distance of the farthest box point over all planes,
+// boxes with it close to zero touch a plane and may go either way with rounding
+inline float OutsideMargin(const Frustum& frustum, const XMFLOAT3& center, const XMFLOAT3& extent)
+{
+     float margin = INFINITY;
+     for (int i = 0; i < 6; i++)
+     {
+          XMFLOAT4 plane = frustum.GetPlane(i);
+          float dist = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+          float radius = fabsf(plane.x) * extent.x + fabsf(plane.y) * extent.y + fabsf(plane.z) * extent.z;
+          margin = std::fmin(margin, dist + radius);
+     }
+     return margin;
+}
+
+inline bool OnFrustumBoundary(const Frustum& frustum, const XMFLOAT3& center, const XMFLOAT3& extent)
+{
+     return fabsf(OutsideMargin(frustum, center, extent)) < 1e-3f;
+}
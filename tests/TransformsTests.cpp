@@ -0,0 +1,241 @@
+#include "TestCheck.h"
+#include "Transforms.h"
+
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+     // Smallest-three components take 10 bits over [-1/sqrt(2), 1/sqrt(2)], half a step is below 7e-4 and
+     // a rotated unit axis moves by at most a few steps. Half floats keep 11 significant bits
+     const float rotationTolerance = 4e-3f;
+     const float scaleTolerance = 1.0f / 2048.0f;
+
+     struct Transform
+     {
+          XMFLOAT3 scale;
+          XMFLOAT4 rotation;
+          XMFLOAT3 position;
+     };
+
+     XMMATRIX ToMatrix(const Transform& transform)
+     {
+          return XMMatrixMultiply(XMMatrixMultiply(XMMatrixScaling(transform.scale.x, transform.scale.y, transform.scale.z),
+               XMMatrixRotationQuaternion(XMLoadFloat4(&transform.rotation))),
+               XMMatrixTranslation(transform.position.x, transform.position.y, transform.position.z));
+     }
+
+     // Function to pack transforms, starting at an odd position so the tail of a SIMD group is used too
+     std::vector<PackedInstance> Pack(const std::vector<Transform>& input, std::vector<uint16_t>& materials)
+     {
+          const size_t begin = 3;
+          TransformsSoA transforms;
+          transforms.Resize(begin + input.size());
+          materials.resize(begin + input.size());
+          for (size_t i = 0; i < input.size(); ++i)
+          {
+               transforms.Set(begin + i, ToMatrix(input[i]));
+               materials[begin + i] = static_cast<uint16_t>(i * 7);
+          }
+          std::vector<PackedInstance> packed(input.size());
+          PackTransforms(transforms, materials.data(), begin, begin + input.size(), packed.data());
+          materials.erase(materials.begin(), materials.begin() + begin);
+          return packed;
+     }
+
+     // Function to check decoded transforms against originals
+     void CheckRoundTrip(const std::vector<Transform>& input)
+     {
+          std::vector<uint16_t> materials;
+          std::vector<PackedInstance> packed = Pack(input, materials);
+          float maxRotationError = 0.0f;
+          for (size_t i = 0; i < input.size(); ++i)
+          {
+               const Transform& transform = input[i];
+               CHECK(packed[i].material == materials[i]);
+               CHECK(packed[i].position.x == transform.position.x && packed[i].position.y == transform.position.y
+                    && packed[i].position.z == transform.position.z);
+
+               // Mirroring goes to z, so only scale magnitudes of x and y are kept as given.
+               float scale[3] = {
+                    PackedVector::XMConvertHalfToFloat(packed[i].scale[0]),
+                    PackedVector::XMConvertHalfToFloat(packed[i].scale[1]),
+                    PackedVector::XMConvertHalfToFloat(packed[i].scale[2])
+               };
+               const float given[3] = { transform.scale.x, transform.scale.y, transform.scale.z };
+               for (int c = 0; c < 3; c++)
+               {
+                    CHECK(std::fabs(std::fabs(scale[c]) - std::fabs(given[c])) <= scaleTolerance * std::fabs(given[c]));
+               }
+
+               // Rows of the rotation-scale part divided by their scale are unit axes, compare them directly.
+               XMFLOAT4X4 expected;
+               XMFLOAT4X4 decoded;
+               XMStoreFloat4x4(&expected, ToMatrix(transform));
+               XMStoreFloat4x4(&decoded, UnpackTransform(packed[i]));
+               for (int r = 0; r < 3; r++)
+               {
+                    for (int c = 0; c < 3; c++)
+                    {
+                         float error = std::fabs(decoded.m[r][c] - expected.m[r][c]) / std::fabs(given[r]);
+                         maxRotationError = std::max(maxRotationError, error);
+                    }
+               }
+               for (int c = 0; c < 3; c++)
+               {
+                    CHECK(decoded.m[3][c] == expected.m[3][c]);
+               }
+          }
+          CHECK(maxRotationError <= rotationTolerance);
+     }
+
+     XMFLOAT4 RandomQuaternion(std::mt19937& rng)
+     {
+          std::normal_distribution<float> normal(0.0f, 1.0f);
+          XMFLOAT4 q;
+          XMStoreFloat4(&q, XMQuaternionNormalize(XMVectorSet(normal(rng), normal(rng), normal(rng), normal(rng))));
+          return q;
+     }
+
+     XMFLOAT3 RandomAxis(std::mt19937& rng)
+     {
+          XMFLOAT4 q = RandomQuaternion(rng);
+          XMFLOAT3 axis;
+          XMStoreFloat3(&axis, XMVector3Normalize(XMVectorSet(q.x, q.y, q.z, 0.0f)));
+          return axis;
+     }
+
+     void TestRandomTransforms()
+     {
+          std::mt19937 rng(19);
+          std::uniform_real_distribution<float> scale(0.05f, 20.0f);
+          std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+          std::vector<Transform> input(10001);
+          for (Transform& transform : input)
+          {
+               transform.scale = XMFLOAT3(scale(rng), scale(rng), scale(rng));
+               transform.rotation = RandomQuaternion(rng);
+               transform.position = XMFLOAT3(position(rng), position(rng), position(rng));
+          }
+          CheckRoundTrip(input);
+     }
+
+     // Half turns have w = 0 and the dropped component is one of x, y, z. Near half turns have a tiny w
+     // of either sign, q and -q are the same rotation
+     void TestHalfTurns()
+     {
+          std::mt19937 rng(20);
+          std::vector<Transform> input;
+          const XMFLOAT3 axes[] = { XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f) };
+          for (const XMFLOAT3& axis : axes)
+          {
+               input.push_back(Transform{ XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT4(axis.x, axis.y, axis.z, 0.0f), XMFLOAT3(1.0f, 2.0f, 3.0f) });
+          }
+          for (int i = 0; i < 2000; i++)
+          {
+               XMFLOAT3 axis = RandomAxis(rng);
+               float angle = XM_PI + (i % 3 - 1) * 1e-3f * (i % 7);
+               XMFLOAT4 q;
+               XMStoreFloat4(&q, XMQuaternionRotationAxis(XMLoadFloat3(&axis), angle));
+               input.push_back(Transform{ XMFLOAT3(2.0f, 0.5f, 1.0f), q, XMFLOAT3(0.0f, 0.0f, 0.0f) });
+          }
+          CheckRoundTrip(input);
+     }
+
+     // Negative scales on any axis are a mirror, decoded transforms have to mirror the same way
+     void TestNegativeScale()
+     {
+          std::mt19937 rng(21);
+          std::uniform_real_distribution<float> scale(0.1f, 5.0f);
+          std::vector<Transform> input;
+          for (int i = 0; i < 3000; i++)
+          {
+               XMFLOAT3 s(scale(rng), scale(rng), scale(rng));
+               // Every sign combination, identity rotation included.
+               s.x = (i & 1) ? -s.x : s.x;
+               s.y = (i & 2) ? -s.y : s.y;
+               s.z = (i & 4) ? -s.z : s.z;
+               XMFLOAT4 q = i < 8 ? XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f) : RandomQuaternion(rng);
+               input.push_back(Transform{ s, q, XMFLOAT3(-4.0f, 5.0f, 6.0f) });
+          }
+          CheckRoundTrip(input);
+     }
+
+     // World boxes of rotated, scaled and mirrored transforms are the bounds of the eight transformed corners,
+     // only transforms set since the last update are recomputed
+     void TestWorldBounds()
+     {
+          std::mt19937 rng(9);
+          std::uniform_real_distribution<float> scale(0.1f, 8.0f);
+          std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+          const XMFLOAT3 localCenter(0.25f, -0.5f, 1.0f);
+          const XMFLOAT3 localExtent(0.5f, 1.5f, 0.75f);
+          const size_t count = 1001;
+          TransformsSoA transforms;
+          transforms.Resize(count);
+          std::vector<XMMATRIX> worlds(count);
+          for (size_t i = 0; i < count; ++i)
+          {
+               XMFLOAT3 given(scale(rng), scale(rng), i % 3 ? scale(rng) : -scale(rng));
+               XMFLOAT4 rotation = RandomQuaternion(rng);
+               XMMATRIX scaleRotation = XMMatrixMultiply(XMMatrixScaling(given.x, given.y, given.z),
+                    XMMatrixRotationQuaternion(XMLoadFloat4(&rotation)));
+               worlds[i] = XMMatrixMultiply(scaleRotation, XMMatrixTranslation(position(rng), position(rng), position(rng)));
+               transforms.Set(i, worlds[i]);
+          }
+
+          BoundsSoA bounds;
+          std::vector<uint32_t> updated;
+          UpdateWorldBounds(transforms, localCenter, localExtent, bounds, updated);
+          CHECK(updated.size() == count);
+          for (size_t i = 0; i < count; ++i)
+          {
+               XMVECTOR boxMin = XMVectorReplicate(INFINITY);
+               XMVECTOR boxMax = XMVectorReplicate(-INFINITY);
+               for (int corner = 0; corner < 8; corner++)
+               {
+                    XMVECTOR point = XMVectorSet(
+                         localCenter.x + ((corner & 1) ? localExtent.x : -localExtent.x),
+                         localCenter.y + ((corner & 2) ? localExtent.y : -localExtent.y),
+                         localCenter.z + ((corner & 4) ? localExtent.z : -localExtent.z), 1.0f);
+                    point = XMVector3Transform(point, worlds[i]);
+                    boxMin = XMVectorMin(boxMin, point);
+                    boxMax = XMVectorMax(boxMax, point);
+               }
+               XMFLOAT3 center;
+               XMFLOAT3 extent;
+               XMStoreFloat3(&center, XMVectorScale(XMVectorAdd(boxMin, boxMax), 0.5f));
+               XMStoreFloat3(&extent, XMVectorScale(XMVectorSubtract(boxMax, boxMin), 0.5f));
+               // Coordinates reach about a hundred, the two ways round differently in the last bits.
+               const float tolerance = 1e-3f;
+               CHECK(std::fabs(bounds.centerX[i] - center.x) < tolerance && std::fabs(bounds.centerY[i] - center.y) < tolerance
+                    && std::fabs(bounds.centerZ[i] - center.z) < tolerance);
+               CHECK(std::fabs(bounds.extentX[i] - extent.x) < tolerance && std::fabs(bounds.extentY[i] - extent.y) < tolerance
+                    && std::fabs(bounds.extentZ[i] - extent.z) < tolerance);
+          }
+
+          updated.clear();
+          UpdateWorldBounds(transforms, localCenter, localExtent, bounds, updated);
+          CHECK(updated.empty());
+          transforms.Set(7, XMMatrixTranslation(1.0f, 2.0f, 3.0f));
+          transforms.Set(1000, XMMatrixTranslation(-1.0f, -2.0f, -3.0f));
+          UpdateWorldBounds(transforms, localCenter, localExtent, bounds, updated);
+          CHECK(updated.size() == 2 && updated[0] == 7 && updated[1] == 1000);
+          CHECK(bounds.centerX[7] == 1.25f && bounds.extentY[7] == 1.5f);
+          CHECK(bounds.centerZ[1000] == -2.0f && bounds.extentX[1000] == 0.5f);
+     }
+}
+
+int main()
+{
+     TestRandomTransforms();
+     TestHalfTurns();
+     TestNegativeScale();
+     TestWorldBounds();
+     return TestResult("TransformsTests");
+}
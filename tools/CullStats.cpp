@@ -0,0 +1,88 @@
+#include "Camera.h"
+#include "DemoScene.h"
+#include "InstanceBatcher.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+     // Piece of the camera path, the camera is moved by the deltas every frame like Input does
+     struct PathSegment
+     {
+          unsigned frames;
+          float dPhi;
+          float dTheta;
+          float dR;
+     };
+
+     // Orbit inside the ring, back away, stand still while cubes animate, then swing into the first
+     // room of the portal level and look around
+     const PathSegment cameraPath[] = {
+          { 120, XM_2PI / 120, 0.0f, 0.0f },
+          { 60, 0.0f, -0.01f, 0.25f },
+          { 30, 0.0f, 0.0f, 0.0f },
+          { 60, -XM_PI / 60, -0.004f, 0.03f },
+          { 60, 0.01f, 0.0f, 0.0f },
+     };
+}
+
+// Usage: cullstats [every] [nocache], runs the demo scene along the recorded camera path and prints culling counters
+// of every n-th frame (default 10) and totals, nocache turns the per node plane cache off. Frustum counters need
+// FRUSTUM_STATS
+int main(int argc, char** argv)
+{
+     unsigned every = argc > 1 ? static_cast<unsigned>(std::max(1, std::atoi(argv[1]))) : 10;
+     bool planeCache = !(argc > 2 && std::strcmp(argv[2], "nocache") == 0);
+     const unsigned width = 1280;
+     const unsigned height = 720;
+
+     Scene scene;
+     BuildDemoScene(scene, InstanceBatcher::maxPageSize);
+     scene.LoadPvs("static.pvs");
+     scene.SetPlaneCache(planeCache);
+     Camera camera;
+     XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PI / 3, width / static_cast<float>(height), 100.0f, 0.1f);
+
+     if (!FRUSTUM_STATS)
+     {
+          std::printf("frustum counters are compiled out, configure with -DFRUSTUM_STATS=ON to get them\n");
+     }
+     std::printf("%6s %4s %6s %8s %6s %6s %9s %8s %10s %8s %8s\n", "frame", "full", "moved", "inFrust", "drawn", "calls",
+          "triangles", "boxes", "planeTests", "accepted", "rejected");
+
+     CullingStats totals;
+     size_t fullPasses = 0;
+     unsigned frame = 0;
+     for (const PathSegment& segment : cameraPath)
+     {
+          for (unsigned i = 0; i < segment.frames; ++i, ++frame)
+          {
+               camera.MoveCamera(segment.dPhi, segment.dTheta, segment.dR);
+               scene.Update(frame / 60.0f, camera.GetViewMatrix(), proj, camera.GetPosition(), camera.GetVersion(), height);
+
+               const CullingStats& stats = scene.GetCullingStats();
+               fullPasses += stats.fullPass ? 1 : 0;
+               totals.drawn += stats.drawn;
+               totals.triangles += stats.triangles;
+               totals.frustum += stats.frustum;
+               if (frame % every == 0)
+               {
+                    std::printf("%6u %4d %6zu %8zu %6zu %6zu %9zu %8llu %10llu %8llu %8llu\n", frame, stats.fullPass ? 1 : 0,
+                         stats.movedInstances, stats.inFrustum, stats.drawn, stats.drawCalls, stats.triangles,
+                         static_cast<unsigned long long>(stats.frustum.boxesTested), static_cast<unsigned long long>(stats.frustum.planeTests),
+                         static_cast<unsigned long long>(stats.frustum.accepted), static_cast<unsigned long long>(stats.frustum.rejected));
+               }
+          }
+     }
+
+     std::printf("%u frames, %zu full passes, %zu instances drawn, %zu triangles, %llu boxes tested, %llu plane tests, "
+          "plane cache %s\n", frame, fullPasses, totals.drawn, totals.triangles, static_cast<unsigned long long>(totals.frustum.boxesTested),
+          static_cast<unsigned long long>(totals.frustum.planeTests), planeCache ? "on" : "off");
+     return 0;
+}
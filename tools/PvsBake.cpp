@@ -0,0 +1,29 @@
+#include "DemoScene.h"
+#include "InstanceBatcher.h"
+#include "PvsTable.h"
+#include "Scene.h"
+
+#include <cstdio>
+
+// Usage: pvsbake [output], bakes visible sets of the demo scene into output or static.pvs.
+// The renderer loads static.pvs from its working directory at startup
+int main(int argc, char** argv)
+{
+     const char* path = argc > 1 ? argv[1] : "static.pvs";
+
+     Scene scene;
+     BuildDemoScene(scene, InstanceBatcher::maxPageSize);
+
+     PvsBakeSettings settings;
+     PvsTable table;
+     scene.BakePvs(settings, table);
+     if (!table.Save(path))
+     {
+          std::printf("failed to write %s\n", path);
+          return 1;
+     }
+
+     std::printf("%s: %zu instances, %zu cells, %zu bytes of sets\n", path, table.GetInstanceCount(), table.GetCellCount(),
+          table.GetDataSize());
+     return 0;
+}